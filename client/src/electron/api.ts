@@ -2,6 +2,7 @@ import { ipcMain, type IpcMainInvokeEvent } from "electron";
 import * as pdf from 'html-pdf';
 import * as fs from 'fs';
 import * as path from 'path';
+import { ResultChannelReader, type CellUpdate } from './resultChannel';
 
 ipcMain.handle(
   "node-version",
@@ -65,4 +66,21 @@ ipcMain.handle(
       throw error;
     }
   }
+);
+
+let resultChannel: ResultChannelReader | null = null;
+
+ipcMain.handle(
+  "open-result-channel",
+  (_event: IpcMainInvokeEvent, channelPath: string): void => {
+    resultChannel?.close();
+    resultChannel = new ResultChannelReader(channelPath);
+  }
+);
+
+ipcMain.handle(
+  "poll-result-channel",
+  (): CellUpdate[] | null => {
+    return resultChannel ? resultChannel.poll() : [];
+  }
 );
\ No newline at end of file
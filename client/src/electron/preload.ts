@@ -1,10 +1,15 @@
 import { contextBridge, ipcRenderer } from "electron";
+import type { CellUpdate } from "./resultChannel";
 
 export const backend = {
   nodeVersion: async (msg: string): Promise<string> =>
     await ipcRenderer.invoke("node-version", msg),
   exportTimetablePdf: async (html: string, filename: string): Promise<string> =>
     await ipcRenderer.invoke("export-timetable-pdf", { html, filename }),
+  openResultChannel: async (channelPath: string): Promise<void> =>
+    await ipcRenderer.invoke("open-result-channel", channelPath),
+  pollResultChannel: async (): Promise<CellUpdate[] | null> =>
+    await ipcRenderer.invoke("poll-result-channel"),
 };
 
 contextBridge.exposeInMainWorld("backend", backend);
\ No newline at end of file
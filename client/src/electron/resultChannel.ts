@@ -0,0 +1,148 @@
+import * as fs from "fs";
+
+/**
+ * Reader for the solver's shared-memory result channel (see
+ * core/TimetableGen/src/ResultChannel.hpp for the layout).
+ *
+ * Node cannot map memory itself, so the channel file is read with positioned
+ * reads. Only the header, the change bitmaps and the changed cells are read
+ * for each poll, which keeps an update proportional to what changed.
+ */
+
+const HEADER_SIZE = 64;
+const FRAME_HEADER_SIZE = 64;
+const NO_LESSON = 0xffff;
+
+export interface CellUpdate {
+  classId: number;
+  day: number;
+  period: number;
+  /** Lesson index, or -1 when the cell became free. */
+  lesson: number;
+}
+
+export class ResultChannelReader {
+  private fd: number;
+  private days: number;
+  private periodsPerDay: number;
+  private capacity: number;
+  private frameSize: number;
+  private cellCount: number;
+  private bitmapWords: number;
+  private lastSeen = 0n;
+
+  /**
+   * Open a channel file created by the solver
+   * @param path - Path of the mapped channel file
+   */
+  constructor(path: string) {
+    this.fd = fs.openSync(path, "r");
+
+    const header = this.read(0, HEADER_SIZE);
+    if (header.toString("latin1", 0, 4) !== "TWRC" || header.readUInt32LE(4) !== 1) {
+      fs.closeSync(this.fd);
+      throw new Error(`${path} is not a result channel`);
+    }
+
+    this.days = header.readUInt32LE(8);
+    this.periodsPerDay = header.readUInt32LE(12);
+    this.capacity = header.readUInt32LE(20);
+    this.frameSize = header.readUInt32LE(24);
+    this.cellCount = header.readUInt32LE(28);
+    this.bitmapWords = Math.ceil(this.cellCount / 64);
+  }
+
+  close(): void {
+    fs.closeSync(this.fd);
+  }
+
+  /**
+   * Return the cells that changed since the previous poll
+   * @returns The updates, or null if the solver was mid-write and the caller
+   *          should poll again
+   */
+  poll(): CellUpdate[] | null {
+    const latest = this.read(32, 8).readBigUInt64LE(0);
+    if (latest === this.lastSeen) {
+      return [];
+    }
+
+    const full =
+      this.lastSeen === 0n ||
+      this.lastSeen > latest ||
+      latest - this.lastSeen >= BigInt(this.capacity);
+
+    // Union of the change bitmaps of every version missed since the last poll
+    const changed = new Uint8Array(this.bitmapWords * 8);
+    if (full) {
+      changed.fill(0xff);
+    } else {
+      for (let v = this.lastSeen + 1n; v <= latest; v++) {
+        const offset = this.frameOffset(v);
+        const before = this.stamp(offset);
+        if (before !== 2n * v) {
+          return null;
+        }
+        const bitmap = this.read(offset + FRAME_HEADER_SIZE, changed.length);
+        for (let i = 0; i < changed.length; i++) {
+          changed[i] |= bitmap[i];
+        }
+        if (this.stamp(offset) !== before) {
+          return null;
+        }
+      }
+    }
+
+    const offset = this.frameOffset(latest);
+    const cellsOffset = offset + FRAME_HEADER_SIZE + this.bitmapWords * 8;
+    const before = this.stamp(offset);
+    if (before !== 2n * latest) {
+      return null;
+    }
+
+    const isChanged = (cell: number) => (changed[cell >> 3] & (1 << (cell & 7))) !== 0;
+    let first = 0;
+    let last = this.cellCount - 1;
+    while (first <= last && !isChanged(first)) first++;
+    while (last >= first && !isChanged(last)) last--;
+
+    // One read covering the span of changed cells
+    const span = first <= last ? this.read(cellsOffset + first * 2, (last - first + 1) * 2) : null;
+
+    const updates: CellUpdate[] = [];
+    const perClass = this.days * this.periodsPerDay;
+    for (let cell = first; span !== null && cell <= last; cell++) {
+      if (!isChanged(cell)) {
+        continue;
+      }
+      const lesson = span.readUInt16LE((cell - first) * 2);
+      updates.push({
+        classId: Math.floor(cell / perClass),
+        day: Math.floor(cell / this.periodsPerDay) % this.days,
+        period: cell % this.periodsPerDay,
+        lesson: lesson === NO_LESSON ? -1 : lesson,
+      });
+    }
+
+    if (this.stamp(offset) !== before) {
+      return null;
+    }
+
+    this.lastSeen = latest;
+    return updates;
+  }
+
+  private frameOffset(version: bigint): number {
+    return HEADER_SIZE + Number((version - 1n) % BigInt(this.capacity)) * this.frameSize;
+  }
+
+  private stamp(frameOffset: number): bigint {
+    return this.read(frameOffset, 8).readBigUInt64LE(0);
+  }
+
+  private read(position: number, length: number): Buffer {
+    const buffer = Buffer.alloc(length);
+    fs.readSync(this.fd, buffer, 0, length, position);
+    return buffer;
+  }
+}
@@ -0,0 +1,95 @@
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+
+#include "BitsetSolver.hpp"
+#include "DomainPropagator.hpp"
+#include "InstanceGenerator.hpp"
+#include "RequestArena.hpp"
+
+// Resident memory of a long-running solver process over many requests.
+//
+// Every request generates a school of random size, propagates its lesson
+// domains and, when it is small enough, solves it with the bitset search.
+// A few configs are kept around the way a cache would, so long-lived
+// blocks sit between the short-lived ones on the heap. With --arena 1 the
+// request's indexes and scratch come from a request arena; with --trim 1
+// a HeapTrimmer returns free heap pages periodically. RSS is printed as
+// the soak goes on and should stay flat once the first requests warmed up.
+//
+// Usage: ArenaSoak [--requests N] [--arena 0|1] [--trim 0|1] [--seed N]
+using namespace TimetableWeaver;
+
+static int Serve(const TimetableConfig &config)
+{
+  DomainPropagator propagator(config);
+  if (!propagator.Propagate()) {
+    return 0;
+  }
+  if (BitsetSolver::CanSolve(config)) {
+    BitsetSolver bitset;
+    Schedule     schedule;
+    bitset.Solve(config, schedule);
+  }
+  return propagator.GetRounds();
+}
+
+int main(int argc, char *argv[])
+{
+  int      requests = 5000;
+  bool     useArena = true;
+  bool     trim     = true;
+  uint32_t seed     = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--requests") == 0) {
+      requests = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--arena") == 0) {
+      useArena = std::atoi(argv[i + 1]) != 0;
+    } else if (std::strcmp(argv[i], "--trim") == 0) {
+      trim = std::atoi(argv[i + 1]) != 0;
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+    }
+  }
+
+  std::mt19937                random(seed);
+  std::deque<TimetableConfig> retained;
+  HeapTrimmer                 trimmer;
+  int64_t                     rounds = 0;
+
+  for (int r = 1; r <= requests; ++r) {
+    GeneratorParams params;
+    params.classes  = 1 + static_cast<int>(random() % 60);
+    params.teachers = params.classes * 3 / 2 + 1;
+    params.seed     = static_cast<uint32_t>(random());
+
+    TimetableConfig config = GenerateInstance(params);
+    if (useArena) {
+      RequestArena arena;
+      RequestScope scope(arena);
+      rounds += Serve(config);
+    } else {
+      rounds += Serve(config);
+    }
+
+    if (r % 50 == 0) {
+      retained.push_back(std::move(config));
+      if (retained.size() > 20) {
+        retained.pop_front();
+      }
+    }
+    if (trim) {
+      trimmer.OnRequestDone();
+    }
+    if (r % (requests / 10 > 0 ? requests / 10 : 1) == 0) {
+      std::cout << "After " << r << " requests: ";
+      PrintHeapReport(std::cout, GetHeapReport());
+    }
+  }
+  std::cout << "Propagation rounds " << rounds << ", trims "
+            << trimmer.GetTrimCount() << ", released "
+            << trimmer.GetReleasedBytes() / (1024.0 * 1024.0) << " MB\n";
+  return 0;
+}
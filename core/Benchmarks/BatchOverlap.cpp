@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BatchPipeline.hpp"
+#include "InstanceGenerator.hpp"
+#include "ScheduleArchive.hpp"
+
+// Wall time of a batch of schools, run one after another and through the
+// overlapped pipeline.
+//
+// Each school is a generated instance. The publish stage checks that every
+// lesson got its weekly periods without a class or teacher clash and
+// appends the schedule to an archive per school in the output directory.
+// Both runs solve the same schools, so their summed solve times match and
+// the overlapped wall time can be read against them.
+//
+// Usage: BatchOverlap [--schools N] [--time-limit seconds] [--solvers N]
+//                     [--out dir]
+using namespace TimetableWeaver;
+
+static bool IsValid(const TimetableConfig &config, const Schedule &schedule)
+{
+  const int         slots = config.days * config.periodsPerDay;
+  std::vector<int>  placed(config.lessons.size(), 0);
+  std::vector<bool> classBusy(config.classes.size() * slots, false);
+  std::vector<bool> teacherBusy(config.teachers.size() * slots, false);
+  for (const auto &entry : schedule.GetEntries()) {
+    const int slot = entry.day * config.periodsPerDay + entry.period;
+    if (classBusy[entry.classId * slots + slot] ||
+        teacherBusy[entry.teacherId * slots + slot]) {
+      return false;
+    }
+    classBusy[entry.classId * slots + slot]     = true;
+    teacherBusy[entry.teacherId * slots + slot] = true;
+    ++placed[entry.lesson];
+  }
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    if (placed[i] != config.lessons[i]->GetPeriodsPerWeek()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void Print(const char *name, const BatchReport &report)
+{
+  std::cout << name << ": " << report.solved << "/" << report.jobs
+            << " solved, " << report.failed << " failed, wall "
+            << report.wallSeconds << " s; stage sums: load "
+            << report.total.load << " s, build " << report.total.build
+            << " s, solve " << report.total.solve << " s, publish "
+            << report.total.publish << " s\n";
+}
+
+int main(int argc, char *argv[])
+{
+  int         schools   = 12;
+  double      timeLimit = 5.0;
+  int         solvers   = 1;
+  std::string out       = ".";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--schools") == 0) {
+      schools = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--time-limit") == 0) {
+      timeLimit = std::atof(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--solvers") == 0) {
+      solvers = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--out") == 0) {
+      out = argv[i + 1];
+    }
+  }
+
+  auto backend = LoadSolverBackend();
+  if (!backend) {
+    std::cerr << "Could not load the solver backend.\n";
+    return 1;
+  }
+
+  BatchStages stages;
+  stages.load = [](BatchJob &job) {
+    GeneratorParams params;
+    params.classes  = 8 + job.index % 5 * 2;
+    params.teachers = params.classes * 3 / 2;
+    params.seed     = static_cast<uint32_t>(job.index + 1);
+    job.name        = "school-" + std::to_string(job.index);
+    job.config      = GenerateInstance(params);
+    return true;
+  };
+  stages.publish = [&](BatchJob &job) {
+    if (!job.solved) {
+      std::cerr << job.name << ": no schedule\n";
+      return;
+    }
+    if (!IsValid(job.config, job.schedule)) {
+      std::cerr << job.name << ": invalid schedule\n";
+      return;
+    }
+    ScheduleArchiveWriter archive;
+    if (archive.Open(out + "/" + job.name + ".archive", job.config.days,
+                     job.config.periodsPerDay)) {
+      archive.Append(job.schedule);
+    }
+  };
+
+  BatchOptions options;
+  options.solveThreads           = solvers;
+  options.solve.timeLimitSeconds = timeLimit;
+
+  options.overlap = false;
+  Print("Sequential", BatchPipeline(backend, stages, options).Run(schools));
+
+  options.overlap = true;
+  Print("Overlapped", BatchPipeline(backend, stages, options).Run(schools));
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CalendarExport.hpp"
+#include "InstanceGenerator.hpp"
+
+// Time to produce the calendar feeds of a whole district.
+//
+// Every school is a generated instance whose lessons are laid out class by
+// class into consecutive free slots; teachers may clash, which does not
+// matter for export. Each school gets a term from September to June with
+// autumn, winter and spring holidays and an exam week, and the iCalendar
+// and CSV feeds of all its classes and teachers are written to the output
+// directory, which must exist, with the school in the file names.
+//
+// Usage: CalendarFeeds [--schools N] [--classes N] [--threads N] [--out dir]
+using namespace TimetableWeaver;
+
+static Schedule LayOut(const TimetableConfig &config)
+{
+  const int        slots = config.days * config.periodsPerDay;
+  std::vector<int> next(config.classes.size(), 0);
+  Schedule         schedule(config.days, config.periodsPerDay,
+                            static_cast<int>(config.classes.size()),
+                            static_cast<int>(config.teachers.size()));
+  const LessonIds  ids = config.GetLessonIds();
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    const auto &lesson  = config.lessons[i];
+    const int   classId = ids.classes[i];
+    for (int k = 0; k < lesson->GetPeriodsPerWeek(); ++k) {
+      const int       slot = next[classId]++ % slots;
+      ScheduledLesson entry;
+      entry.lesson    = static_cast<int>(i);
+      entry.classId   = classId;
+      entry.teacherId = ids.teachers[i];
+      entry.subjectId = ids.subjects[i];
+      entry.day       = slot / config.periodsPerDay;
+      entry.period    = slot % config.periodsPerDay;
+      schedule.Add(entry);
+    }
+  }
+  return schedule;
+}
+
+int main(int argc, char *argv[])
+{
+  int         schools = 50;
+  int         classes = 30;
+  int         threads = 0;
+  std::string out     = ".";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--schools") == 0) {
+      schools = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--classes") == 0) {
+      classes = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--threads") == 0) {
+      threads = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--out") == 0) {
+      out = argv[i + 1];
+    }
+  }
+
+  FeedOptions options;
+  options.threads  = threads;
+  options.timeZone = FeedTimeZone::European("Europe/Vienna", 60);
+
+  FeedReport total;
+  for (int s = 0; s < schools; ++s) {
+    GeneratorParams params;
+    params.classes  = classes;
+    params.teachers = classes * 3 / 2;
+    params.seed     = static_cast<uint32_t>(s + 1);
+
+    TimetableConfig config   = GenerateInstance(params);
+    Schedule        schedule = LayOut(config);
+    TermCalendar    calendar(schedule, {2025, 9, 1}, {2026, 6, 30});
+    calendar.AddHoliday({2025, 10, 27}, {2025, 10, 31});
+    calendar.AddHoliday({2025, 12, 22}, {2026, 1, 6});
+    calendar.AddHoliday({2026, 3, 30}, {2026, 4, 10});
+    calendar.AddExamWeek({2026, 6, 15}, {2026, 6, 19});
+
+    options.uidDomain  = "school-" + std::to_string(s);
+    options.filePrefix = options.uidDomain + "-";
+    CalendarExporter exporter(config, calendar, options);
+    const FeedReport report =
+        exporter.ExportAll(out, {FeedFormat::ICalendar, FeedFormat::Csv});
+    total.files += report.files;
+    total.failed += report.failed;
+    total.events += report.events;
+    total.bytes += report.bytes;
+    total.seconds += report.seconds;
+  }
+
+  std::cout << total.files << " feeds (" << total.failed << " failed), "
+            << total.events << " events, " << total.bytes / (1024.0 * 1024.0)
+            << " MB in " << total.seconds << " s, "
+            << total.events / total.seconds << " events/s\n";
+  return total.failed == 0 ? 0 : 1;
+}
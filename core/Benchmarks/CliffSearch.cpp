@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "InstanceGenerator.hpp"
+#include "SolverBackend.hpp"
+
+// Searches for instances on which a formulation is slow.
+//
+// An evolutionary search over the generator parameters: every generation
+// keeps the slowest instances and breeds children from them, either by
+// jittering the parameters or by applying small edits to the parent's
+// config. Solves are capped at the time limit, so a capped instance is the
+// strongest cliff the search can report. The slowest instances are written
+// as JSON together with their parameters, edit lineage and feature vectors,
+// which is enough to regenerate each one.
+//
+// Usage: CliffSearch [--formulation slot-boolean|slot-integer|pattern]
+//                    [--generations N] [--population N] [--keep N]
+//                    [--time-limit seconds] [--seed N] [--out file]
+using namespace TimetableWeaver;
+
+// One round of edits, replayed with its own seed on top of the rounds
+// before it.
+struct MutationStep {
+  uint32_t seed  = 0;
+  int      count = 0;
+
+  bool operator==(const MutationStep &other) const
+  {
+    return seed == other.seed && count == other.count;
+  }
+};
+
+struct Candidate {
+  GeneratorParams           params;
+  std::vector<MutationStep> lineage; // Oldest edits first
+
+  double           seconds  = 0.0;
+  bool             solved   = false;
+  bool             timedOut = false;
+  InstanceFeatures features;
+};
+
+static TimetableConfig BuildConfig(const Candidate &candidate)
+{
+  TimetableConfig config = GenerateInstance(candidate.params);
+  for (const MutationStep &step : candidate.lineage) {
+    std::mt19937 random(step.seed);
+    MutateInstance(config, random, step.count);
+  }
+  return config;
+}
+
+static GeneratorParams RandomParams(std::mt19937 &random)
+{
+  auto pick = [&](int low, int high) {
+    return std::uniform_int_distribution<int>(low, high)(random);
+  };
+  auto share = [&](double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(random);
+  };
+
+  GeneratorParams params;
+  params.days                = pick(5, 6);
+  params.periodsPerDay       = pick(6, 10);
+  params.classes             = pick(2, 30);
+  params.teachers            = pick(params.classes, params.classes * 2 + 2);
+  params.subjects            = pick(4, 12);
+  params.minPeriodsPerLesson = 1;
+  params.maxPeriodsPerLesson = pick(2, 6);
+  params.classFill           = share(0.5, 1.0);
+  params.teacherAvailability = share(0.5, 1.0);
+  params.maxConsecutive      = pick(0, 1) ? pick(3, 5) : 0;
+  params.maxPerDay           = pick(0, 1) ? pick(4, 8) : 0;
+  params.noGaps              = pick(0, 3) == 0;
+  params.spreadShare         = pick(0, 1) ? share(0.2, 0.8) : 0.0;
+  params.seed                = random();
+  return params;
+}
+
+static GeneratorParams JitterParams(GeneratorParams params,
+                                    std::mt19937   &random)
+{
+  auto step = [&](int value, int low, int high) {
+    value += std::uniform_int_distribution<int>(-2, 2)(random);
+    return std::clamp(value, low, high);
+  };
+  auto nudge = [&](double value) {
+    value += std::normal_distribution<double>(0.0, 0.05)(random);
+    return std::clamp(value, 0.3, 1.0);
+  };
+
+  params.periodsPerDay       = step(params.periodsPerDay, 4, 12);
+  params.classes             = step(params.classes, 1, 60);
+  params.teachers            = step(params.teachers, 1, 120);
+  params.maxPeriodsPerLesson = step(params.maxPeriodsPerLesson, 1, 8);
+  params.classFill           = nudge(params.classFill);
+  params.teacherAvailability = nudge(params.teacherAvailability);
+  params.seed                = random();
+  return params;
+}
+
+static void Evaluate(Candidate &candidate, SolverBackend &backend,
+                     Formulation formulation, double timeLimit)
+{
+  TimetableConfig config = BuildConfig(candidate);
+  if (formulation != Formulation::Pattern) {
+    config.spreads.clear(); // Only the pattern formulation models them
+  }
+  if (formulation == Formulation::SlotInteger) {
+    config.rules.clear(); // Not expressible in this formulation
+  }
+
+  SolveOptions options;
+  options.formulation      = formulation;
+  options.timeLimitSeconds = timeLimit;
+
+  Schedule   schedule;
+  const auto start = std::chrono::steady_clock::now();
+  candidate.solved = backend.Solve(config, schedule, options);
+  candidate.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  candidate.timedOut = candidate.seconds >= timeLimit * 0.99;
+  candidate.features = ComputeFeatures(config);
+}
+
+static void WriteCatalogue(std::ostream &stream, Formulation formulation,
+                           double timeLimit,
+                           const std::vector<Candidate> &worst)
+{
+  stream << "{\n  \"formulation\": \"" << GetFormulationName(formulation)
+         << "\",\n  \"timeLimitSeconds\": " << timeLimit
+         << ",\n  \"instances\": [";
+  for (size_t i = 0; i < worst.size(); ++i) {
+    const Candidate       &c = worst[i];
+    const GeneratorParams &p = c.params;
+    stream << (i == 0 ? "\n" : ",\n") << "    {\"seconds\": " << c.seconds
+           << ", \"solved\": " << (c.solved ? "true" : "false")
+           << ", \"timedOut\": " << (c.timedOut ? "true" : "false")
+           << ",\n     \"params\": {\"days\": " << p.days
+           << ", \"periodsPerDay\": " << p.periodsPerDay
+           << ", \"classes\": " << p.classes << ", \"teachers\": " << p.teachers
+           << ", \"subjects\": " << p.subjects
+           << ", \"minPeriodsPerLesson\": " << p.minPeriodsPerLesson
+           << ", \"maxPeriodsPerLesson\": " << p.maxPeriodsPerLesson
+           << ", \"classFill\": " << p.classFill
+           << ", \"teacherAvailability\": " << p.teacherAvailability
+           << ", \"maxConsecutive\": " << p.maxConsecutive
+           << ", \"maxPerDay\": " << p.maxPerDay
+           << ", \"noGaps\": " << (p.noGaps ? "true" : "false")
+           << ", \"spreadShare\": " << p.spreadShare
+           << ", \"seed\": " << p.seed << "},\n     \"lineage\": [";
+    for (size_t s = 0; s < c.lineage.size(); ++s) {
+      stream << (s == 0 ? "" : ", ") << "{\"seed\": " << c.lineage[s].seed
+             << ", \"count\": " << c.lineage[s].count << "}";
+    }
+    stream << "],\n     \"features\": {";
+    for (size_t f = 0; f < c.features.size(); ++f) {
+      stream << (f == 0 ? "" : ", ") << "\"" << c.features[f].first
+             << "\": " << c.features[f].second;
+    }
+    stream << "}}";
+  }
+  stream << "\n  ]\n}\n";
+}
+
+int main(int argc, char *argv[])
+{
+  Formulation formulation = Formulation::SlotBoolean;
+  int         generations = 10;
+  int         population  = 16;
+  int         keep        = 10;
+  double      timeLimit   = 30.0;
+  uint32_t    seed        = 1;
+  std::string outPath     = "cliffs.json";
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const char *value = argv[i + 1];
+    if (std::strcmp(argv[i], "--formulation") == 0) {
+      if (std::strcmp(value, "pattern") == 0) {
+        formulation = Formulation::Pattern;
+      } else if (std::strcmp(value, "slot-integer") == 0) {
+        formulation = Formulation::SlotInteger;
+      } else {
+        formulation = Formulation::SlotBoolean;
+      }
+    } else if (std::strcmp(argv[i], "--generations") == 0) {
+      generations = std::atoi(value);
+    } else if (std::strcmp(argv[i], "--population") == 0) {
+      population = std::atoi(value);
+    } else if (std::strcmp(argv[i], "--keep") == 0) {
+      keep = std::atoi(value);
+    } else if (std::strcmp(argv[i], "--time-limit") == 0) {
+      timeLimit = std::atof(value);
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = static_cast<uint32_t>(std::atoi(value));
+    } else if (std::strcmp(argv[i], "--out") == 0) {
+      outPath = value;
+    }
+  }
+  if (population < 2 || keep < 1 || timeLimit <= 0.0) {
+    std::cerr << "Population, keep and time limit must be positive\n";
+    return 1;
+  }
+
+  auto backend = LoadSolverBackend();
+  if (!backend) {
+    std::cerr << "Could not load the solver backend.\n";
+    return 1;
+  }
+
+  std::mt19937 random(seed);
+  auto         slowest = [](const Candidate &a, const Candidate &b) {
+    return a.seconds > b.seconds;
+  };
+
+  std::vector<Candidate> survivors;
+  std::vector<Candidate> worst;
+
+  for (int generation = 0; generation < generations; ++generation) {
+    std::vector<Candidate> batch;
+    for (int i = 0; i < population; ++i) {
+      Candidate child;
+      if (survivors.empty()) {
+        child.params = RandomParams(random);
+      } else {
+        const Candidate &parent =
+            survivors[random() % std::min<size_t>(survivors.size(), 4)];
+        if (random() % 2 == 0) {
+          child.params = JitterParams(parent.params, random);
+        } else {
+          MutationStep step;
+          step.seed  = random();
+          step.count = 1 + random() % 4;
+
+          child.params  = parent.params;
+          child.lineage = parent.lineage;
+          child.lineage.push_back(step);
+        }
+      }
+      Evaluate(child, *backend, formulation, timeLimit);
+      batch.push_back(std::move(child));
+    }
+
+    // Survivors are this generation's slowest plus the best so far.
+    batch.insert(batch.end(), survivors.begin(), survivors.end());
+    std::sort(batch.begin(), batch.end(), slowest);
+    batch.resize(std::min<size_t>(batch.size(), population / 2));
+    survivors = batch;
+
+    worst.insert(worst.end(), batch.begin(), batch.end());
+    std::sort(worst.begin(), worst.end(), slowest);
+    worst.erase(std::unique(worst.begin(), worst.end(),
+                            [](const Candidate &a, const Candidate &b) {
+                              return a.params.seed == b.params.seed &&
+                                     a.lineage == b.lineage;
+                            }),
+                worst.end());
+    worst.resize(std::min<size_t>(worst.size(), keep));
+
+    std::cout << "Generation " << generation << ": slowest "
+              << worst.front().seconds << " s\n";
+  }
+
+  std::ofstream stream(outPath);
+  if (!stream) {
+    std::cerr << "Could not write " << outPath << "\n";
+    return 1;
+  }
+  WriteCatalogue(stream, formulation, timeLimit, worst);
+  std::cout << "Wrote " << worst.size() << " instances to " << outPath << "\n";
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Schedule.hpp"
+#include "ScheduleEvaluator.hpp"
+#include "SolverBackend.hpp"
+
+// Cold-start cost of the core library against loading the solver backend.
+//
+// The benchmark re-runs itself as a child process so every sample pays for
+// process creation, dynamic linking and static initialisation:
+//   core     builds and scores a schedule using only the core library
+//   backend  does the same and then loads the OR-tools backend module
+static int RunChild(const char *mode)
+{
+  using namespace TimetableWeaver;
+
+  Schedule schedule(5, 6, 2, 2);
+  schedule.Add({0, 0, 0, 0, 0, 0});
+  schedule.Add({1, 1, 1, 1, 0, 0});
+  ScheduleEvaluator evaluator(schedule);
+  if (evaluator.GetScore() < 0) {
+    return 1;
+  }
+
+  if (std::strcmp(mode, "backend") == 0) {
+    if (!LoadSolverBackend()) {
+      std::cerr << "Could not load the solver backend.\n";
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static double TimeChildren(const std::string &command, int runs)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; ++i) {
+    if (std::system(command.c_str()) != 0) {
+      return -1.0;
+    }
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc >= 3 && std::strcmp(argv[1], "--child") == 0) {
+    return RunChild(argv[2]);
+  }
+
+  const int runs = argc >= 2 ? std::atoi(argv[1]) : 20;
+  if (runs <= 0) {
+    std::cerr << "Usage: " << argv[0] << " [runs]\n";
+    return 1;
+  }
+
+  const std::string self = std::string("\"") + argv[0] + "\" --child ";
+
+  // Warm the page cache so the first mode is not penalised.
+  TimeChildren(self + "backend", 1);
+
+  const double core    = TimeChildren(self + "core", runs);
+  const double backend = TimeChildren(self + "backend", runs);
+  if (core < 0.0 || backend < 0.0) {
+    std::cerr << "A child process failed.\n";
+    return 1;
+  }
+
+  std::cout << "Cold start over " << runs << " runs:\n";
+  std::cout << "  core only:    " << core << " ms\n";
+  std::cout << "  with backend: " << backend << " ms\n";
+  std::cout << "  backend load: " << backend - core << " ms\n";
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ColumnarExport.hpp"
+
+// Export and scan throughput of the columnar lesson format.
+//
+// Writes random schedules for many schools, one school at a time, then
+// runs three aggregations over the mapped file the way the analytics jobs
+// do: teacher utilisation per daily load, the distribution of teachers'
+// free periods, and per period how often a class has a subject more than
+// once that day. Only the columns a query needs are touched.
+//
+// Usage: ColumnarScan [--schools N] [--classes N] [--seed N] [--out file]
+using namespace TimetableWeaver;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, char *argv[])
+{
+  int         schools = 5000;
+  int         classes = 40;
+  uint32_t    seed    = 1;
+  std::string path    = "lessons.columnar";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--schools") == 0) {
+      schools = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--classes") == 0) {
+      classes = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--out") == 0) {
+      path = argv[i + 1];
+    }
+  }
+
+  const int days     = 5;
+  const int periods  = 8;
+  const int teachers = classes * 3 / 2;
+  const int subjects = 12;
+
+  std::mt19937   random(seed);
+  ColumnarWriter writer;
+  if (!writer.Open(path)) {
+    return 1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int s = 0; s < schools; ++s) {
+    Schedule schedule(days, periods, classes, teachers);
+    for (int c = 0; c < classes; ++c) {
+      for (int slot = 0; slot < days * periods; ++slot) {
+        if (random() % 10 == 0) {
+          continue;
+        }
+        ScheduledLesson entry;
+        entry.lesson    = c * days * periods + slot;
+        entry.classId   = c;
+        entry.teacherId = (c + slot * 7 + s) % teachers;
+        entry.subjectId = static_cast<int>(random() % subjects);
+        entry.day       = slot / periods;
+        entry.period    = slot % periods;
+        schedule.Add(entry);
+      }
+    }
+    if (!writer.Append("school-" + std::to_string(s), schedule)) {
+      std::cerr << "Write failed\n";
+      return 1;
+    }
+  }
+  if (!writer.Close()) {
+    std::cerr << "Write failed\n";
+    return 1;
+  }
+  std::cout << "Exported " << writer.GetRowCount() << " rows of " << schools
+            << " schools in " << SecondsSince(start) << " s\n";
+
+  ColumnarReader reader;
+  if (!reader.Open(path)) {
+    std::cerr << "Cannot read " << path << "\n";
+    return 1;
+  }
+  const int loadColumn    = reader.FindColumn("teacher_day_load");
+  const int gapColumn     = reader.FindColumn("teacher_day_gaps");
+  const int periodColumn  = reader.FindColumn("period");
+  const int subjectColumn = reader.FindColumn("subject_day_count");
+
+  start = std::chrono::steady_clock::now();
+  std::vector<uint64_t> loads(33, 0), gaps(33, 0), repeats(32, 0);
+  for (int g = 0; g < reader.GetGroupCount(); ++g) {
+    const uint32_t rows   = reader.GetGroupRows(g);
+    const uint8_t *load   = reader.GetChunk<uint8_t>(g, loadColumn);
+    const uint8_t *gap    = reader.GetChunk<uint8_t>(g, gapColumn);
+    const uint8_t *period = reader.GetChunk<uint8_t>(g, periodColumn);
+    const uint8_t *count  = reader.GetChunk<uint8_t>(g, subjectColumn);
+    for (uint32_t r = 0; r < rows; ++r) {
+      ++loads[load[r] & 31];
+      ++gaps[gap[r] & 31];
+      repeats[period[r] & 31] += count[r] > 1;
+    }
+  }
+  const double seconds = SecondsSince(start);
+  std::cout << "Scanned " << reader.GetRowCount() << " rows in " << seconds
+            << " s (" << reader.GetRowCount() / seconds / 1e6
+            << " M rows/s)\n";
+
+  std::cout << "Lesson periods by teacher daily load:";
+  for (int k = 0; k <= periods; ++k) {
+    std::cout << " " << k << ":" << loads[k];
+  }
+  std::cout << "\nLesson periods by teacher daily gaps:";
+  for (int k = 0; k < periods; ++k) {
+    std::cout << " " << k << ":" << gaps[k];
+  }
+  std::cout << "\nRepeated subjects per period:";
+  for (int k = 0; k < periods; ++k) {
+    std::cout << " " << k << ":" << repeats[k];
+  }
+  std::cout << "\n";
+  return 0;
+}
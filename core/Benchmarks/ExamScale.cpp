@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ExamTimetable.hpp"
+
+// Exam timetabling on large random sessions.
+//
+// Every exam is sat by one to three random student groups, none of which
+// gets more exams than the minimum spacing lets it sit; rooms and
+// invigilators are sized so each slot can hold a fifth more than its share
+// of exams, and a few of each are unavailable for a random day. Prints the
+// coloring time and spacing penalty, then the penalty after the CP-SAT
+// refinement when a budget is given.
+//
+// Usage: ExamScale [--exams N] [--groups N] [--refine seconds] [--seed N]
+using namespace TimetableWeaver;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, char *argv[])
+{
+  int      numExams  = 3000;
+  int      numGroups = 1500;
+  double   refine    = 0.0;
+  uint32_t seed      = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--exams") == 0) {
+      numExams = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--groups") == 0) {
+      numGroups = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--refine") == 0) {
+      refine = std::atof(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+    }
+  }
+
+  std::mt19937 random(seed);
+  auto         pick = [&](int low, int high) {
+    return std::uniform_int_distribution<int>(low, high)(random);
+  };
+
+  ExamConfig config;
+  config.days             = 6;
+  config.periodsPerDay    = 4;
+  config.minSpacing       = 2;
+  config.preferredSpacing = 4;
+
+  const int slots        = config.GetSlotCount();
+  auto      availability = [&](bool partial) {
+    Availability result(config.days, config.periodsPerDay);
+    for (int d = 0; d < config.days; ++d) {
+      result.SetDay(d, true);
+    }
+    if (partial) {
+      result.SetDay(pick(0, config.days - 1), false);
+    }
+    return result;
+  };
+
+  const int maxLoad = (slots + config.minSpacing - 1) / config.minSpacing;
+  std::vector<int> groupSizes(numGroups), groupLoads(numGroups, 0);
+  for (int g = 0; g < numGroups; ++g) {
+    config.groups.emplace_back("G" + std::to_string(g), availability(false));
+    groupSizes[g] = pick(10, 40);
+  }
+
+  int largest = 0;
+  for (int e = 0; e < numExams; ++e) {
+    Exam exam;
+    exam.name        = "E" + std::to_string(e);
+    const int groups = pick(1, 3);
+    while (static_cast<int>(exam.groups.size()) < groups) {
+      const int g = pick(0, numGroups - 1);
+      if (groupLoads[g] < maxLoad &&
+          std::find(exam.groups.begin(), exam.groups.end(), g) ==
+              exam.groups.end()) {
+        ++groupLoads[g];
+        exam.groups.push_back(g);
+        exam.students += groupSizes[g];
+      }
+    }
+    largest = std::max(largest, exam.students);
+    config.exams.push_back(exam);
+  }
+
+  const int perSlot = (numExams * 6 / 5 + slots - 1) / slots;
+  for (int r = 0; r < perSlot * 11 / 10; ++r) {
+    // Capacities spread up to the largest exam so every exam has a room.
+    const int capacity = r % 4 == 0 ? largest : pick(40, largest);
+    config.rooms.emplace_back("R" + std::to_string(r), capacity,
+                              availability(r % 10 == 0));
+  }
+  for (int i = 0; i < perSlot * 11 / 10; ++i) {
+    config.invigilators.emplace_back("I" + std::to_string(i),
+                                     availability(i % 10 == 0));
+  }
+
+  const auto    start = std::chrono::steady_clock::now();
+  ConflictGraph graph = config.BuildConflictGraph();
+  ExamColoring  coloring(config, graph);
+  const bool    colored = coloring.Color();
+  const double  seconds = SecondsSince(start);
+
+  std::cout << numExams << " exams, " << numGroups << " groups, "
+            << graph.GetEdgeCount() << " conflict edges, "
+            << config.rooms.size() << " rooms\n";
+  std::cout << "Coloring: " << (colored ? "clash free" : "failed") << " in "
+            << seconds << " s, " << coloring.GetInitialConflicts()
+            << " DSatur clashes, " << coloring.GetIterations()
+            << " tabu moves, penalty "
+            << GetSpacingPenalty(config, coloring.GetSchedule()) << "\n";
+  if (!colored || refine <= 0.0) {
+    return colored ? 0 : 1;
+  }
+
+  ExamOptions options;
+  options.refineSeconds = refine;
+
+  ExamTimetable timetable(config);
+  const auto    refineStart = std::chrono::steady_clock::now();
+  if (!timetable.Generate(options)) {
+    return 1;
+  }
+  std::cout << "Refined: penalty " << timetable.GetInitialPenalty() << " -> "
+            << timetable.GetPenalty() << " in " << SecondsSince(refineStart)
+            << " s\n";
+  return 0;
+}
@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#include "BitsetSolver.hpp"
+#include "BoundedQueue.hpp"
+#include "CpuPlacement.hpp"
+#include "InstanceGenerator.hpp"
+#include "Metrics.hpp"
+
+// Latency percentiles of a solver host under concurrent "generate"
+// requests, for capacity planning.
+//
+// Requests replay a mix of small interactive schools and large ones and
+// are served the way the host serves a generate click: tiny configs by the
+// bitset search, everything else by the CP-SAT backend. In closed-loop
+// mode `--concurrency` clients each send their next request as soon as the
+// previous one returned. In open-loop mode requests arrive as a Poisson
+// stream at `--rate` per second whatever the host's state, and queue for
+// `--concurrency` solver slots, so the latencies include the queueing a
+// burst of clicks would see.
+//
+// Time to first solution and completion are measured from arrival. CPU
+// utilisation is process CPU time over wall time and cores; RSS is sampled
+// every 50 ms. The results are written as JSON.
+//
+// With `--placement 1` every solver slot is pinned to its own partition of
+// the CPUs and runs as many CP-SAT workers as the partition has cores,
+// instead of `--solver-threads`.
+//
+// Usage: LoadTest [--mode closed|open] [--concurrency N] [--rate N]
+//                 [--requests N] [--large-share F] [--time-limit seconds]
+//                 [--solver-threads N] [--placement 0|1] [--seed N]
+//                 [--out file]
+using namespace TimetableWeaver;
+
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static double GetProcessCpuSeconds()
+{
+#ifdef _WIN32
+  FILETIME created, exited, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel,
+                       &user)) {
+    return 0.0;
+  }
+  auto seconds = [](const FILETIME &time) {
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32 |
+            time.dwLowDateTime) /
+           1e7;
+  };
+  return seconds(kernel) + seconds(user);
+#else
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+struct Sample {
+  bool   large         = false;
+  bool   solved        = false;
+  double firstSolution = -1.0; // Seconds since arrival, -1 without one
+  double completion    = 0.0;
+};
+
+struct Request {
+  int               index = 0;
+  Clock::time_point arrival;
+};
+
+// Serves one generate request, recording when the first schedule came.
+static Sample Serve(SolverBackend *backend, const TimetableConfig &config,
+                    const SolveOptions &base, Clock::time_point arrival)
+{
+  Sample            sample;
+  Schedule          schedule;
+  SolveOptions      options = base;
+  std::atomic<bool> seen{false};
+  options.onSolution = [&](const SolveProgress &) {
+    if (!seen.exchange(true)) {
+      sample.firstSolution = SecondsSince(arrival);
+    }
+  };
+
+  bool decided = false;
+  if (BitsetSolver::CanSolve(config)) {
+    BitsetSolver bitset;
+    sample.solved = bitset.Solve(config, schedule, options);
+    decided       = sample.solved || bitset.IsExhausted();
+  }
+  if (!decided && backend != nullptr) {
+    sample.solved = backend->Solve(config, schedule, options);
+  }
+  sample.completion = SecondsSince(arrival);
+  if (sample.solved && sample.firstSolution < 0.0) {
+    sample.firstSolution = sample.completion;
+  }
+  return sample;
+}
+
+// Nearest-rank percentiles of the values, in milliseconds.
+static void WriteStats(std::ostream &out, std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  auto percentile = [&](double p) {
+    if (values.empty()) {
+      return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::max<size_t>(rank, 1) - 1] * 1e3;
+  };
+  double total = 0.0;
+  for (double value : values) {
+    total += value;
+  }
+  out << "{\"count\": " << values.size() << ", \"mean_ms\": "
+      << (values.empty() ? 0.0 : total / values.size() * 1e3)
+      << ", \"p50_ms\": " << percentile(0.50)
+      << ", \"p95_ms\": " << percentile(0.95)
+      << ", \"p99_ms\": " << percentile(0.99)
+      << ", \"max_ms\": " << percentile(1.0) << "}";
+}
+
+static void WriteGroup(std::ostream &out, const std::vector<Sample> &samples,
+                       int large)
+{
+  std::vector<double> first, completion;
+  for (const auto &sample : samples) {
+    if (large >= 0 && sample.large != (large == 1)) {
+      continue;
+    }
+    completion.push_back(sample.completion);
+    if (sample.firstSolution >= 0.0) {
+      first.push_back(sample.firstSolution);
+    }
+  }
+  out << "{\"time_to_first_solution\": ";
+  WriteStats(out, first);
+  out << ", \"completion\": ";
+  WriteStats(out, completion);
+  out << "}";
+}
+
+static TimetableConfig MakeInstance(bool large, std::mt19937 &random)
+{
+  auto pick = [&](int low, int high) {
+    return std::uniform_int_distribution<int>(low, high)(random);
+  };
+
+  GeneratorParams params;
+  if (large) {
+    params.classes  = pick(20, 30);
+    params.teachers = params.classes * 3 / 2;
+  } else {
+    params.periodsPerDay       = pick(4, 6);
+    params.classes             = pick(1, 2);
+    params.teachers            = params.classes + 2;
+    params.subjects            = 4;
+    params.maxPeriodsPerLesson = 4;
+    params.classFill           = 0.8;
+    params.teacherAvailability = 0.8;
+  }
+  params.seed = random();
+  return GenerateInstance(params);
+}
+
+int main(int argc, char *argv[])
+{
+  bool        open          = false;
+  int         concurrency   = 4;
+  double      rate          = 2.0;
+  int         requests      = 200;
+  double      largeShare    = 0.2;
+  double      timeLimit     = 10.0;
+  int         solverThreads = 0;
+  bool        placement     = false;
+  uint32_t    seed          = 1;
+  std::string out           = "loadtest.json";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--mode") == 0) {
+      open = std::strcmp(argv[i + 1], "open") == 0;
+    } else if (std::strcmp(argv[i], "--concurrency") == 0) {
+      concurrency = std::max(1, std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--rate") == 0) {
+      rate = std::atof(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--requests") == 0) {
+      requests = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--large-share") == 0) {
+      largeShare = std::atof(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--time-limit") == 0) {
+      timeLimit = std::atof(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--solver-threads") == 0) {
+      solverThreads = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--placement") == 0) {
+      placement = std::atoi(argv[i + 1]) != 0;
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+    } else if (std::strcmp(argv[i], "--out") == 0) {
+      out = argv[i + 1];
+    }
+  }
+
+  // A small pool per size, replayed in a seeded order.
+  const int                    poolSize = 8;
+  std::mt19937                 random(seed);
+  std::vector<TimetableConfig> small, large;
+  for (int i = 0; i < poolSize; ++i) {
+    small.push_back(MakeInstance(false, random));
+    large.push_back(MakeInstance(true, random));
+  }
+  std::bernoulli_distribution isLarge(largeShare);
+  std::vector<int>            plan(requests); // Pool index, large ones < 0
+  for (auto &entry : plan) {
+    const int slot = static_cast<int>(random() % poolSize);
+    entry          = isLarge(random) ? -1 - slot : slot;
+  }
+
+  std::shared_ptr<SolverBackend> backend;
+  const bool needsBackend =
+      std::any_of(plan.begin(), plan.end(), [&](int entry) {
+        return entry < 0 || !BitsetSolver::CanSolve(small[entry]);
+      });
+  if (needsBackend) {
+    backend = LoadSolverBackend();
+    if (!backend) {
+      std::cerr << "Could not load the solver backend.\n";
+      return 1;
+    }
+  }
+
+  SolveOptions base;
+  base.timeLimitSeconds = timeLimit;
+  base.numWorkers       = solverThreads;
+
+  std::vector<CpuPartition> partitions;
+  if (placement) {
+    const CpuTopology topology = CpuTopology::Detect();
+    topology.Print(std::cout);
+    partitions = PartitionCpus(topology, concurrency);
+  }
+
+  // Runs on worker `slot`, which is pinned to its partition when placing.
+  std::vector<Sample> samples(requests);
+  auto handle = [&](const Request &request, int slot) {
+    const int    entry   = plan[request.index];
+    const auto  &config  = entry < 0 ? large[-1 - entry] : small[entry];
+    SolveOptions options = base;
+    if (placement) {
+      options.numWorkers = partitions[slot].GetWorkerCount();
+    }
+    samples[request.index] =
+        Serve(backend.get(), config, options, request.arrival);
+    samples[request.index].large = entry < 0;
+  };
+  auto pin = [&](int slot) {
+    return std::unique_ptr<ScopedAffinity>(
+        placement ? new ScopedAffinity(partitions[slot]) : nullptr);
+  };
+
+  std::atomic<bool> sampling{true};
+  uint64_t          peakRss = GetResidentMemoryBytes();
+  std::thread       sampler([&] {
+    while (sampling) {
+      peakRss = std::max(peakRss, GetResidentMemoryBytes());
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  });
+
+  const double             cpuStart = GetProcessCpuSeconds();
+  const Clock::time_point  start    = Clock::now();
+  std::vector<std::thread> workers;
+  if (open) {
+    BoundedQueue<Request> queue(requests);
+    for (int w = 0; w < concurrency; ++w) {
+      workers.emplace_back([&, w] {
+        const auto affinity = pin(w);
+        Request    request;
+        while (queue.Pop(request)) {
+          handle(request, w);
+        }
+      });
+    }
+    std::exponential_distribution<double> gap(rate > 0.0 ? rate : 1.0);
+    Clock::time_point                     arrival = start;
+    for (int i = 0; i < requests; ++i) {
+      std::this_thread::sleep_until(arrival);
+      queue.Push({i, arrival});
+      arrival += std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(gap(random)));
+    }
+    queue.Close();
+  } else {
+    std::atomic<int> next{0};
+    for (int w = 0; w < concurrency; ++w) {
+      workers.emplace_back([&, w] {
+        const auto affinity = pin(w);
+        for (int i = next++; i < requests; i = next++) {
+          handle({i, Clock::now()}, w);
+        }
+      });
+    }
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  const double wall = SecondsSince(start);
+  const double cpu  = GetProcessCpuSeconds() - cpuStart;
+  sampling          = false;
+  sampler.join();
+
+  int solved = 0;
+  for (const auto &sample : samples) {
+    solved += sample.solved ? 1 : 0;
+  }
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  std::ofstream file(out);
+  file << "{\n  \"mode\": \"" << (open ? "open" : "closed") << "\",\n"
+       << "  \"concurrency\": " << concurrency << ",\n"
+       << "  \"placement\": " << (placement ? "true" : "false") << ",\n"
+       << "  \"arrival_rate\": " << (open ? rate : 0.0) << ",\n"
+       << "  \"requests\": " << requests << ",\n"
+       << "  \"large_share\": " << largeShare << ",\n"
+       << "  \"time_limit_seconds\": " << timeLimit << ",\n"
+       << "  \"solved\": " << solved << ",\n"
+       << "  \"wall_seconds\": " << wall << ",\n"
+       << "  \"throughput_per_second\": " << requests / wall << ",\n"
+       << "  \"cpu_seconds\": " << cpu << ",\n"
+       << "  \"cpu_utilisation\": " << cpu / (wall * cores) << ",\n"
+       << "  \"cores\": " << cores << ",\n"
+       << "  \"rss_peak_mb\": " << peakRss / (1024.0 * 1024.0) << ",\n"
+       << "  \"rss_end_mb\": "
+       << GetResidentMemoryBytes() / (1024.0 * 1024.0) << ",\n"
+       << "  \"all\": ";
+  WriteGroup(file, samples, -1);
+  file << ",\n  \"small\": ";
+  WriteGroup(file, samples, 0);
+  file << ",\n  \"large\": ";
+  WriteGroup(file, samples, 1);
+  file << "\n}\n";
+  if (!file.good()) {
+    std::cerr << "Cannot write " << out << "\n";
+    return 1;
+  }
+  std::cout << solved << "/" << requests << " solved in " << wall
+            << " s; results in " << out << "\n";
+  return 0;
+}
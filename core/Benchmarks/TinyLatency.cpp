@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BitsetSolver.hpp"
+#include "InstanceGenerator.hpp"
+
+// Per-solve latency of the bitset solver against CP-SAT on tiny configs.
+//
+// Instances come from the generator with a single class or two and no
+// daily rules, sized to stay under the automatic dispatch threshold. Both
+// solvers see the same configs; the backend is loaded once up front so its
+// numbers show the model build and solve only.
+//
+// Usage: TinyLatency [--instances N] [--seed N]
+using namespace TimetableWeaver;
+
+struct Latency {
+  std::vector<double> micros;
+  int                 solved = 0;
+};
+
+static void Report(const char *name, Latency &latency)
+{
+  std::sort(latency.micros.begin(), latency.micros.end());
+  double total = 0.0;
+  for (double micros : latency.micros) {
+    total += micros;
+  }
+  const size_t count = latency.micros.size();
+  std::cout << name << ": solved " << latency.solved << "/" << count
+            << ", mean " << (count > 0 ? total / count : 0.0) << " us, p50 "
+            << (count > 0 ? latency.micros[count / 2] : 0.0) << " us, max "
+            << (count > 0 ? latency.micros.back() : 0.0) << " us\n";
+}
+
+static void Time(SolverBackend &backend, const TimetableConfig &config,
+                 Latency &latency)
+{
+  Schedule   schedule;
+  const auto start  = std::chrono::steady_clock::now();
+  const bool solved = backend.Solve(config, schedule);
+  latency.micros.push_back(std::chrono::duration<double, std::micro>(
+                               std::chrono::steady_clock::now() - start)
+                               .count());
+  latency.solved += solved ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  int      instances = 200;
+  uint32_t seed      = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--instances") == 0) {
+      instances = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+    }
+  }
+
+  auto backend = LoadSolverBackend();
+  if (!backend) {
+    std::cerr << "Could not load the solver backend.\n";
+    return 1;
+  }
+
+  std::mt19937 random(seed);
+  BitsetSolver bitset;
+  Latency      bitsetLatency, backendLatency;
+  int          skipped = 0;
+  for (int i = 0; i < instances; ++i) {
+    auto pick = [&](int low, int high) {
+      return std::uniform_int_distribution<int>(low, high)(random);
+    };
+
+    GeneratorParams params;
+    params.days                = 5;
+    params.periodsPerDay       = pick(4, 6);
+    params.classes             = pick(1, 2);
+    params.teachers            = params.classes + 2;
+    params.subjects            = 4;
+    params.maxPeriodsPerLesson = 4;
+    params.classFill           = 0.8;
+    params.teacherAvailability = 0.8;
+    params.seed                = random();
+
+    const TimetableConfig config = GenerateInstance(params);
+    if (!BitsetSolver::CanSolve(config)) {
+      ++skipped;
+      continue;
+    }
+    Time(bitset, config, bitsetLatency);
+    Time(*backend, config, backendLatency);
+  }
+
+  std::cout << "Instances: " << bitsetLatency.micros.size() << " (" << skipped
+            << " over the size threshold)\n";
+  Report("bitset", bitsetLatency);
+  Report(backend->GetName(), backendLatency);
+  return 0;
+}
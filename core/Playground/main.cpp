@@ -1,3 +1,11 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "AdaptiveSolver.hpp"
+#include "DomainPropagator.hpp"
+#include "MetricsExporter.hpp"
+#include "MoveProber.hpp"
 #include "Timetable.hpp"
 
 int main(int argc, char *argv[])
@@ -42,11 +50,104 @@ int main(int argc, char *argv[])
   config.subjects      = {math, physics};
   config.lessons       = {lesson1, lesson2, lesson3};
 
+  // Daily-structure rules
+  config.rules = {DailyRule::MaxConsecutive(RuleTarget::Classes, 4),
+                  DailyRule::MaxPerDay(RuleTarget::Teachers, 6),
+                  DailyRule::NoGaps(RuleTarget::Classes)};
+  config.rules.back().hard = false;
+
+  // Options: Playground [--trace trace.json] [--stats stats.prom]
+  //                     [--budget seconds] [--domains domains.txt]
+  //                     [--probe entry] [--channel results.bin]
+  //                     [--metrics-port port]
+  TraceRecorder   trace;
+  MetricsRegistry registry;
+  SolverMetrics   metrics(registry);
+  const char     *tracePath   = nullptr;
+  const char     *statsPath   = nullptr;
+  const char     *domainsPath = nullptr;
+  const char     *channelPath = nullptr;
+  double          budget      = 0.0;
+  int             probe       = -1;
+  int             metricsPort = -1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--trace") == 0) {
+      tracePath = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--stats") == 0) {
+      statsPath = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--budget") == 0) {
+      budget = std::atof(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--domains") == 0) {
+      domainsPath = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--probe") == 0) {
+      probe = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--channel") == 0) {
+      channelPath = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--metrics-port") == 0) {
+      metricsPort = std::atoi(argv[i + 1]);
+    }
+  }
+
+  // Prometheus scrapes while the run lasts
+  MetricsServer server(registry);
+  if (metricsPort >= 0 && server.Start(metricsPort)) {
+    std::cout << "Metrics on http://127.0.0.1:" << server.GetPort()
+              << "/metrics\n";
+  }
+  if (tracePath != nullptr) {
+    trace.SetThreadName("main");
+    trace.Start();
+  }
+
+  // Slots each lesson can still take, without solving
+  if (domainsPath != nullptr) {
+    DomainPropagator propagator(config);
+    std::ofstream    stream(domainsPath);
+    if (!propagator.Propagate()) {
+      stream << "Some class or teacher cannot fit its lessons.\n";
+    } else {
+      propagator.Print(stream);
+    }
+  }
+
   // Create timetable and generate schedule
   Timetable timetable(config);
+  timetable.SetTraceRecorder(&trace);
+  timetable.SetMetrics(&metrics);
+
+  // Improving schedules streamed to the UI's result channel
+  ResultChannelWriter channel;
+  if (channelPath != nullptr &&
+      channel.Create(channelPath, days, periodsPerDay,
+                     static_cast<int>(config.classes.size()))) {
+    timetable.SetResultChannel(&channel);
+  }
+  if (budget > 0.0) {
+    AdaptiveOptions adaptive;
+    adaptive.budgetSeconds = budget;
+    timetable.SetBackend(
+        std::make_shared<AdaptiveSolver>(LoadSolverBackend(), adaptive));
+  }
   if (timetable.Generate()) {
     std::cout << "Timetable generated successfully.\n";
+
+    // Where else the chosen schedule entry could move
+    const auto &entries = timetable.GetSchedule().GetEntries();
+    if (probe >= 0 && probe < static_cast<int>(entries.size())) {
+      MoveProber prober(LoadSolverBackend());
+      PrintProbeMap(std::cout, config,
+                    prober.Probe(config, timetable.GetSchedule(),
+                                 entries[probe]));
+    }
   } else {
     std::cout << "Failed to generate timetable.\n";
   }
-}
\ No newline at end of file
+
+  if (tracePath != nullptr) {
+    trace.Stop();
+    trace.WriteJson(tracePath);
+  }
+  if (statsPath != nullptr) {
+    StatsFileWriter(registry).Write(statsPath);
+  }
+}
@@ -0,0 +1,142 @@
+#include "DailyRuleCompiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TimetableWeaver
+{
+using operations_research::Domain;
+using operations_research::sat::BoolVar;
+using operations_research::sat::CpModelBuilder;
+using operations_research::sat::IntVar;
+using operations_research::sat::LinearExpr;
+
+/**
+ * DailyRuleCompiler
+ */
+DailyRuleCompiler::DailyRuleCompiler(CpModelBuilder &model, int days,
+                                     int periodsPerDay)
+    : m_Model(model), m_Days(days), m_PeriodsPerDay(periodsPerDay)
+{
+}
+
+void DailyRuleCompiler::Compile(const DailyRule &rule,
+                                const OccupancyGrid &classes,
+                                const OccupancyGrid &teachers)
+{
+  const OccupancyGrid &grid =
+      rule.target == RuleTarget::Classes ? classes : teachers;
+
+  if (rule.entityId >= 0) {
+    if (rule.entityId < static_cast<int>(grid.size())) {
+      CompileEntity(rule, grid[rule.entityId]);
+    }
+    return;
+  }
+
+  for (const auto &occupancy : grid) {
+    CompileEntity(rule, occupancy);
+  }
+}
+
+void DailyRuleCompiler::AddAtMost(const DailyRule &rule, const LinearExpr &expr,
+                                  int cap, int maxExcess)
+{
+  if (rule.hard) {
+    m_Model.AddLessOrEqual(expr, cap);
+    return;
+  }
+
+  IntVar excess = m_Model.NewIntVar(Domain(0, maxExcess));
+  m_Model.AddLessOrEqual(expr, LinearExpr(excess) + cap);
+  m_Penalty += LinearExpr(excess) * rule.weight;
+  m_HasPenalty = true;
+}
+
+void DailyRuleCompiler::CompileEntity(const DailyRule               &rule,
+                                      const std::vector<LinearExpr> &occupancy)
+{
+  const int periods = m_PeriodsPerDay;
+
+  for (int d = 0; d < m_Days; ++d) {
+    const LinearExpr *day = &occupancy[d * periods];
+
+    // Days where the entity can never be busy need no constraints.
+    bool empty = true;
+    for (int p = 0; p < periods && empty; ++p) {
+      empty = day[p].variables().empty();
+    }
+    if (empty) {
+      continue;
+    }
+
+    switch (rule.kind) {
+    case DailyRuleKind::MaxConsecutive: {
+      // Every window of limit + 1 periods has a free period.
+      const int window = rule.limit + 1;
+      for (int start = 0; start + window <= periods; ++start) {
+        LinearExpr sum;
+        for (int p = start; p < start + window; ++p) {
+          sum += day[p];
+        }
+        AddAtMost(rule, sum, rule.limit, 1);
+      }
+      break;
+    }
+    case DailyRuleKind::MaxPerDay: {
+      if (rule.limit >= periods) {
+        break;
+      }
+      LinearExpr sum;
+      for (int p = 0; p < periods; ++p) {
+        sum += day[p];
+      }
+      AddAtMost(rule, sum, rule.limit, periods - rule.limit);
+      break;
+    }
+    case DailyRuleKind::Break: {
+      const int first = std::max(rule.firstPeriod, 0);
+      const int last  = std::min(rule.lastPeriod, periods - 1);
+      if (first > last) {
+        break;
+      }
+      LinearExpr sum;
+      for (int p = first; p <= last; ++p) {
+        sum += day[p];
+      }
+      AddAtMost(rule, sum, last - first, 1);
+      break;
+    }
+    case DailyRuleKind::NoGaps: {
+      // started[p]: busy at some period <= p; ending[p]: busy at some
+      // period >= p. A free period with both set is a gap.
+      std::vector<BoolVar> started(periods), ending(periods);
+      for (int p = 0; p < periods; ++p) {
+        started[p] = m_Model.NewBoolVar();
+        ending[p]  = m_Model.NewBoolVar();
+      }
+      for (int p = 0; p < periods; ++p) {
+        LinearExpr prevStarted =
+            p > 0 ? LinearExpr(started[p - 1]) : LinearExpr(0);
+        m_Model.AddGreaterOrEqual(started[p], day[p]);
+        m_Model.AddGreaterOrEqual(started[p], prevStarted);
+        m_Model.AddLessOrEqual(started[p], prevStarted + day[p]);
+
+        int        q = periods - 1 - p;
+        LinearExpr nextEnding =
+            q < periods - 1 ? LinearExpr(ending[q + 1]) : LinearExpr(0);
+        m_Model.AddGreaterOrEqual(ending[q], day[q]);
+        m_Model.AddGreaterOrEqual(ending[q], nextEnding);
+        m_Model.AddLessOrEqual(ending[q], nextEnding + day[q]);
+      }
+      for (int p = 1; p + 1 < periods; ++p) {
+        AddAtMost(rule,
+                  LinearExpr(started[p]) + LinearExpr(ending[p]) - day[p], 1,
+                  1);
+      }
+      break;
+    }
+    }
+  }
+}
+}; // namespace TimetableWeaver
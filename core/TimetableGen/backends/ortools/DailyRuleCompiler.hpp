@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "ortools/sat/cp_model.h"
+
+#include "DailyRules.hpp"
+
+namespace TimetableWeaver
+{
+// Occupancy of every entity of one target: one 0/1 linear expression per
+// (day, period), indexed by day * periodsPerDay + period.
+using OccupancyGrid =
+    std::vector<std::vector<operations_research::sat::LinearExpr>>;
+
+// Compiles daily-structure rules into sliding-window sums and small
+// monotone automata over the occupancy literals. Every rule adds
+// O(days * periods) constraints per entity. Soft rules add bounded slack
+// variables whose weighted sum is collected into the penalty expression.
+class DailyRuleCompiler
+{
+public:
+  DailyRuleCompiler(operations_research::sat::CpModelBuilder &model, int days,
+                    int periodsPerDay);
+
+  void Compile(const DailyRule &rule, const OccupancyGrid &classes,
+               const OccupancyGrid &teachers);
+
+  bool HasPenalty() const { return m_HasPenalty; }
+  const operations_research::sat::LinearExpr &GetPenalty() const
+  {
+    return m_Penalty;
+  }
+
+private:
+  void CompileEntity(const DailyRule                                    &rule,
+                     const std::vector<operations_research::sat::LinearExpr>
+                         &occupancy);
+
+  // Adds expr <= cap, with slack up to `maxExcess` when the rule is soft.
+  void AddAtMost(const DailyRule                            &rule,
+                 const operations_research::sat::LinearExpr &expr, int cap,
+                 int maxExcess);
+
+  operations_research::sat::CpModelBuilder &m_Model;
+
+  int m_Days;
+  int m_PeriodsPerDay;
+
+  operations_research::sat::LinearExpr m_Penalty;
+  bool                                 m_HasPenalty = false;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,208 @@
+#include "OrToolsBackend.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+
+namespace TimetableWeaver
+{
+using namespace operations_research;
+using namespace operations_research::sat;
+
+/**
+ * OrToolsBackend
+ */
+bool OrToolsBackend::RefineExams(const ExamConfig   &config,
+                                 ExamSchedule       &schedule,
+                                 const SolveOptions &options)
+{
+  const int periods   = config.periodsPerDay;
+  const int num_slots = config.GetSlotCount();
+  const int num_exams = static_cast<int>(config.exams.size());
+  const int spacing   = std::max(1, config.minSpacing);
+  const int preferred = config.preferredSpacing;
+  if (static_cast<int>(schedule.size()) != num_exams) {
+    std::cerr << "Exam schedule does not match the config\n";
+    return false;
+  }
+
+  TraceSpan build(m_Trace, "build-model", "phase",
+                  {{"formulation", "exam-slot-boolean"}});
+
+  CpModelBuilder model;
+
+  // One literal per exam and allowed slot, hinted from the schedule.
+  std::vector<std::vector<std::pair<int, BoolVar>>> exam_slots(num_exams);
+  for (int e = 0; e < num_exams; ++e) {
+    const int hint = schedule[e].day * periods + schedule[e].period;
+    std::vector<BoolVar> literals;
+    for (int d = 0; d < config.days; ++d) {
+      const uint32_t allowed = config.GetAllowedPeriods(e, d);
+      for (int p = 0; p < periods; ++p) {
+        if ((allowed >> p & 1) == 0) {
+          continue;
+        }
+        const int slot = d * periods + p;
+        BoolVar   x    = model.NewBoolVar();
+        model.AddHint(x, slot == hint);
+        exam_slots[e].emplace_back(slot, x);
+        literals.push_back(x);
+      }
+    }
+    if (literals.empty()) {
+      std::cerr << "No available slots for exam " << config.exams[e].name
+                << "\n";
+      return false;
+    }
+    model.AddExactlyOne(literals);
+  }
+
+  // Rooms per slot by capacity level. An exam needs the smallest level that
+  // seats it, and at every level the exams needing it or more must not
+  // outnumber the rooms of that size or more.
+  std::set<int> capacity_set;
+  for (const auto &room : config.rooms) {
+    capacity_set.insert(room.GetCapacity());
+  }
+  const std::vector<int> capacities(capacity_set.begin(), capacity_set.end());
+  const int              num_levels = static_cast<int>(capacities.size());
+
+  std::vector<int> levels(num_exams);
+  for (int e = 0; e < num_exams; ++e) {
+    levels[e] = std::lower_bound(capacities.begin(), capacities.end(),
+                                 config.exams[e].students) -
+                capacities.begin();
+    if (levels[e] >= num_levels) {
+      std::cerr << "No room seats exam " << config.exams[e].name << "\n";
+      return false;
+    }
+  }
+
+  std::vector<std::vector<LinearExpr>> level_demand(
+      num_slots, std::vector<LinearExpr>(num_levels));
+  std::vector<LinearExpr> slot_demand(num_slots);
+  for (int e = 0; e < num_exams; ++e) {
+    for (const auto &[slot, x] : exam_slots[e]) {
+      slot_demand[slot] += x;
+      for (int l = 0; l <= levels[e]; ++l) {
+        level_demand[slot][l] += x;
+      }
+    }
+  }
+
+  for (int slot = 0; slot < num_slots; ++slot) {
+    const int day    = slot / periods;
+    const int period = slot % periods;
+
+    int invigilators = 0;
+    for (const auto &invigilator : config.invigilators) {
+      invigilators += invigilator.GetAvailability().Get(day, period);
+    }
+    model.AddLessOrEqual(slot_demand[slot], invigilators);
+
+    std::vector<int> rooms(num_levels + 1, 0);
+    for (const auto &room : config.rooms) {
+      if (room.GetAvailability().Get(day, period)) {
+        const int level = std::lower_bound(capacities.begin(),
+                                           capacities.end(),
+                                           room.GetCapacity()) -
+                          capacities.begin();
+        ++rooms[level];
+      }
+    }
+    for (int l = num_levels - 1; l >= 0; --l) {
+      rooms[l] += rooms[l + 1];
+      model.AddLessOrEqual(level_demand[slot][l], rooms[l]);
+    }
+  }
+
+  // Per group, at most one exam in any run of `spacing` slots. Two exams d
+  // slots apart share preferred - d runs of `preferred` slots, so charging
+  // j - 1 for the j-th exam of every such run adds up to the pairwise
+  // spacing penalty.
+  std::vector<std::vector<int>> group_exams(config.groups.size());
+  for (int e = 0; e < num_exams; ++e) {
+    for (int g : config.exams[e].groups) {
+      group_exams[g].push_back(e);
+    }
+  }
+
+  LinearExpr penalty;
+  for (const auto &exams : group_exams) {
+    if (exams.size() < 2) {
+      continue;
+    }
+    std::vector<std::vector<BoolVar>> by_slot(num_slots);
+    for (int e : exams) {
+      for (const auto &[slot, x] : exam_slots[e]) {
+        by_slot[slot].push_back(x);
+      }
+    }
+    auto window = [&](int first, int length) {
+      std::vector<BoolVar> literals;
+      for (int t = std::max(0, first);
+           t < std::min(num_slots, first + length); ++t) {
+        literals.insert(literals.end(), by_slot[t].begin(), by_slot[t].end());
+      }
+      return literals;
+    };
+
+    for (int first = 0; first < num_slots; ++first) {
+      const auto literals = window(first, spacing);
+      if (literals.size() > 1) {
+        model.AddAtMostOne(literals);
+      }
+    }
+
+    if (preferred <= spacing ||
+        options.strategy == SolveStrategy::FirstFeasible) {
+      continue;
+    }
+    const int most = std::min<int>(exams.size(),
+                                   (preferred + spacing - 1) / spacing);
+    for (int first = 1 - preferred; first < num_slots; ++first) {
+      const auto literals = window(first, preferred);
+      if (literals.size() < 2) {
+        continue;
+      }
+      LinearExpr extra;
+      BoolVar    previous;
+      for (int j = 2; j <= most; ++j) {
+        BoolVar z = model.NewBoolVar();
+        if (j > 2) {
+          model.AddImplication(z, previous);
+        }
+        extra += z;
+        penalty += LinearExpr::Term(z, j - 1);
+        previous = z;
+      }
+      model.AddLessOrEqual(LinearExpr::Sum(literals), extra + 1);
+    }
+  }
+  model.Minimize(penalty);
+
+  const CpModelProto proto = model.Build();
+  build.AddArg("variables", std::to_string(proto.variables_size()));
+  build.AddArg("constraints", std::to_string(proto.constraints_size()));
+  build.End();
+
+  const CpSolverResponse response = RunSolver(proto, 0, options);
+  if (response.status() != CpSolverStatus::FEASIBLE &&
+      response.status() != CpSolverStatus::OPTIMAL) {
+    return false;
+  }
+
+  TraceSpan extract(m_Trace, "extract-schedule", "phase");
+  for (int e = 0; e < num_exams; ++e) {
+    for (const auto &[slot, x] : exam_slots[e]) {
+      if (SolutionBooleanValue(response, x)) {
+        schedule[e].day         = slot / periods;
+        schedule[e].period      = slot % periods;
+        schedule[e].room        = -1;
+        schedule[e].invigilator = -1;
+      }
+    }
+  }
+  return true;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,507 @@
+#include "OrToolsBackend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include "ortools/sat/sat_parameters.pb.h"
+#include "ortools/util/time_limit.h"
+
+#include "DailyRuleCompiler.hpp"
+#include "ModelEstimate.hpp"
+
+namespace TimetableWeaver
+{
+using namespace operations_research;
+using namespace operations_research::sat;
+
+/**
+ * OrToolsBackend
+ */
+// Slots of every lesson in `hint`, sorted, indexed by lesson.
+static std::vector<std::vector<int>> GetHintSlots(const Schedule *hint,
+                                                  int numLessons, int periods)
+{
+  std::vector<std::vector<int>> slots(numLessons);
+  if (hint == nullptr) {
+    return slots;
+  }
+  for (const auto &entry : hint->GetEntries()) {
+    if (entry.lesson >= 0 && entry.lesson < numLessons) {
+      slots[entry.lesson].push_back(entry.day * periods + entry.period);
+    }
+  }
+  for (auto &lesson : slots) {
+    std::sort(lesson.begin(), lesson.end());
+  }
+  return slots;
+}
+
+static void SetStatus(const SolveOptions &options, SolveStatus status)
+{
+  if (options.status != nullptr) {
+    *options.status = status;
+  }
+}
+
+bool OrToolsBackend::Solve(const TimetableConfig &config, Schedule &schedule,
+                           const SolveOptions &options)
+{
+  const int numLessons = static_cast<int>(config.lessons.size());
+  SetStatus(options, SolveStatus::Unknown);
+
+  for (const auto &pin : options.pinned) {
+    if (pin.lesson < 0 || pin.lesson >= numLessons) {
+      std::cerr << "Pinned placement of unknown lesson " << pin.lesson << "\n";
+      SetStatus(options, SolveStatus::Infeasible);
+      return false;
+    }
+  }
+
+  const LessonIds ids = config.GetLessonIds();
+  for (int i = 0; i < numLessons; ++i) {
+    if (ids.classes[i] < 0 || ids.teachers[i] < 0) {
+      std::cerr << "Lesson " << i << " uses a class or teacher missing from "
+                << "the config\n";
+      return false;
+    }
+  }
+
+  // Pick the formulation before building anything, so an oversized config
+  // is refused instead of pushing the host into swap.
+  const std::vector<ModelEstimate> estimates = EstimateModels(config);
+  int choice = -1;
+  if (options.formulation == Formulation::Auto) {
+    choice = SelectFormulation(estimates, config.memoryBudgetMb);
+  } else {
+    for (size_t i = 0; i < estimates.size(); ++i) {
+      if (estimates[i].formulation == options.formulation &&
+          SelectFormulation({estimates[i]}, config.memoryBudgetMb) == 0) {
+        choice = static_cast<int>(i);
+      }
+    }
+  }
+  if (choice < 0) {
+    std::cerr << "No usable formulation within the memory budget\n";
+    PrintEstimates(std::cerr, estimates, config.memoryBudgetMb);
+    return false;
+  }
+
+  switch (estimates[choice].formulation) {
+  case Formulation::SlotInteger:
+    return SolveSlotInteger(config, ids, options, schedule);
+  case Formulation::Pattern:
+    return SolvePattern(config, ids, options, schedule);
+  case Formulation::Auto:
+  case Formulation::SlotBoolean:
+    break;
+  }
+  return SolveSlotBoolean(config, ids, options, schedule);
+}
+
+bool OrToolsBackend::SolveSlotBoolean(const TimetableConfig &config,
+                                      const LessonIds       &ids,
+                                      const SolveOptions    &options,
+                                      Schedule              &schedule)
+{
+  TraceSpan build(m_Trace, "build-model", "phase",
+                  {{"formulation", "slot-boolean"}});
+
+  CpModelBuilder model;
+
+  const int days        = config.days;
+  const int periods     = config.periodsPerDay;
+  const int numSlots    = days * periods;
+  const int numLessons  = static_cast<int>(config.lessons.size());
+  const int numClasses  = static_cast<int>(config.classes.size());
+  const int numTeachers = static_cast<int>(config.teachers.size());
+
+  // Slot-Boolean formulation: one literal per lesson and allowed slot. The
+  // occupancy of a class or teacher at a slot is the sum of the literals
+  // placed there, which the no-overlap constraint keeps 0/1.
+  std::vector<std::vector<std::pair<int, BoolVar>>> lesson_slots(numLessons);
+  OccupancyGrid class_occupancy(numClasses, std::vector<LinearExpr>(numSlots));
+  OccupancyGrid teacher_occupancy(numTeachers,
+                                  std::vector<LinearExpr>(numSlots));
+  std::vector<std::vector<std::vector<BoolVar>>> class_literals(
+      numClasses, std::vector<std::vector<BoolVar>>(numSlots));
+  // Subgroup lessons per class and slot, keyed by (partition, group).
+  using GroupLiterals = std::map<std::pair<int, int>, std::vector<BoolVar>>;
+  std::vector<std::vector<GroupLiterals>> group_literals(
+      numClasses, std::vector<GroupLiterals>(numSlots));
+  std::vector<std::vector<std::vector<BoolVar>>> teacher_literals(
+      numTeachers, std::vector<std::vector<BoolVar>>(numSlots));
+  const std::vector<std::vector<int>> hint_slots =
+      GetHintSlots(options.hint, numLessons, periods);
+
+  // Constraint 1: Respect availability of teachers and classes
+  for (int i = 0; i < numLessons; ++i) {
+    auto                lesson        = config.lessons[i];
+    const Availability &teacher_avail = lesson->GetTeacher()->GetAvailability();
+    const Availability &class_avail   = lesson->GetClass()->GetAvailability();
+    const Subgroup     &subgroup      = lesson->GetSubgroup();
+
+    std::vector<BoolVar> literals;
+    for (int d = 0; d < days; ++d) {
+      uint32_t allowed = teacher_avail.GetDay(d) & class_avail.GetDay(d);
+      for (int p = 0; p < periods; ++p) {
+        if ((allowed >> p) & 1) {
+          BoolVar x = model.NewBoolVar().WithName(
+              "lesson_" + std::to_string(i) + "_d" + std::to_string(d) + "_p" +
+              std::to_string(p));
+          int slot = d * periods + p;
+          if (options.hint != nullptr) {
+            model.AddHint(x, std::binary_search(hint_slots[i].begin(),
+                                                hint_slots[i].end(), slot));
+          }
+          lesson_slots[i].emplace_back(slot, x);
+          literals.push_back(x);
+          if (subgroup.IsWholeClass()) {
+            class_literals[ids.classes[i]][slot].push_back(x);
+          } else {
+            group_literals[ids.classes[i]][slot]
+                          [{subgroup.partition, subgroup.group}]
+                              .push_back(x);
+          }
+          teacher_literals[ids.teachers[i]][slot].push_back(x);
+        }
+      }
+    }
+
+    if (static_cast<int>(literals.size()) < lesson->GetPeriodsPerWeek()) {
+      std::cerr << "No available slots for lesson " << i << "\n";
+      SetStatus(options, SolveStatus::Infeasible);
+      return false; // No solution possible
+    }
+
+    // Constraint 2: Every weekly period of the lesson is placed
+    model.AddEquality(LinearExpr::Sum(literals), lesson->GetPeriodsPerWeek());
+  }
+
+  // Pinned placements fix their literal
+  for (const auto &pin : options.pinned) {
+    const int   slot  = pin.day * periods + pin.period;
+    const auto &list  = lesson_slots[pin.lesson];
+    auto        found =
+        std::find_if(list.begin(), list.end(),
+                     [&](const auto &entry) { return entry.first == slot; });
+    if (found == list.end()) {
+      SetStatus(options, SolveStatus::Infeasible);
+      return false; // Pinned outside the lesson's availability
+    }
+    model.AddEquality(found->second, 1);
+  }
+
+  // Constraint 3: No teacher or class overlaps. Groups of one partition
+  // share a slot as a capacity: each group holds at most one lesson, and a
+  // class slot takes either one whole-class lesson or one partition, whose
+  // activity literal is also the class occupancy the rules see.
+  for (int c = 0; c < numClasses; ++c) {
+    for (int slot = 0; slot < numSlots; ++slot) {
+      std::vector<BoolVar> uses = class_literals[c][slot];
+
+      const auto &groups = group_literals[c][slot];
+      for (auto it = groups.begin(); it != groups.end();) {
+        const int  partition = it->first.first;
+        BoolVar    active    = model.NewBoolVar();
+        LinearExpr all;
+        for (; it != groups.end() && it->first.first == partition; ++it) {
+          model.AddLessOrEqual(LinearExpr::Sum(it->second), active);
+          all += LinearExpr::Sum(it->second);
+        }
+        model.AddLessOrEqual(active, all);
+        uses.push_back(active);
+      }
+
+      if (uses.size() > 1) {
+        model.AddAtMostOne(uses);
+      }
+      class_occupancy[c][slot] = LinearExpr::Sum(uses);
+    }
+  }
+  for (int t = 0; t < numTeachers; ++t) {
+    for (int slot = 0; slot < numSlots; ++slot) {
+      const auto &literals = teacher_literals[t][slot];
+      if (literals.size() > 1) {
+        model.AddAtMostOne(literals);
+      }
+      teacher_occupancy[t][slot] = LinearExpr::Sum(literals);
+    }
+  }
+
+  // Constraint 4: Daily-structure rules
+  DailyRuleCompiler rules(model, days, periods);
+  for (const auto &rule : config.rules) {
+    rules.Compile(rule, class_occupancy, teacher_occupancy);
+  }
+  if (rules.HasPenalty() && options.strategy != SolveStrategy::FirstFeasible) {
+    model.Minimize(rules.GetPenalty());
+  }
+
+  const CpModelProto proto = model.Build();
+  build.AddArg("variables", std::to_string(proto.variables_size()));
+  build.AddArg("constraints", std::to_string(proto.constraints_size()));
+  build.End();
+
+  auto extract = [&](const CpSolverResponse &response, Schedule &result) {
+    result = Schedule(days, periods, numClasses, numTeachers);
+    for (int i = 0; i < numLessons; ++i) {
+      for (const auto &[slot, x] : lesson_slots[i]) {
+        if (!SolutionBooleanValue(response, x)) {
+          continue;
+        }
+        ScheduledLesson entry;
+        entry.lesson    = i;
+        entry.classId   = ids.classes[i];
+        entry.teacherId = ids.teachers[i];
+        entry.subjectId = ids.subjects[i];
+        entry.day       = slot / periods;
+        entry.period    = slot % periods;
+        result.Add(entry);
+      }
+    }
+  };
+
+  const CpSolverResponse response =
+      RunSolver(proto, config.memoryBudgetMb, options, extract);
+  if (response.status() != CpSolverStatus::FEASIBLE &&
+      response.status() != CpSolverStatus::OPTIMAL) {
+    return false;
+  }
+
+  TraceSpan span(m_Trace, "extract-schedule", "phase");
+  extract(response, schedule);
+  return true;
+}
+
+bool OrToolsBackend::SolveSlotInteger(const TimetableConfig &config,
+                                      const LessonIds       &ids,
+                                      const SolveOptions    &options,
+                                      Schedule              &schedule)
+{
+  TraceSpan build(m_Trace, "build-model", "phase",
+                  {{"formulation", "slot-integer"}});
+
+  CpModelBuilder model;
+
+  const int days        = config.days;
+  const int periods     = config.periodsPerDay;
+  const int numLessons  = static_cast<int>(config.lessons.size());
+  const int numClasses  = static_cast<int>(config.classes.size());
+  const int numTeachers = static_cast<int>(config.teachers.size());
+
+  // Slot-integer formulation: one variable per weekly period of a lesson
+  // whose domain is the lesson's allowed slots. Far smaller than the
+  // slot-Boolean model on dense availabilities, but it exposes no
+  // occupancy literals for the daily rules to build on.
+  std::vector<std::vector<IntVar>> lesson_slots(numLessons);
+  std::vector<std::vector<IntVar>> class_slots(numClasses);
+  std::vector<std::vector<IntVar>> teacher_slots(numTeachers);
+  const std::vector<std::vector<int>> hint_slots =
+      GetHintSlots(options.hint, numLessons, periods);
+
+  for (int i = 0; i < numLessons; ++i) {
+    auto                lesson        = config.lessons[i];
+    const Availability &teacher_avail = lesson->GetTeacher()->GetAvailability();
+    const Availability &class_avail   = lesson->GetClass()->GetAvailability();
+
+    std::vector<int64_t> allowed;
+    for (int d = 0; d < days; ++d) {
+      uint32_t mask = teacher_avail.GetDay(d) & class_avail.GetDay(d);
+      for (int p = 0; p < periods; ++p) {
+        if ((mask >> p) & 1) {
+          allowed.push_back(d * periods + p);
+        }
+      }
+    }
+
+    if (static_cast<int>(allowed.size()) < lesson->GetPeriodsPerWeek()) {
+      std::cerr << "No available slots for lesson " << i << "\n";
+      SetStatus(options, SolveStatus::Infeasible);
+      return false; // No solution possible
+    }
+
+    const Domain domain = Domain::FromValues(allowed);
+    for (int k = 0; k < lesson->GetPeriodsPerWeek(); ++k) {
+      IntVar slot = model.NewIntVar(domain).WithName(
+          "lesson_" + std::to_string(i) + "_" + std::to_string(k));
+      // Copies of one lesson are interchangeable; keep them ordered.
+      if (k > 0) {
+        model.AddLessOrEqual(LinearExpr(lesson_slots[i].back()) + 1, slot);
+      }
+      if (k < static_cast<int>(hint_slots[i].size())) {
+        model.AddHint(slot, hint_slots[i][k]);
+      }
+      lesson_slots[i].push_back(slot);
+      class_slots[ids.classes[i]].push_back(slot);
+      teacher_slots[ids.teachers[i]].push_back(slot);
+    }
+  }
+
+  // Pinned placements: one of the lesson's periods takes the slot
+  for (const auto &pin : options.pinned) {
+    const int            slot = pin.day * periods + pin.period;
+    std::vector<BoolVar> takes;
+    for (const IntVar &var : lesson_slots[pin.lesson]) {
+      BoolVar b = model.NewBoolVar();
+      model.AddEquality(var, slot).OnlyEnforceIf(b);
+      takes.push_back(b);
+    }
+    model.AddBoolOr(takes);
+  }
+
+  // No teacher or class overlaps
+  for (const auto &slots : class_slots) {
+    if (slots.size() > 1) {
+      model.AddAllDifferent(slots);
+    }
+  }
+  for (const auto &slots : teacher_slots) {
+    if (slots.size() > 1) {
+      model.AddAllDifferent(slots);
+    }
+  }
+
+  const CpModelProto proto = model.Build();
+  build.AddArg("variables", std::to_string(proto.variables_size()));
+  build.AddArg("constraints", std::to_string(proto.constraints_size()));
+  build.End();
+
+  auto extract = [&](const CpSolverResponse &response, Schedule &result) {
+    result = Schedule(days, periods, numClasses, numTeachers);
+    for (int i = 0; i < numLessons; ++i) {
+      for (const IntVar &var : lesson_slots[i]) {
+        const int slot =
+            static_cast<int>(SolutionIntegerValue(response, var));
+
+        ScheduledLesson entry;
+        entry.lesson    = i;
+        entry.classId   = ids.classes[i];
+        entry.teacherId = ids.teachers[i];
+        entry.subjectId = ids.subjects[i];
+        entry.day       = slot / periods;
+        entry.period    = slot % periods;
+        result.Add(entry);
+      }
+    }
+  };
+
+  const CpSolverResponse response =
+      RunSolver(proto, config.memoryBudgetMb, options, extract);
+  if (response.status() != CpSolverStatus::FEASIBLE &&
+      response.status() != CpSolverStatus::OPTIMAL) {
+    return false;
+  }
+
+  TraceSpan span(m_Trace, "extract-schedule", "phase");
+  extract(response, schedule);
+  return true;
+}
+
+CpSolverResponse OrToolsBackend::RunSolver(const CpModelProto &proto,
+                                           int                 memoryBudgetMb,
+                                           const SolveOptions &options,
+                                           const ScheduleExtractor &extract)
+{
+  Model         cp_model;
+  SatParameters parameters;
+
+  // The same budget that picked the formulation caps the solver, so a run
+  // that outgrows the estimate stops instead of exhausting memory.
+  if (memoryBudgetMb > 0) {
+    parameters.set_max_memory_in_mb(memoryBudgetMb);
+  }
+  if (options.timeLimitSeconds > 0.0) {
+    parameters.set_max_time_in_seconds(options.timeLimitSeconds);
+  }
+  if (options.numWorkers > 0) {
+    parameters.set_num_workers(options.numWorkers);
+  }
+  switch (options.strategy) {
+  case SolveStrategy::Default:
+    break;
+  case SolveStrategy::FirstFeasible:
+    parameters.set_stop_after_first_solution(true);
+    break;
+  case SolveStrategy::Lns:
+    parameters.set_use_lns_only(true);
+    break;
+  }
+  if (options.hint != nullptr) {
+    parameters.set_repair_hint(true);
+  }
+  cp_model.Add(NewSatParameters(parameters));
+
+  if (options.stop != nullptr) {
+    cp_model.GetOrCreate<TimeLimit>()->RegisterExternalBooleanAsLimit(
+        options.stop);
+  }
+
+  if (options.onBound) {
+    cp_model.Add(NewBestBoundCallback(options.onBound));
+  }
+
+  const bool tracing = m_Trace != nullptr && m_Trace->IsRecording();
+  const bool streaming = options.onSchedule && extract;
+  if (tracing || m_Metrics != nullptr || options.onSolution || streaming) {
+    // Runs once per improving solution, on the thread of the subsolver that
+    // found it; solution_info names that subsolver. CP-SAT holds its
+    // response lock meanwhile, so calls never overlap.
+    TraceRecorder *trace      = tracing ? m_Trace : nullptr;
+    SolverMetrics *metrics    = m_Metrics;
+    auto           onSolution = options.onSolution;
+    auto           onSchedule = streaming ? options.onSchedule : nullptr;
+    auto           start      = std::chrono::steady_clock::now();
+    auto           first      = std::make_shared<std::atomic<bool>>(true);
+    cp_model.Add(NewFeasibleSolutionObserver([=](const CpSolverResponse &r) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (metrics != nullptr && first->exchange(false)) {
+        metrics->timeToFirstSolution.Observe(elapsed.count());
+      }
+      if (onSolution) {
+        onSolution({r.objective_value(), r.best_objective_bound(),
+                    elapsed.count()});
+      }
+      if (onSchedule) {
+        Schedule schedule;
+        extract(r, schedule);
+        onSchedule(schedule);
+      }
+      if (trace != nullptr) {
+        trace->Instant("solution", "solver",
+                       {{"subsolver", r.solution_info()},
+                        {"objective", std::to_string(r.objective_value())},
+                        {"bound", std::to_string(r.best_objective_bound())}});
+      }
+    }));
+  }
+
+  TraceSpan        solve(m_Trace, "solve", "phase");
+  CpSolverResponse response = SolveCpModel(proto, &cp_model);
+  solve.AddArg("status", CpSolverStatus_Name(response.status()));
+  solve.AddArg("objective", std::to_string(response.objective_value()));
+
+  switch (response.status()) {
+  case CpSolverStatus::FEASIBLE:
+  case CpSolverStatus::OPTIMAL:
+    SetStatus(options, SolveStatus::Feasible);
+    break;
+  case CpSolverStatus::INFEASIBLE:
+    SetStatus(options, SolveStatus::Infeasible);
+    break;
+  default:
+    SetStatus(options, SolveStatus::Unknown);
+    break;
+  }
+  return response;
+}
+}; // namespace TimetableWeaver
+
+TIMETABLEGEN_BACKEND_EXPORT TimetableWeaver::SolverBackend *
+CreateTimetableSolverBackend()
+{
+  return new TimetableWeaver::OrToolsBackend();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+
+#include "ortools/sat/cp_model.h"
+
+#include "SolverBackend.hpp"
+
+namespace TimetableWeaver
+{
+// CP-SAT solver. The slot-Boolean formulation has one literal per lesson
+// and allowed slot, AtMostOne per class and teacher slot, and the daily
+// rules compiled on top of the resulting occupancy expressions. Configs
+// without rules fall back to the smaller slot-integer formulation when the
+// slot-Boolean model would not fit the memory budget. The pattern
+// formulation picks one weekly pattern per lesson from a pool that GLOP
+// grows by column generation; it is the one that models spread rules.
+class OrToolsBackend : public SolverBackend
+{
+public:
+  const char *GetName() const override { return "ortools-cpsat"; }
+
+  // Every solve builds its own model and solver.
+  bool IsReentrant() const override { return true; }
+
+  using SolverBackend::Solve;
+  bool Solve(const TimetableConfig &config, Schedule &schedule,
+             const SolveOptions &options) override;
+
+  // Slot-Boolean exam model with the room and invigilator capacity of every
+  // slot, minimising the spacing penalty.
+  bool RefineExams(const ExamConfig &config, ExamSchedule &schedule,
+                   const SolveOptions &options) override;
+
+private:
+  bool SolveSlotBoolean(const TimetableConfig &config, const LessonIds &ids,
+                        const SolveOptions &options, Schedule &schedule);
+  bool SolveSlotInteger(const TimetableConfig &config, const LessonIds &ids,
+                        const SolveOptions &options, Schedule &schedule);
+  bool SolvePattern(const TimetableConfig &config, const LessonIds &ids,
+                    const SolveOptions &options, Schedule &schedule);
+
+  // Reads the schedule out of a solver response.
+  using ScheduleExtractor = std::function<void(
+      const operations_research::sat::CpSolverResponse &, Schedule &)>;
+
+  // With an extractor, every improving solution is also handed to
+  // options.onSchedule.
+  operations_research::sat::CpSolverResponse
+  RunSolver(const operations_research::sat::CpModelProto &proto,
+            int memoryBudgetMb, const SolveOptions &options,
+            const ScheduleExtractor &extract = nullptr);
+};
+}; // namespace TimetableWeaver
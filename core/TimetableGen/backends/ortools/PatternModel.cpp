@@ -0,0 +1,447 @@
+#include "OrToolsBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <set>
+
+#include "ortools/linear_solver/linear_solver.h"
+
+#include "DailyRuleCompiler.hpp"
+#include "WeeklyPatterns.hpp"
+
+namespace TimetableWeaver
+{
+using namespace operations_research;
+using namespace operations_research::sat;
+
+// Share of the time limit column generation may spend before CP-SAT takes
+// the pool, and its round cap when there is no limit.
+static const double kPricingShare     = 0.3;
+static const int    kMaxPricingRounds = 500;
+
+// Extra rounds after the LP converged, pricing each lesson with a penalty
+// on the slots its patterns already use, so CP-SAT has alternatives the LP
+// did not need.
+static const int    kDiversifyRounds  = 3;
+static const double kDiversifyPenalty = 1.0;
+
+static const double kEpsilon = 1e-6;
+
+static void SetStatus(const SolveOptions &options, SolveStatus status)
+{
+  if (options.status != nullptr) {
+    *options.status = status;
+  }
+}
+
+/**
+ * OrToolsBackend
+ */
+bool OrToolsBackend::SolvePattern(const TimetableConfig &config,
+                                  const LessonIds       &ids,
+                                  const SolveOptions    &options,
+                                  Schedule              &schedule)
+{
+  const auto start = std::chrono::steady_clock::now();
+  auto       elapsed = [&] {
+    const std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    return seconds.count();
+  };
+
+  const int days        = config.days;
+  const int periods     = config.periodsPerDay;
+  const int numSlots    = days * periods;
+  const int numLessons  = static_cast<int>(config.lessons.size());
+  const int numClasses  = static_cast<int>(config.classes.size());
+  const int numTeachers = static_cast<int>(config.teachers.size());
+
+  TraceSpan generate(m_Trace, "column-generation", "phase",
+                     {{"formulation", "pattern"}});
+
+  // One pricer per lesson, with its spread and its pinned periods per day.
+  std::vector<const SpreadRule *> lesson_spreads(numLessons, nullptr);
+  for (const auto &spread : config.spreads) {
+    if (spread.lesson >= 0 && spread.lesson < numLessons &&
+        lesson_spreads[spread.lesson] == nullptr) {
+      lesson_spreads[spread.lesson] = &spread;
+    }
+  }
+  std::vector<std::vector<uint32_t>> lesson_pins(
+      numLessons, std::vector<uint32_t>(days, 0));
+  for (const auto &pin : options.pinned) {
+    if (pin.day < 0 || pin.day >= days || pin.period < 0 ||
+        pin.period >= periods) {
+      SetStatus(options, SolveStatus::Infeasible);
+      return false; // Pinned outside the week
+    }
+    lesson_pins[pin.lesson][pin.day] |= 1u << pin.period;
+  }
+  std::vector<PatternPricer> pricers;
+  pricers.reserve(numLessons);
+  for (int i = 0; i < numLessons; ++i) {
+    pricers.emplace_back(config, i, lesson_spreads[i], lesson_pins[i]);
+    if (!pricers.back().HasPatterns()) {
+      std::cerr << "No weekly pattern fits lesson " << i << "\n";
+      SetStatus(options, SolveStatus::Infeasible);
+      return false; // No solution possible
+    }
+  }
+
+  // Restricted master LP: every lesson takes one unit of its patterns and
+  // every class and teacher slot holds at most one. Artificial columns keep
+  // it feasible while phase one prices out a fractional cover of the week.
+  std::unique_ptr<MPSolver> lp(MPSolver::CreateSolver("GLOP"));
+  if (lp == nullptr) {
+    std::cerr << "GLOP is not available\n";
+    return false;
+  }
+  const double infinity  = lp->infinity();
+  MPObjective *objective = lp->MutableObjective();
+  objective->SetMinimization();
+
+  std::vector<MPConstraint *> convexity(numLessons);
+  std::vector<MPVariable *>   artificial(numLessons);
+  for (int i = 0; i < numLessons; ++i) {
+    convexity[i]  = lp->MakeRowConstraint(1.0, 1.0);
+    artificial[i] = lp->MakeNumVar(0.0, infinity, "");
+    convexity[i]->SetCoefficient(artificial[i], 1.0);
+    objective->SetCoefficient(artificial[i], 1.0);
+  }
+
+  // Capacity rows are made when the first pattern uses their slot.
+  std::vector<MPConstraint *> class_rows(numClasses * numSlots, nullptr);
+  std::vector<MPConstraint *> teacher_rows(numTeachers * numSlots, nullptr);
+  auto capacity = [&](std::vector<MPConstraint *> &rows, int row) {
+    if (rows[row] == nullptr) {
+      rows[row] = lp->MakeRowConstraint(-infinity, 1.0);
+    }
+    return rows[row];
+  };
+
+  struct Column {
+    int           lesson;
+    WeeklyPattern pattern;
+    MPVariable   *var;
+  };
+  std::vector<Column>                     columns;
+  std::vector<std::set<std::vector<int>>> known(numLessons);
+  bool                                    phase_two = false;
+  auto add_column = [&](int lesson, WeeklyPattern pattern) {
+    if (!known[lesson].insert(pattern.slots).second) {
+      return false;
+    }
+    MPVariable *var = lp->MakeNumVar(0.0, infinity, "");
+    convexity[lesson]->SetCoefficient(var, 1.0);
+    for (int slot : pattern.slots) {
+      capacity(class_rows, ids.classes[lesson] * numSlots + slot)
+          ->SetCoefficient(var, 1.0);
+      capacity(teacher_rows, ids.teachers[lesson] * numSlots + slot)
+          ->SetCoefficient(var, 1.0);
+    }
+    objective->SetCoefficient(var, phase_two ? pattern.cost : 0.0);
+    columns.push_back({lesson, std::move(pattern), var});
+    return true;
+  };
+
+  // Seed the pool with the hint's week of every lesson when it is one of
+  // the lesson's patterns, else with its pattern under zero prices.
+  std::vector<int> hinted(numLessons, -1); // Column of the hint
+  if (options.hint != nullptr) {
+    std::vector<std::vector<int>> hint_slots(numLessons);
+    for (const auto &entry : options.hint->GetEntries()) {
+      if (entry.lesson >= 0 && entry.lesson < numLessons) {
+        hint_slots[entry.lesson].push_back(entry.day * periods +
+                                           entry.period);
+      }
+    }
+    for (int i = 0; i < numLessons; ++i) {
+      std::sort(hint_slots[i].begin(), hint_slots[i].end());
+      WeeklyPattern pattern;
+      pattern.cost = pricers[i].GetCost(hint_slots[i]);
+      if (pattern.cost >= 0) {
+        pattern.slots = std::move(hint_slots[i]);
+        hinted[i]     = static_cast<int>(columns.size());
+        add_column(i, std::move(pattern));
+      }
+    }
+  }
+  const std::vector<double> zero(numSlots, 0.0);
+  for (int i = 0; i < numLessons; ++i) {
+    WeeklyPattern pattern;
+    double        value = 0.0;
+    if (hinted[i] < 0 && pricers[i].Price(zero, false, pattern, value)) {
+      add_column(i, std::move(pattern));
+    }
+  }
+
+  // Duals of the last LP solve. They are copied out before any column is
+  // added, since the solver drops its solution once the model changes.
+  std::vector<double> convexity_duals(numLessons, 0.0);
+  std::vector<double> class_duals(numClasses * numSlots, 0.0);
+  std::vector<double> teacher_duals(numTeachers * numSlots, 0.0);
+  std::vector<double> column_values;
+  auto read_solution = [&] {
+    for (int i = 0; i < numLessons; ++i) {
+      convexity_duals[i] = convexity[i]->dual_value();
+    }
+    for (size_t row = 0; row < class_rows.size(); ++row) {
+      class_duals[row] = class_rows[row] ? class_rows[row]->dual_value() : 0;
+    }
+    for (size_t row = 0; row < teacher_rows.size(); ++row) {
+      teacher_duals[row] =
+          teacher_rows[row] ? teacher_rows[row]->dual_value() : 0;
+    }
+    column_values.resize(columns.size());
+    for (size_t k = 0; k < columns.size(); ++k) {
+      column_values[k] = columns[k].var->solution_value();
+    }
+  };
+  // A slot costs a lesson what its class and teacher rows are worth.
+  auto slot_prices = [&](int lesson, std::vector<double> &prices) {
+    const int class_row   = ids.classes[lesson] * numSlots;
+    const int teacher_row = ids.teachers[lesson] * numSlots;
+    for (int slot = 0; slot < numSlots; ++slot) {
+      prices[slot] =
+          -(class_duals[class_row + slot] + teacher_duals[teacher_row + slot]);
+    }
+  };
+
+  const double budget = options.timeLimitSeconds > 0.0
+                            ? options.timeLimitSeconds * kPricingShare
+                            : 0.0;
+  std::vector<double> prices(numSlots);
+  double              bound     = 0.0; // Lagrangian bound of phase two
+  bool                converged = false;
+  bool                solved    = false;
+  int                 rounds    = 0;
+  while (rounds < kMaxPricingRounds) {
+    if ((options.stop != nullptr && *options.stop) ||
+        (budget > 0.0 && elapsed() > budget)) {
+      break;
+    }
+    ++rounds;
+    if (lp->Solve() != MPSolver::OPTIMAL) {
+      std::cerr << "Pattern master LP did not solve\n";
+      break;
+    }
+    solved = true;
+    read_solution();
+
+    // Pricing is exact, so the LP value plus every lesson's most negative
+    // reduced cost bounds the full master from below.
+    const double value      = objective->Value();
+    double       lagrangian = value;
+    int          added      = 0;
+    for (int i = 0; i < numLessons; ++i) {
+      WeeklyPattern pattern;
+      double        price = 0.0;
+      slot_prices(i, prices);
+      if (!pricers[i].Price(prices, phase_two, pattern, price)) {
+        continue;
+      }
+      const double reduced = price - convexity_duals[i];
+      if (reduced < -kEpsilon) {
+        lagrangian += reduced;
+        added += add_column(i, std::move(pattern)) ? 1 : 0;
+      }
+    }
+    if (phase_two) {
+      bound = std::max(bound, lagrangian);
+    }
+    if (added > 0) {
+      continue;
+    }
+
+    if (!phase_two) {
+      if (value > kEpsilon) {
+        // Not even a fractional week plan fits, so no timetable does.
+        std::cerr << "No combination of weekly patterns fits the config\n";
+        SetStatus(options, SolveStatus::Infeasible);
+        return false;
+      }
+      phase_two = true;
+      for (int i = 0; i < numLessons; ++i) {
+        artificial[i]->SetUB(0.0);
+        objective->SetCoefficient(artificial[i], 0.0);
+      }
+      for (const auto &column : columns) {
+        objective->SetCoefficient(column.var, column.pattern.cost);
+      }
+      continue;
+    }
+    bound     = value;
+    converged = true;
+    break;
+  }
+
+  if (solved) {
+    for (int round = 0; round < kDiversifyRounds; ++round) {
+      for (int i = 0; i < numLessons; ++i) {
+        slot_prices(i, prices);
+        for (const auto &column : columns) {
+          if (column.lesson != i) {
+            continue;
+          }
+          for (int slot : column.pattern.slots) {
+            prices[slot] += kDiversifyPenalty;
+          }
+        }
+        WeeklyPattern pattern;
+        double        price = 0.0;
+        if (pricers[i].Price(prices, true, pattern, price)) {
+          add_column(i, std::move(pattern));
+        }
+      }
+    }
+  }
+  if (phase_two && options.onBound) {
+    options.onBound(std::ceil(bound - kEpsilon));
+  }
+  generate.AddArg("rounds", std::to_string(rounds));
+  generate.AddArg("columns", std::to_string(columns.size()));
+  generate.AddArg("converged", converged ? "true" : "false");
+  generate.AddArg("bound", std::to_string(bound));
+  generate.End();
+
+  // Integer finishing: CP-SAT picks one pattern per lesson from the pool,
+  // with the daily rules compiled on the occupancy the picks give.
+  TraceSpan build(m_Trace, "build-model", "phase",
+                  {{"formulation", "pattern"}});
+
+  CpModelBuilder model;
+
+  std::vector<BoolVar>              literals(columns.size());
+  std::vector<std::vector<BoolVar>> lesson_literals(numLessons);
+  std::vector<std::vector<BoolVar>> class_literals(numClasses * numSlots);
+  std::vector<std::vector<BoolVar>> teacher_literals(numTeachers * numSlots);
+  for (size_t k = 0; k < columns.size(); ++k) {
+    const Column &column = columns[k];
+    literals[k]          = model.NewBoolVar().WithName(
+        "lesson_" + std::to_string(column.lesson) + "_pattern_" +
+        std::to_string(lesson_literals[column.lesson].size()));
+    lesson_literals[column.lesson].push_back(literals[k]);
+    for (int slot : column.pattern.slots) {
+      class_literals[ids.classes[column.lesson] * numSlots + slot].push_back(
+          literals[k]);
+      teacher_literals[ids.teachers[column.lesson] * numSlots + slot]
+          .push_back(literals[k]);
+    }
+  }
+  for (int i = 0; i < numLessons; ++i) {
+    model.AddExactlyOne(lesson_literals[i]);
+  }
+
+  // No teacher or class overlaps
+  OccupancyGrid class_occupancy(numClasses, std::vector<LinearExpr>(numSlots));
+  OccupancyGrid teacher_occupancy(numTeachers,
+                                  std::vector<LinearExpr>(numSlots));
+  for (int c = 0; c < numClasses; ++c) {
+    for (int slot = 0; slot < numSlots; ++slot) {
+      const auto &uses = class_literals[c * numSlots + slot];
+      if (uses.size() > 1) {
+        model.AddAtMostOne(uses);
+      }
+      class_occupancy[c][slot] = LinearExpr::Sum(uses);
+    }
+  }
+  for (int t = 0; t < numTeachers; ++t) {
+    for (int slot = 0; slot < numSlots; ++slot) {
+      const auto &uses = teacher_literals[t * numSlots + slot];
+      if (uses.size() > 1) {
+        model.AddAtMostOne(uses);
+      }
+      teacher_occupancy[t][slot] = LinearExpr::Sum(uses);
+    }
+  }
+
+  DailyRuleCompiler rules(model, days, periods);
+  for (const auto &rule : config.rules) {
+    rules.Compile(rule, class_occupancy, teacher_occupancy);
+  }
+  LinearExpr penalty;
+  bool       has_penalty = rules.HasPenalty();
+  if (has_penalty) {
+    penalty = rules.GetPenalty();
+  }
+  for (size_t k = 0; k < columns.size(); ++k) {
+    if (columns[k].pattern.cost > 0) {
+      penalty += LinearExpr::Term(literals[k], columns[k].pattern.cost);
+      has_penalty = true;
+    }
+  }
+  if (has_penalty && options.strategy != SolveStrategy::FirstFeasible) {
+    model.Minimize(penalty);
+  }
+
+  // Start from the hinted week, else from the pattern the LP used most.
+  for (int i = 0; i < numLessons; ++i) {
+    int best = hinted[i];
+    for (size_t k = 0; hinted[i] < 0 && k < column_values.size(); ++k) {
+      if (columns[k].lesson == i &&
+          (best < 0 || column_values[k] > column_values[best])) {
+        best = static_cast<int>(k);
+      }
+    }
+    if (best < 0) {
+      continue;
+    }
+    for (size_t k = 0; k < columns.size(); ++k) {
+      if (columns[k].lesson == i) {
+        model.AddHint(literals[k], static_cast<int>(k) == best);
+      }
+    }
+  }
+
+  const CpModelProto proto = model.Build();
+  build.AddArg("variables", std::to_string(proto.variables_size()));
+  build.AddArg("constraints", std::to_string(proto.constraints_size()));
+  build.End();
+
+  // CP-SAT only sees the pool, so its bound is not one of the full problem
+  // and its infeasibility proves nothing about the config.
+  SolveOptions finishing = options;
+  finishing.onBound      = nullptr;
+  if (options.timeLimitSeconds > 0.0) {
+    finishing.timeLimitSeconds =
+        std::max(options.timeLimitSeconds - elapsed(), 0.1);
+  }
+  auto extract = [&](const CpSolverResponse &response, Schedule &result) {
+    result = Schedule(days, periods, numClasses, numTeachers);
+    for (size_t k = 0; k < columns.size(); ++k) {
+      if (!SolutionBooleanValue(response, literals[k])) {
+        continue;
+      }
+      const int i = columns[k].lesson;
+      for (int slot : columns[k].pattern.slots) {
+        ScheduledLesson entry;
+        entry.lesson    = i;
+        entry.classId   = ids.classes[i];
+        entry.teacherId = ids.teachers[i];
+        entry.subjectId = ids.subjects[i];
+        entry.day       = slot / periods;
+        entry.period    = slot % periods;
+        result.Add(entry);
+      }
+    }
+  };
+
+  const CpSolverResponse response =
+      RunSolver(proto, config.memoryBudgetMb, finishing, extract);
+  if (response.status() == CpSolverStatus::INFEASIBLE) {
+    std::cerr << "No timetable combines the generated weekly patterns\n";
+    SetStatus(options, SolveStatus::Unknown);
+    return false;
+  }
+  if (response.status() != CpSolverStatus::FEASIBLE &&
+      response.status() != CpSolverStatus::OPTIMAL) {
+    return false;
+  }
+
+  TraceSpan span(m_Trace, "extract-schedule", "phase");
+  extract(response, schedule);
+  return true;
+}
+}; // namespace TimetableWeaver
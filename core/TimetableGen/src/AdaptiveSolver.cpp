@@ -0,0 +1,217 @@
+#include "AdaptiveSolver.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace TimetableWeaver
+{
+using Clock = std::chrono::steady_clock;
+
+static double SecondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+const char *GetStrategyName(SolveStrategy strategy)
+{
+  switch (strategy) {
+  case SolveStrategy::Default:
+    return "default";
+  case SolveStrategy::FirstFeasible:
+    return "first-feasible";
+  case SolveStrategy::Lns:
+    return "lns";
+  }
+  return "unknown";
+}
+
+// Points a backend at other observers for one Solve call and hands the
+// caller's back afterwards, so a shared backend is left as it was found.
+class ScopedObservers
+{
+public:
+  ScopedObservers(SolverBackend &backend, TraceRecorder *trace)
+      : m_Backend(backend), m_Trace(backend.GetTraceRecorder()),
+        m_Metrics(backend.GetMetrics())
+  {
+    m_Backend.SetTraceRecorder(trace);
+  }
+
+  ~ScopedObservers()
+  {
+    m_Backend.SetTraceRecorder(m_Trace);
+    m_Backend.SetMetrics(m_Metrics);
+  }
+
+  ScopedObservers(const ScopedObservers &)            = delete;
+  ScopedObservers &operator=(const ScopedObservers &) = delete;
+
+private:
+  SolverBackend &m_Backend;
+  TraceRecorder *m_Trace;
+  SolverMetrics *m_Metrics;
+};
+
+/**
+ * AdaptiveSolver
+ */
+AdaptiveSolver::AdaptiveSolver(std::shared_ptr<SolverBackend> inner,
+                               const AdaptiveOptions         &options)
+    : m_Inner(std::move(inner)), m_Options(options)
+{
+}
+
+bool AdaptiveSolver::Solve(const TimetableConfig &config, Schedule &schedule,
+                           const SolveOptions &options)
+{
+  if (!m_Inner) {
+    std::cerr << "Adaptive solver has no inner backend\n";
+    return false;
+  }
+
+  const Clock::time_point start = Clock::now();
+  double budget = m_Options.budgetSeconds;
+  if (options.timeLimitSeconds > 0.0 && options.timeLimitSeconds < budget) {
+    budget = options.timeLimitSeconds;
+  }
+
+  m_Phases.clear();
+  ScopedObservers observers(*m_Inner, m_Trace);
+
+  Schedule      best;
+  bool          haveBest      = false;
+  bool          bestHasScore  = false;
+  double        bestObjective = 0.0;
+  SolveStrategy strategy      = options.strategy;
+  SolveStatus   status        = SolveStatus::Unknown;
+
+  while (SecondsSince(start) < budget) {
+    // Progress of the running phase, written from solver threads.
+    std::mutex        mutex;
+    bool              found       = false;
+    double            objective   = 0.0;
+    Clock::time_point lastChange  = Clock::now();
+    std::atomic<bool> stop{false};
+    std::atomic<bool> done{false};
+
+    SolveStrategy next   = strategy;
+    std::string   reason = "finished";
+
+    SolveOptions phase;
+    phase.strategy         = strategy;
+    phase.timeLimitSeconds = budget - SecondsSince(start);
+    phase.hint             = haveBest ? &best : options.hint;
+    phase.pinned           = options.pinned;
+    phase.numWorkers       = options.numWorkers;
+    phase.stop             = &stop;
+    phase.status           = &status;
+    phase.onSchedule       = options.onSchedule;
+    phase.onSolution       = [&](const SolveProgress &progress) {
+      std::lock_guard<std::mutex> lock(mutex);
+      found      = true;
+      objective  = progress.objective;
+      lastChange = Clock::now();
+      if (options.onSolution) {
+        options.onSolution({progress.objective, progress.bound,
+                            SecondsSince(start)});
+      }
+    };
+    phase.onBound = [&](double bound) {
+      std::lock_guard<std::mutex> lock(mutex);
+      lastChange = Clock::now();
+      if (options.onBound) {
+        options.onBound(bound);
+      }
+    };
+
+    std::thread watchdog([&]() {
+      const auto poll = std::chrono::duration<double>(m_Options.pollSeconds);
+      while (!done && !stop) {
+        std::this_thread::sleep_for(poll);
+        if (options.stop != nullptr && *options.stop) {
+          reason = "cancelled";
+          stop   = true;
+          break;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool anySchedule = found || haveBest;
+        if (!anySchedule && strategy != SolveStrategy::FirstFeasible &&
+            SecondsSince(start) >= m_Options.feasibilityFraction * budget) {
+          next   = SolveStrategy::FirstFeasible;
+          reason = "no schedule yet";
+          stop   = true;
+        } else if (anySchedule && strategy != SolveStrategy::FirstFeasible &&
+                   SecondsSince(lastChange) >= m_Options.stallSeconds) {
+          next   = strategy == SolveStrategy::Lns ? SolveStrategy::Default
+                                                  : SolveStrategy::Lns;
+          reason = "stalled";
+          stop   = true;
+        }
+      }
+    });
+
+    // Only the first phase measures time to first solution.
+    m_Inner->SetMetrics(m_Phases.empty() ? m_Metrics : nullptr);
+
+    const Clock::time_point phaseStart = Clock::now();
+    TraceSpan span(m_Trace, "adaptive-phase", "phase",
+                   {{"strategy", GetStrategyName(strategy)}});
+
+    Schedule   candidate;
+    const bool solved = m_Inner->Solve(config, candidate, phase);
+    done              = true;
+    watchdog.join();
+
+    AdaptivePhase report;
+    report.strategy  = strategy;
+    report.seconds   = SecondsSince(phaseStart);
+    report.solved    = solved;
+    report.objective = objective;
+    report.reason    = reason;
+    m_Phases.push_back(report);
+    span.AddArg("reason", reason);
+    span.End();
+
+    // First-feasible runs ignore the objective, so their schedule only
+    // counts when nothing else has been found.
+    const bool scored = strategy != SolveStrategy::FirstFeasible && found;
+    if (solved && (!haveBest || (scored && (!bestHasScore ||
+                                            objective <= bestObjective)))) {
+      best          = std::move(candidate);
+      haveBest      = true;
+      bestHasScore  = scored;
+      bestObjective = objective;
+    }
+
+    if (reason == "cancelled") {
+      if (m_Metrics != nullptr) {
+        m_Metrics->cancellations.Increment();
+      }
+      break;
+    }
+    if (!stop) {
+      // The inner solve ended on its own: proven optimal or infeasible, or
+      // out of time. A first-feasible schedule still wants optimising.
+      if (strategy == SolveStrategy::FirstFeasible && solved) {
+        strategy = SolveStrategy::Lns;
+        continue;
+      }
+      break;
+    }
+    strategy = next;
+  }
+
+  if (options.status != nullptr) {
+    // A later phase may have run out of time after an earlier one solved.
+    *options.status = haveBest ? SolveStatus::Feasible : status;
+  }
+  if (!haveBest) {
+    return false;
+  }
+  schedule = std::move(best);
+  return true;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SolverBackend.hpp"
+
+namespace TimetableWeaver
+{
+struct AdaptiveOptions {
+  double budgetSeconds = 60.0; // Wall clock for the whole solve
+
+  // Without any schedule after this share of the budget, give up on the
+  // objective and search for feasibility alone.
+  double feasibilityFraction = 0.2;
+
+  // With neither a better schedule nor a bound move for this long, switch
+  // between portfolio search and neighbourhood search.
+  double stallSeconds = 10.0;
+
+  double pollSeconds = 0.05;
+};
+
+struct AdaptivePhase {
+  SolveStrategy strategy  = SolveStrategy::Default;
+  double        seconds   = 0.0;
+  bool          solved    = false;
+  double        objective = 0.0;
+  std::string   reason; // Why the phase ended
+};
+
+// Backend that drives another backend through several strategies within a
+// fixed wall-clock budget. A watchdog thread follows the solution and
+// bound callbacks; when the run is not finding schedules, or has stalled,
+// it stops the inner solve and restarts it with another strategy, passing
+// the best schedule so far as the hint.
+class AdaptiveSolver : public SolverBackend
+{
+public:
+  AdaptiveSolver(std::shared_ptr<SolverBackend> inner,
+                 const AdaptiveOptions         &options = AdaptiveOptions());
+
+  const char *GetName() const override { return "adaptive"; }
+
+  using SolverBackend::Solve;
+  bool Solve(const TimetableConfig &config, Schedule &schedule,
+             const SolveOptions &options) override;
+
+  const std::vector<AdaptivePhase> &GetPhases() const { return m_Phases; }
+
+private:
+  std::shared_ptr<SolverBackend> m_Inner;
+  AdaptiveOptions                m_Options;
+  std::vector<AdaptivePhase>     m_Phases;
+};
+
+const char *GetStrategyName(SolveStrategy strategy);
+}; // namespace TimetableWeaver
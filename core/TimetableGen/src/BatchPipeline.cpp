@@ -0,0 +1,228 @@
+#include "BatchPipeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+#include "ModelEstimate.hpp"
+
+namespace TimetableWeaver
+{
+using JobQueue = BoundedQueue<std::unique_ptr<BatchJob>>;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * BatchPipeline
+ */
+BatchPipeline::BatchPipeline(std::shared_ptr<SolverBackend> backend,
+                             const BatchStages             &stages,
+                             const BatchOptions            &options)
+    : m_Backend(std::move(backend)), m_Stages(stages), m_Options(options)
+{
+}
+
+BatchReport BatchPipeline::Run(int count)
+{
+  BatchReport report;
+  const auto  start = std::chrono::steady_clock::now();
+
+  if (!m_Stages.load) {
+    std::cerr << "Batch pipeline has no load stage\n";
+    return report;
+  }
+  if (!m_Backend) {
+    m_Backend = LoadSolverBackend();
+  }
+  if (!m_Backend) {
+    std::cerr << "No solver backend available\n";
+    return report;
+  }
+
+  std::mutex reportMutex;
+  auto       drop = [&]() {
+    std::lock_guard<std::mutex> lock(reportMutex);
+    ++report.failed;
+  };
+  auto finish = [&](const BatchJob &job) {
+    std::lock_guard<std::mutex> lock(reportMutex);
+    ++report.jobs;
+    report.solved += job.solved ? 1 : 0;
+    report.total.load += job.timings.load;
+    report.total.build += job.timings.build;
+    report.total.solve += job.timings.solve;
+    report.total.publish += job.timings.publish;
+  };
+
+  if (!m_Options.overlap) {
+    for (int i = 0; i < count; ++i) {
+      BatchJob job;
+      job.index = i;
+      if (Load(job) && Build(job)) {
+        Solve(job, nullptr);
+        Publish(job);
+        finish(job);
+      } else {
+        drop();
+      }
+    }
+    report.wallSeconds = SecondsSince(start);
+    return report;
+  }
+
+  JobQueue loaded(m_Options.queueCapacity);
+  JobQueue built(m_Options.queueCapacity);
+  JobQueue solved(m_Options.queueCapacity);
+
+  // Starts a stage's threads. The last one to finish closes the output
+  // queue, which ends the next stage once it has drained.
+  std::vector<std::thread> threads;
+  auto                     stage = [&](int size, JobQueue *out, auto work) {
+    const int workers = std::max(1, size);
+    auto      running = std::make_shared<std::atomic<int>>(workers);
+    for (int t = 0; t < workers; ++t) {
+      threads.emplace_back([=]() {
+        work();
+        if (--*running == 0 && out != nullptr) {
+          out->Close();
+        }
+      });
+    }
+  };
+
+  std::atomic<int> next{0};
+  stage(m_Options.loadThreads, &loaded, [&]() {
+    for (int i = next++; i < count; i = next++) {
+      auto job   = std::make_unique<BatchJob>();
+      job->index = i;
+      if (!Load(*job)) {
+        drop();
+      } else if (!loaded.Push(std::move(job))) {
+        return;
+      }
+    }
+  });
+  stage(m_Options.buildThreads, &built, [&]() {
+    std::unique_ptr<BatchJob> job;
+    while (loaded.Pop(job)) {
+      if (Build(*job)) {
+        if (m_Metrics != nullptr) {
+          m_Metrics->queueDepth.Add(1);
+        }
+        built.Push(std::move(job));
+      } else {
+        drop();
+      }
+    }
+  });
+
+  // Each solve thread stays on its partition; on Linux the CP-SAT workers
+  // it starts inherit the mask, elsewhere only the solve thread is pinned.
+  // Backends that keep per-solve state in members get one solve thread.
+  const int solveThreads =
+      m_Backend->IsReentrant() ? std::max(1, m_Options.solveThreads) : 1;
+  std::vector<CpuPartition> partitions;
+  if (m_Options.placeSolves) {
+    partitions = PartitionCpus(CpuTopology::Detect(), solveThreads);
+  }
+  std::atomic<int> slot{0};
+  stage(solveThreads, &solved, [&]() {
+    const CpuPartition *partition =
+        partitions.empty() ? nullptr : &partitions[slot++];
+    std::unique_ptr<ScopedAffinity> affinity;
+    if (partition != nullptr) {
+      affinity = std::make_unique<ScopedAffinity>(*partition);
+    }
+    std::unique_ptr<BatchJob> job;
+    while (built.Pop(job)) {
+      if (m_Metrics != nullptr) {
+        m_Metrics->queueDepth.Add(-1);
+      }
+      Solve(*job, partition);
+      solved.Push(std::move(job));
+    }
+  });
+  stage(m_Options.publishThreads, nullptr, [&]() {
+    std::unique_ptr<BatchJob> job;
+    while (solved.Pop(job)) {
+      Publish(*job);
+      finish(*job);
+    }
+  });
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  report.wallSeconds = SecondsSince(start);
+  return report;
+}
+
+bool BatchPipeline::Load(BatchJob &job) const
+{
+  const auto start  = std::chrono::steady_clock::now();
+  const bool loaded = m_Stages.load(job);
+  job.timings.load  = SecondsSince(start);
+  return loaded;
+}
+
+bool BatchPipeline::Build(BatchJob &job) const
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  job.options = m_Options.solve;
+  if (job.options.formulation == Formulation::Auto) {
+    const auto estimates = EstimateModels(job.config);
+    const int  choice =
+        SelectFormulation(estimates, job.config.memoryBudgetMb);
+    if (choice < 0) {
+      std::cerr << "No usable formulation for " << job.name << "\n";
+      job.timings.build = SecondsSince(start);
+      return false;
+    }
+    job.options.formulation = estimates[choice].formulation;
+  }
+
+  const bool built  = !m_Stages.build || m_Stages.build(job);
+  job.timings.build = SecondsSince(start);
+  return built;
+}
+
+void BatchPipeline::Solve(BatchJob &job, const CpuPartition *partition) const
+{
+  const auto start = std::chrono::steady_clock::now();
+  if (partition != nullptr) {
+    job.options.numWorkers = partition->GetWorkerCount();
+  }
+  if (m_Metrics != nullptr) {
+    m_Metrics->solves.Increment();
+    m_Metrics->activeSolves.Add(1);
+  }
+  job.solved        = m_Backend->Solve(job.config, job.schedule, job.options);
+  job.timings.solve = SecondsSince(start);
+  if (m_Metrics != nullptr) {
+    m_Metrics->activeSolves.Add(-1);
+    m_Metrics->solveSeconds.Observe(job.timings.solve);
+    if (!job.solved) {
+      m_Metrics->failures.Increment();
+    }
+  }
+}
+
+void BatchPipeline::Publish(BatchJob &job) const
+{
+  const auto start = std::chrono::steady_clock::now();
+  if (m_Stages.publish) {
+    m_Stages.publish(job);
+  }
+  job.timings.publish = SecondsSince(start);
+}
+}; // namespace TimetableWeaver
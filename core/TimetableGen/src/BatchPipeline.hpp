@@ -0,0 +1,115 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "CpuPlacement.hpp"
+#include "Metrics.hpp"
+#include "Schedule.hpp"
+#include "SolverBackend.hpp"
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+// Busy time per stage, in seconds.
+struct BatchTimings {
+  double load    = 0.0;
+  double build   = 0.0;
+  double solve   = 0.0;
+  double publish = 0.0;
+};
+
+// One school's run as it moves through the pipeline.
+struct BatchJob {
+  int             index = 0;
+  std::string     name;
+  TimetableConfig config;
+  SolveOptions    options; // Copied from BatchOptions::solve
+  Schedule        schedule;
+  bool            solved = false;
+  BatchTimings    timings;
+};
+
+struct BatchStages {
+  // Fills the config, and optionally the name, of job `index`. Returning
+  // false drops the job. Required.
+  std::function<bool(BatchJob &job)> load;
+
+  // Extra indexing after the formulation was picked; false drops the job.
+  std::function<bool(BatchJob &job)> build;
+
+  // Validates and writes the result; also called for unsolved jobs.
+  std::function<void(BatchJob &job)> publish;
+};
+
+struct BatchOptions {
+  int loadThreads    = 2;
+  int buildThreads   = 1;
+  int solveThreads   = 1; // Concurrent solves if the backend is reentrant
+  int publishThreads = 2;
+  int queueCapacity  = 2; // Jobs waiting between two stages
+
+  // False runs every job through all stages on the calling thread, one
+  // after another, as a baseline.
+  bool overlap = true;
+
+  // Gives each solve thread its own partition of the CPUs, see
+  // PartitionCpus, pins it there and runs as many CP-SAT workers as the
+  // partition has cores, so concurrent solves do not compete for cores,
+  // SMT siblings or memory bandwidth on another NUMA node. Only used when
+  // overlapping.
+  bool placeSolves = false;
+
+  // Template for every job's solve, e.g. a time limit.
+  SolveOptions solve;
+};
+
+struct BatchReport {
+  int          jobs        = 0; // Published
+  int          solved      = 0;
+  int          failed      = 0; // Dropped by the load or build stage
+  double       wallSeconds = 0.0;
+  BatchTimings total; // Summed over jobs
+};
+
+// Batch runner for many schools. Each job passes load, build, solve and
+// publish stages; every stage has its own threads and hands jobs on through
+// a bounded queue, so the next schools are loaded and built while the
+// current ones solve, and results are written while later ones solve.
+// With the solve stage the bottleneck, the wall time of a batch approaches
+// the sum of its solve times.
+//
+// The build stage picks each job's formulation from the model estimates,
+// which keeps that work off the solve threads, then runs the optional
+// build callback. The solver model itself is still built inside
+// SolverBackend::Solve, on the solve threads, since backends have no way
+// to build a model ahead of the solve. Stage callbacks run concurrently
+// with themselves when a stage has more than one thread.
+class BatchPipeline
+{
+public:
+  // The OR-tools module is loaded on the first run when no backend is set.
+  BatchPipeline(std::shared_ptr<SolverBackend> backend,
+                const BatchStages             &stages,
+                const BatchOptions            &options = BatchOptions());
+
+  // Runs jobs 0 to count - 1 and returns when all are published.
+  BatchReport Run(int count);
+
+  // Counts solves, their timings and the built jobs waiting for a solve
+  // thread into `metrics`.
+  void SetMetrics(SolverMetrics *metrics) { m_Metrics = metrics; }
+
+private:
+  bool Load(BatchJob &job) const;
+  bool Build(BatchJob &job) const;
+  void Solve(BatchJob &job, const CpuPartition *partition) const;
+  void Publish(BatchJob &job) const;
+
+  std::shared_ptr<SolverBackend> m_Backend;
+  BatchStages                    m_Stages;
+  BatchOptions                   m_Options;
+  SolverMetrics                 *m_Metrics = nullptr;
+};
+}; // namespace TimetableWeaver
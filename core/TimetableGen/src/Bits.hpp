@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace TimetableWeaver
+{
+// Portable bit helpers for the availability and occupancy masks. Callers
+// must not pass zero to the count-zeros functions.
+
+inline int PopCount(uint32_t value)
+{
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt(value));
+#else
+  return __builtin_popcount(value);
+#endif
+}
+
+inline int PopCount(uint64_t value)
+{
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt64(value));
+#else
+  return __builtin_popcountll(value);
+#endif
+}
+
+inline int CountTrailingZeros(uint32_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+inline int CountTrailingZeros(uint64_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+inline int CountLeadingZeros(uint32_t value)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanReverse(&index, value);
+  return 31 - static_cast<int>(index);
+#else
+  return __builtin_clz(value);
+#endif
+}
+
+// Free periods between the first and the last busy period of a day mask.
+inline int GapCount(uint32_t mask)
+{
+  if (mask == 0) {
+    return 0;
+  }
+  uint32_t low  = mask & (~mask + 1);
+  uint32_t high = uint32_t(1) << (31 - CountLeadingZeros(mask));
+  return PopCount((high - low) & ~mask);
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,394 @@
+#include "BitsetSolver.hpp"
+
+#include <algorithm>
+#include <climits>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+// Availability supports at most seven days.
+static const int kMaxDays = 7;
+
+// Tightest MaxPerDay limit among the rules, or one past any day's length.
+static int GetDayLimit(const std::vector<DailyRule> &rules)
+{
+  int limit = 32;
+  for (const auto &rule : rules) {
+    if (rule.kind == DailyRuleKind::MaxPerDay && rule.limit < limit) {
+      limit = rule.limit;
+    }
+  }
+  return limit;
+}
+
+/**
+ * BitsetSolver
+ */
+bool BitsetSolver::CanSolve(const TimetableConfig &config)
+{
+  if (config.days > kMaxDays) {
+    return false;
+  }
+
+  int weeklyPeriods = 0;
+  for (const auto &lesson : config.lessons) {
+    weeklyPeriods += lesson->GetPeriodsPerWeek();
+  }
+  if (weeklyPeriods > kMaxWeeklyPeriods) {
+    return false;
+  }
+
+  // Subgroups share class slots, which one busy mask per class cannot
+  // express.
+  if (config.HasSubgroupLessons()) {
+    return false;
+  }
+
+  // Spreads shape a lesson's whole week, which the search does not track.
+  if (!config.spreads.empty()) {
+    return false;
+  }
+
+  // Soft rules need an objective and NoGaps can only be judged on a
+  // finished day, so both are left to the CP-SAT backend.
+  for (const auto &rule : config.rules) {
+    if (!rule.hard || rule.kind == DailyRuleKind::NoGaps) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BitsetSolver::Solve(const TimetableConfig &config, Schedule &schedule,
+                         const SolveOptions &options)
+{
+  const bool found = Run(config, options, schedule);
+  if (found && options.onSchedule) {
+    options.onSchedule(schedule);
+  }
+  if (options.status != nullptr) {
+    *options.status = found        ? SolveStatus::Feasible
+                      : m_Exhausted ? SolveStatus::Infeasible
+                                    : SolveStatus::Unknown;
+  }
+  return found;
+}
+
+bool BitsetSolver::Run(const TimetableConfig &config,
+                       const SolveOptions &options, Schedule &schedule)
+{
+  TraceSpan span(m_Trace, "bitset-search", "phase");
+
+  m_Days      = config.days;
+  m_Periods   = config.periodsPerDay;
+  m_Stop      = options.stop;
+  m_Nodes     = 0;
+  m_Exhausted = false;
+
+  const int numLessons  = static_cast<int>(config.lessons.size());
+  const int numClasses  = static_cast<int>(config.classes.size());
+  const int numTeachers = static_cast<int>(config.teachers.size());
+
+  m_Units.clear();
+  m_Allowed.clear();
+  m_ClassBusy.assign(numClasses * m_Days, 0);
+  m_TeacherBusy.assign(numTeachers * m_Days, 0);
+
+  const LessonIds  ids = config.GetLessonIds();
+  std::vector<int> unitOf(numLessons);
+  for (int i = 0; i < numLessons; ++i) {
+    const auto &lesson    = config.lessons[i];
+    const int   classId   = ids.classes[i];
+    const int   teacherId = ids.teachers[i];
+    if (classId < 0 || teacherId < 0) {
+      std::cerr << "Lesson uses a class or teacher missing from the config\n";
+      m_Exhausted = true;
+      return false;
+    }
+
+    auto unit =
+        std::find_if(m_Units.begin(), m_Units.end(), [&](const Unit &u) {
+          return u.classId == classId && u.teacherId == teacherId;
+        });
+    if (unit == m_Units.end()) {
+      unit            = m_Units.insert(m_Units.end(), Unit());
+      unit->classId   = classId;
+      unit->teacherId = teacherId;
+      for (int d = 0; d < m_Days; ++d) {
+        m_Allowed.push_back(lesson->GetClass()->GetAvailability().GetDay(d) &
+                            lesson->GetTeacher()->GetAvailability().GetDay(d));
+      }
+    }
+    unit->remaining += lesson->GetPeriodsPerWeek();
+    unit->lessons.push_back(i);
+    unitOf[i] = static_cast<int>(unit - m_Units.begin());
+  }
+
+  m_ClassRules.assign(numClasses, {});
+  m_TeacherRules.assign(numTeachers, {});
+  for (const auto &rule : config.rules) {
+    auto &rules =
+        rule.target == RuleTarget::Classes ? m_ClassRules : m_TeacherRules;
+    for (size_t e = 0; e < rules.size(); ++e) {
+      if (rule.entityId < 0 || rule.entityId == static_cast<int>(e)) {
+        rules[e].push_back(rule);
+      }
+    }
+  }
+
+  m_ClassDayLimit.resize(numClasses);
+  m_TeacherDayLimit.resize(numTeachers);
+  for (int c = 0; c < numClasses; ++c) {
+    m_ClassDayLimit[c] = GetDayLimit(m_ClassRules[c]);
+  }
+  for (int t = 0; t < numTeachers; ++t) {
+    m_TeacherDayLimit[t] = GetDayLimit(m_TeacherRules[t]);
+  }
+
+  m_ClassOpen.assign(numClasses * m_Days, 0);
+  m_TeacherOpen.assign(numTeachers * m_Days, 0);
+  m_ClassDemand.assign(numClasses, 0);
+  m_TeacherDemand.assign(numTeachers, 0);
+
+  // Pinned periods are placed up front and never revisited; a pin outside
+  // the lesson's slots, on a busy slot or breaking a rule is infeasible.
+  std::vector<std::vector<int>> pinnedSlots(numLessons);
+  for (const auto &pin : options.pinned) {
+    if (pin.lesson < 0 || pin.lesson >= numLessons || pin.day < 0 ||
+        pin.day >= m_Days || pin.period < 0 || pin.period >= m_Periods) {
+      m_Exhausted = true;
+      return false;
+    }
+    Unit          &unit    = m_Units[unitOf[pin.lesson]];
+    const uint32_t bit     = 1u << pin.period;
+    uint32_t      &classes = m_ClassBusy[unit.classId * m_Days + pin.day];
+    uint32_t      &teacher = m_TeacherBusy[unit.teacherId * m_Days + pin.day];
+    const int      periods = config.lessons[pin.lesson]->GetPeriodsPerWeek();
+    if ((m_Allowed[unitOf[pin.lesson] * m_Days + pin.day] & bit) == 0 ||
+        ((classes | teacher) & bit) != 0 ||
+        static_cast<int>(pinnedSlots[pin.lesson].size()) >= periods ||
+        !RulesAllow(m_ClassRules[unit.classId], classes | bit) ||
+        !RulesAllow(m_TeacherRules[unit.teacherId], teacher | bit)) {
+      m_Exhausted = true;
+      return false;
+    }
+    classes |= bit;
+    teacher |= bit;
+    unit.remaining--;
+    pinnedSlots[pin.lesson].push_back(pin.day * m_Periods + pin.period);
+  }
+
+  const bool found = Search();
+  span.AddArg("nodes", std::to_string(m_Nodes));
+  if (!found) {
+    m_Exhausted = m_Nodes <= m_NodeLimit && !(m_Stop != nullptr && *m_Stop);
+    return false;
+  }
+
+  // Hand the unit's slots to its lessons in order, after their pins.
+  schedule = Schedule(m_Days, m_Periods, numClasses, numTeachers);
+  for (const Unit &unit : m_Units) {
+    size_t next = 0;
+    for (int index : unit.lessons) {
+      const auto      &lesson = config.lessons[index];
+      std::vector<int> slots  = pinnedSlots[index];
+      while (static_cast<int>(slots.size()) < lesson->GetPeriodsPerWeek()) {
+        slots.push_back(unit.placed[next++]);
+      }
+      for (int slot : slots) {
+        ScheduledLesson entry;
+        entry.lesson    = index;
+        entry.classId   = unit.classId;
+        entry.teacherId = unit.teacherId;
+        entry.subjectId = ids.subjects[index];
+        entry.day       = slot / m_Periods;
+        entry.period    = slot % m_Periods;
+        schedule.Add(entry);
+      }
+    }
+  }
+  return true;
+}
+
+// Free slots of the unit after its last placed period, as per-day masks.
+int BitsetSolver::CountCandidates(const Unit &unit, uint32_t *masks) const
+{
+  const uint32_t *allowed = &m_Allowed[(&unit - m_Units.data()) * m_Days];
+  const uint32_t *classes = &m_ClassBusy[unit.classId * m_Days];
+  const uint32_t *teacher = &m_TeacherBusy[unit.teacherId * m_Days];
+
+  const int lastDay    = unit.lastSlot < 0 ? -1 : unit.lastSlot / m_Periods;
+  const int lastPeriod = unit.lastSlot < 0 ? -1 : unit.lastSlot % m_Periods;
+
+  int count = 0;
+  for (int d = 0; d < m_Days; ++d) {
+    uint32_t mask = 0;
+    if (d >= lastDay) {
+      mask = allowed[d] & ~classes[d] & ~teacher[d];
+      if (d == lastDay) {
+        mask &= ~((2u << lastPeriod) - 1); // 2u << 31 wraps to 0: no bits
+      }
+    }
+    masks[d] = mask;
+    count += PopCount(mask);
+  }
+  return count;
+}
+
+bool BitsetSolver::RulesAllow(const std::vector<DailyRule> &rules,
+                              uint32_t                      dayMask) const
+{
+  for (const auto &rule : rules) {
+    switch (rule.kind) {
+    case DailyRuleKind::MaxPerDay:
+      if (PopCount(dayMask) > rule.limit) {
+        return false;
+      }
+      break;
+    case DailyRuleKind::MaxConsecutive: {
+      // Bit p survives k shifts when periods p..p+k are all busy.
+      uint32_t run = dayMask;
+      for (int k = 1; k <= rule.limit && run != 0; ++k) {
+        run &= dayMask >> k;
+      }
+      if (run != 0) {
+        return false;
+      }
+      break;
+    }
+    case DailyRuleKind::Break: {
+      const int first = rule.firstPeriod < 0 ? 0 : rule.firstPeriod;
+      const int last  = rule.lastPeriod >= m_Periods ? m_Periods - 1
+                                                     : rule.lastPeriod;
+      if (first > last) {
+        break;
+      }
+      const uint32_t window =
+          static_cast<uint32_t>((uint64_t(1) << (last + 1)) - 1) &
+          ~((uint32_t(1) << first) - 1);
+      if ((dayMask & window) == window) {
+        return false;
+      }
+      break;
+    }
+    case DailyRuleKind::NoGaps:
+      break; // Rejected by CanSolve
+    }
+  }
+  return true;
+}
+
+bool BitsetSolver::Search()
+{
+  if (++m_Nodes > m_NodeLimit || (m_Stop != nullptr && *m_Stop)) {
+    return false;
+  }
+
+  // Most constrained first; any unit with fewer free slots than periods
+  // left fails the forward check for this whole branch.
+  std::fill(m_ClassOpen.begin(), m_ClassOpen.end(), 0);
+  std::fill(m_TeacherOpen.begin(), m_TeacherOpen.end(), 0);
+  std::fill(m_ClassDemand.begin(), m_ClassDemand.end(), 0);
+  std::fill(m_TeacherDemand.begin(), m_TeacherDemand.end(), 0);
+
+  int      best      = -1;
+  int      bestCount = INT_MAX;
+  uint32_t bestMasks[kMaxDays];
+  for (size_t u = 0; u < m_Units.size(); ++u) {
+    const Unit &unit = m_Units[u];
+    if (unit.remaining == 0) {
+      continue;
+    }
+    uint32_t  masks[kMaxDays];
+    const int count = CountCandidates(unit, masks);
+    if (count < unit.remaining) {
+      return false;
+    }
+    if (count < bestCount) {
+      best      = static_cast<int>(u);
+      bestCount = count;
+      std::copy(masks, masks + m_Days, bestMasks);
+    }
+
+    for (int d = 0; d < m_Days; ++d) {
+      m_ClassOpen[unit.classId * m_Days + d] |= masks[d];
+      m_TeacherOpen[unit.teacherId * m_Days + d] |= masks[d];
+    }
+    m_ClassDemand[unit.classId] += unit.remaining;
+    m_TeacherDemand[unit.teacherId] += unit.remaining;
+  }
+  if (best < 0) {
+    return true;
+  }
+
+  // Units of one class or teacher compete for the same slots.
+  // A MaxPerDay rule caps what each day can still take.
+  auto covered = [&](const ArenaVector<uint32_t> &open,
+                     const ArenaVector<uint32_t> &busy,
+                     const ArenaVector<int>      &demand,
+                     const ArenaVector<int>      &dayLimit) {
+    for (size_t e = 0; e < demand.size(); ++e) {
+      int supply = 0;
+      for (int d = 0; d < m_Days && supply < demand[e]; ++d) {
+        const int left = dayLimit[e] - PopCount(busy[e * m_Days + d]);
+        supply += std::min(PopCount(open[e * m_Days + d]), left);
+      }
+      if (supply < demand[e]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!covered(m_ClassOpen, m_ClassBusy, m_ClassDemand, m_ClassDayLimit) ||
+      !covered(m_TeacherOpen, m_TeacherBusy, m_TeacherDemand,
+               m_TeacherDayLimit)) {
+    return false;
+  }
+
+  Unit     &unit    = m_Units[best];
+  uint32_t *classes = &m_ClassBusy[unit.classId * m_Days];
+  uint32_t *teacher = &m_TeacherBusy[unit.teacherId * m_Days];
+  int       left    = bestCount;
+
+  for (int d = 0; d < m_Days; ++d) {
+    for (uint32_t mask = bestMasks[d]; mask != 0; mask &= mask - 1) {
+      // The chosen slot is the lowest of the remaining periods; the others
+      // need enough candidates after it.
+      if (left < unit.remaining) {
+        return false;
+      }
+      --left;
+
+      const int      p   = CountTrailingZeros(mask);
+      const uint32_t bit = 1u << p;
+      if (!RulesAllow(m_ClassRules[unit.classId], classes[d] | bit) ||
+          !RulesAllow(m_TeacherRules[unit.teacherId], teacher[d] | bit)) {
+        continue;
+      }
+
+      const int lastSlot = unit.lastSlot;
+      classes[d] |= bit;
+      teacher[d] |= bit;
+      unit.remaining--;
+      unit.lastSlot = d * m_Periods + p;
+      unit.placed.push_back(unit.lastSlot);
+
+      if (Search()) {
+        return true;
+      }
+
+      unit.placed.pop_back();
+      unit.lastSlot = lastSlot;
+      unit.remaining++;
+      classes[d] &= ~bit;
+      teacher[d] &= ~bit;
+
+      if (m_Nodes > m_NodeLimit || (m_Stop != nullptr && *m_Stop)) {
+        return false;
+      }
+    }
+  }
+  return false;
+}
+}; // namespace TimetableWeaver
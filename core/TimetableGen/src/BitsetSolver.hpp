@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RequestArena.hpp"
+#include "SolverBackend.hpp"
+
+namespace TimetableWeaver
+{
+// Exact backtracking solver for small configs, working directly on the
+// uint32 period masks. Lessons sharing a class and teacher are
+// interchangeable and searched as one unit. The search branches on the
+// unit with the fewest free slots left, places its periods in increasing
+// slot order, and forward checks every other unit by AND-ing the class and
+// teacher busy masks into its availability; a class or teacher whose open
+// slots cannot cover its remaining periods prunes the branch. Hard daily
+// rules other than NoGaps are checked on the day mask of every placement.
+//
+// It has no start-up cost, so for a few dozen lesson periods it answers in
+// microseconds where CP-SAT needs milliseconds to build and presolve.
+class BitsetSolver : public SolverBackend
+{
+public:
+  // Weekly periods up to which Timetable dispatches here automatically.
+  static const int kMaxWeeklyPeriods = 64;
+
+  // Search nodes before giving up, roughly 10 ms. Tight instances that
+  // need more are cheaper to hand to CP-SAT than to prove here.
+  static const int64_t kDefaultNodeLimit = 20000;
+
+  explicit BitsetSolver(int64_t nodeLimit = kDefaultNodeLimit)
+      : m_NodeLimit(nodeLimit)
+  {
+  }
+
+  const char *GetName() const override { return "bitset"; }
+
+  // True when every rule is hard and supported, no lesson targets a
+  // subgroup and the config is small enough for the search to stay fast.
+  static bool CanSolve(const TimetableConfig &config);
+
+  using SolverBackend::Solve;
+  bool Solve(const TimetableConfig &config, Schedule &schedule,
+             const SolveOptions &options) override;
+
+  // After a failed Solve: true when infeasibility was proven, false when
+  // the node limit or a stop request ended the search.
+  bool IsExhausted() const { return m_Exhausted; }
+
+  int64_t GetNodeCount() const { return m_Nodes; }
+
+private:
+  struct Unit {
+    int classId   = 0;
+    int teacherId = 0;
+    int remaining = 0;  // Periods still to place
+    int lastSlot  = -1; // Periods are placed in increasing slot order
+    ArenaVector<int> lessons; // Config lesson indices sharing the unit
+    ArenaVector<int> placed;
+  };
+
+  bool Run(const TimetableConfig &config, const SolveOptions &options,
+           Schedule &schedule);
+  bool Search();
+  int  CountCandidates(const Unit &unit, uint32_t *masks) const;
+  bool RulesAllow(const std::vector<DailyRule> &rules, uint32_t dayMask) const;
+
+  int m_Days    = 0;
+  int m_Periods = 0;
+
+  // Indexes and scratch come from the request arena when the solver is
+  // created inside a RequestScope.
+  ArenaVector<Unit>                   m_Units;
+  ArenaVector<uint32_t>               m_Allowed;     // Per (unit, day)
+  ArenaVector<uint32_t>               m_ClassBusy;   // Per (class, day)
+  ArenaVector<uint32_t>               m_TeacherBusy; // Per (teacher, day)
+  std::vector<std::vector<DailyRule>> m_ClassRules;
+  std::vector<std::vector<DailyRule>> m_TeacherRules;
+  ArenaVector<int>                    m_ClassDayLimit;   // From MaxPerDay
+  ArenaVector<int>                    m_TeacherDayLimit; // From MaxPerDay
+
+  // Per-node scratch for the capacity check, per (class, day) and
+  // (teacher, day), followed by the demand per class and per teacher.
+  ArenaVector<uint32_t> m_ClassOpen;
+  ArenaVector<uint32_t> m_TeacherOpen;
+  ArenaVector<int>      m_ClassDemand;
+  ArenaVector<int>      m_TeacherDemand;
+
+  const std::atomic<bool> *m_Stop = nullptr;
+
+  int64_t m_NodeLimit = kDefaultNodeLimit;
+  int64_t m_Nodes     = 0;
+  bool    m_Exhausted = false;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace TimetableWeaver
+{
+// Blocking multi-producer, multi-consumer FIFO with a fixed capacity, used
+// to hand work between pipeline stages. A full queue holds producers back,
+// so a fast stage cannot run arbitrarily far ahead of a slow one.
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity) : m_Capacity(capacity ? capacity : 1)
+  {
+  }
+
+  // Waits for room. Returns false, dropping the item, once closed.
+  bool Push(T item)
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_NotFull.wait(lock,
+                   [&] { return m_Closed || m_Items.size() < m_Capacity; });
+    if (m_Closed) {
+      return false;
+    }
+    m_Items.push_back(std::move(item));
+    m_NotEmpty.notify_one();
+    return true;
+  }
+
+  // Waits for an item. Returns false once closed and drained.
+  bool Pop(T &item)
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_NotEmpty.wait(lock, [&] { return m_Closed || !m_Items.empty(); });
+    if (m_Items.empty()) {
+      return false;
+    }
+    item = std::move(m_Items.front());
+    m_Items.pop_front();
+    m_NotFull.notify_one();
+    return true;
+  }
+
+  // Wakes every waiter; items already queued can still be popped.
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Closed = true;
+    m_NotFull.notify_all();
+    m_NotEmpty.notify_all();
+  }
+
+private:
+  std::mutex              m_Mutex;
+  std::condition_variable m_NotFull;
+  std::condition_variable m_NotEmpty;
+  std::deque<T>           m_Items;
+  size_t                  m_Capacity;
+  bool                    m_Closed = false;
+};
+}; // namespace TimetableWeaver
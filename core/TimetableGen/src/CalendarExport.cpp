@@ -0,0 +1,572 @@
+#include "CalendarExport.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace TimetableWeaver
+{
+// Output of one feed. Characters go to a fixed buffer that is handed to
+// the stream in large blocks. iCalendar content lines are folded before
+// they pass 75 octets, without splitting a UTF-8 sequence.
+class FeedWriter
+{
+public:
+  FeedWriter(std::ostream &stream, size_t bufferBytes, bool fold)
+      : m_Stream(stream), m_Buffer(std::max<size_t>(bufferBytes, 256)),
+        m_Fold(fold)
+  {
+  }
+
+  ~FeedWriter() { Flush(); }
+
+  FeedWriter(const FeedWriter &)            = delete;
+  FeedWriter &operator=(const FeedWriter &) = delete;
+
+  void Put(char c)
+  {
+    // Octets of the UTF-8 sequence c starts, 0 for a continuation byte.
+    const unsigned char byte   = static_cast<unsigned char>(c);
+    const int           length = byte < 0x80             ? 1
+                                 : (byte & 0xe0) == 0xc0 ? 2
+                                 : (byte & 0xf0) == 0xe0 ? 3
+                                 : (byte & 0xf8) == 0xf0 ? 4
+                                                         : 0;
+    if (m_Fold && length > 0 && m_Column + length > 75) {
+      Raw('\r');
+      Raw('\n');
+      Raw(' ');
+      m_Column = 1;
+    }
+    Raw(c);
+    ++m_Column;
+  }
+
+  void Put(const char *text)
+  {
+    while (*text != '\0') {
+      Put(*text++);
+    }
+  }
+
+  void Put(const std::string &text)
+  {
+    for (char c : text) {
+      Put(c);
+    }
+  }
+
+  // Zero padded to `width` digits.
+  void PutNumber(int value, int width)
+  {
+    char     digits[12];
+    int      count = 0;
+    unsigned rest  = static_cast<unsigned>(std::max(value, 0));
+    do {
+      digits[count++] = static_cast<char>('0' + rest % 10);
+      rest /= 10;
+    } while (rest != 0);
+    for (int i = count; i < width; ++i) {
+      Put('0');
+    }
+    while (count > 0) {
+      Put(digits[--count]);
+    }
+  }
+
+  void EndLine()
+  {
+    Raw('\r');
+    Raw('\n');
+    m_Column = 0;
+  }
+
+  bool Flush()
+  {
+    if (m_Used > 0) {
+      m_Stream.write(m_Buffer.data(), static_cast<std::streamsize>(m_Used));
+      m_Used = 0;
+    }
+    return m_Stream.good();
+  }
+
+private:
+  void Raw(char c)
+  {
+    if (m_Used == m_Buffer.size()) {
+      Flush();
+    }
+    m_Buffer[m_Used++] = c;
+  }
+
+  std::ostream     &m_Stream;
+  std::vector<char> m_Buffer;
+  size_t            m_Used   = 0;
+  int               m_Column = 0;
+  bool              m_Fold   = false;
+};
+
+// TEXT value of RFC 5545, section 3.3.11.
+static std::string EscapeText(const std::string &text)
+{
+  std::string escaped;
+  for (char c : text) {
+    if (c == '\\' || c == ';' || c == ',') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else if (c != '\r') {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Field of RFC 4180, quoted when it holds a separator, quote or newline.
+static std::string EscapeField(const std::string &text)
+{
+  if (text.find_first_of(",\"\r\n") == std::string::npos) {
+    return text;
+  }
+  std::string escaped = "\"";
+  for (char c : text) {
+    escaped += c;
+    if (c == '"') {
+      escaped += '"';
+    }
+  }
+  return escaped + "\"";
+}
+
+static std::string MakeSlug(const std::string &name)
+{
+  std::string slug;
+  for (char c : name) {
+    const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      (c >= '0' && c <= '9') || c == '-' || c == '_';
+    slug += safe ? c : '_';
+  }
+  return slug;
+}
+
+static void PutDate(FeedWriter &writer, const CalendarDate &date,
+                    const char *separator)
+{
+  writer.PutNumber(date.year, 4);
+  writer.Put(separator);
+  writer.PutNumber(date.month, 2);
+  writer.Put(separator);
+  writer.PutNumber(date.day, 2);
+}
+
+static void PutTime(FeedWriter &writer, int minute, const char *separator)
+{
+  writer.PutNumber(minute / 60, 2);
+  writer.Put(separator);
+  writer.PutNumber(minute % 60, 2);
+}
+
+// UTC offset as TZOFFSETFROM/TZOFFSETTO want it, e.g. "+0100".
+static void PutOffset(FeedWriter &writer, int minutes)
+{
+  writer.Put(minutes < 0 ? '-' : '+');
+  minutes = std::abs(minutes);
+  writer.PutNumber(minutes / 60, 2);
+  writer.PutNumber(minutes % 60, 2);
+}
+
+static bool IsValidTransition(const ZoneTransition &rule)
+{
+  return rule.month >= 1 && rule.month <= 12 &&
+         (rule.week == -1 || (rule.week >= 1 && rule.week <= 4)) &&
+         rule.weekday >= 0 && rule.weekday <= 6 && rule.minute >= 0 &&
+         rule.minute < 24 * 60;
+}
+
+// Date the rule falls on in the given year.
+static CalendarDate GetTransitionDate(int year, const ZoneTransition &rule)
+{
+  // Day 0 of ToDayNumber, 1970-01-01, was a Thursday.
+  auto weekday = [](int day) { return ((day + 4) % 7 + 7) % 7; };
+  if (rule.week > 0) {
+    const int first = ToDayNumber({year, rule.month, 1});
+    const int skip  = (rule.weekday - weekday(first) + 7) % 7;
+    return FromDayNumber(first + skip + (rule.week - 1) * 7);
+  }
+  const int last = ToDayNumber(rule.month == 12
+                                   ? CalendarDate{year + 1, 1, 1}
+                                   : CalendarDate{year, rule.month + 1, 1}) -
+                   1;
+  return FromDayNumber(last - (weekday(last) - rule.weekday + 7) % 7);
+}
+
+/**
+ * FeedTimeZone
+ */
+FeedTimeZone FeedTimeZone::Fixed(const std::string &id, int offset)
+{
+  FeedTimeZone zone;
+  zone.id             = id;
+  zone.standardOffset = offset;
+  zone.daylightOffset = offset;
+  return zone;
+}
+
+FeedTimeZone FeedTimeZone::European(const std::string &id,
+                                    int                standardOffset)
+{
+  FeedTimeZone zone;
+  zone.id             = id;
+  zone.standardOffset = standardOffset;
+  zone.daylightOffset = standardOffset + 60;
+  zone.daylightStart  = {3, -1, 0, 60 + standardOffset};
+  zone.standardStart  = {10, -1, 0, 60 + zone.daylightOffset};
+  return zone;
+}
+
+/**
+ * CalendarExporter
+ */
+CalendarExporter::CalendarExporter(const TimetableConfig &config,
+                                   const TermCalendar    &calendar,
+                                   const FeedOptions     &options)
+    : m_Config(config), m_Calendar(calendar), m_Options(options)
+{
+  const std::time_t  now    = std::time(nullptr);
+  const CalendarDate today  = FromDayNumber(static_cast<int>(now / 86400));
+  const int          second = static_cast<int>(now % 86400);
+  char               stamp[32];
+  std::snprintf(stamp, sizeof(stamp), "%04d%02d%02dT%02d%02d%02dZ",
+                today.year, today.month, today.day, second / 3600,
+                second / 60 % 60, second % 60);
+  m_Stamp = stamp;
+  m_Valid = CheckOptions();
+
+  m_Labels.resize(config.lessons.size());
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    const Lesson      &lesson  = *config.lessons[i];
+    const std::string &subject = lesson.GetSubject()->GetName();
+    const std::string &teacher = lesson.GetTeacher()->GetName();
+    std::string        group   = lesson.GetClass()->GetName();
+    const Subgroup    &part    = lesson.GetSubgroup();
+    if (!part.IsWholeClass()) {
+      group += " " + lesson.GetClass()
+                         ->GetPartitions()[part.partition]
+                         .groups[part.group];
+    }
+
+    LessonLabels &labels  = m_Labels[i];
+    labels.classSummary   = EscapeText(subject + " (" + teacher + ")");
+    labels.teacherSummary = EscapeText(subject + " (" + group + ")");
+    labels.subject        = EscapeField(subject);
+    labels.group          = EscapeField(group);
+    labels.teacher        = EscapeField(teacher);
+  }
+}
+
+int CalendarExporter::GetStartMinute(int period) const
+{
+  if (period < static_cast<int>(m_Options.periodStarts.size())) {
+    return m_Options.periodStarts[period];
+  }
+  return m_Options.dayStart +
+         period * (m_Options.periodMinutes + m_Options.breakMinutes);
+}
+
+bool CalendarExporter::CheckOptions() const
+{
+  if (m_Options.periodMinutes <= 0) {
+    std::cerr << "Calendar export: periods must be longer than 0 minutes\n";
+    return false;
+  }
+  for (int p = 0; p < m_Config.periodsPerDay; ++p) {
+    const int start = GetStartMinute(p);
+    if (start < 0 || start + m_Options.periodMinutes > 24 * 60) {
+      std::cerr << "Calendar export: period " << p + 1
+                << " does not end by midnight\n";
+      return false;
+    }
+  }
+  const FeedTimeZone &zone = m_Options.timeZone;
+  if (!zone.id.empty() && zone.daylightOffset != zone.standardOffset &&
+      (!IsValidTransition(zone.daylightStart) ||
+       !IsValidTransition(zone.standardStart))) {
+    std::cerr << "Calendar export: invalid transition in zone " << zone.id
+              << "\n";
+    return false;
+  }
+  return true;
+}
+
+// VTIMEZONE of RFC 5545, section 3.6.5, with rules starting in 1970.
+void CalendarExporter::PutTimeZone(FeedWriter &writer) const
+{
+  const FeedTimeZone &zone = m_Options.timeZone;
+  auto putPart = [&](const char *kind, int from, int to,
+                     const ZoneTransition *rule) {
+    writer.Put("BEGIN:");
+    writer.Put(kind);
+    writer.EndLine();
+    writer.Put("TZOFFSETFROM:");
+    PutOffset(writer, from);
+    writer.EndLine();
+    writer.Put("TZOFFSETTO:");
+    PutOffset(writer, to);
+    writer.EndLine();
+    writer.Put("DTSTART:");
+    PutDate(writer,
+            rule != nullptr ? GetTransitionDate(1970, *rule)
+                            : CalendarDate{1970, 1, 1},
+            "");
+    writer.Put('T');
+    PutTime(writer, rule != nullptr ? rule->minute : 0, "");
+    writer.Put("00");
+    writer.EndLine();
+    if (rule != nullptr) {
+      writer.Put("RRULE:FREQ=YEARLY;BYMONTH=");
+      writer.PutNumber(rule->month, 1);
+      writer.Put(";BYDAY=");
+      writer.Put(rule->week < 0 ? "-1" : "");
+      if (rule->week > 0) {
+        writer.PutNumber(rule->week, 1);
+      }
+      static const char *const kDays[] = {"SU", "MO", "TU", "WE",
+                                          "TH", "FR", "SA"};
+      writer.Put(kDays[rule->weekday]);
+      writer.EndLine();
+    }
+    writer.Put("END:");
+    writer.Put(kind);
+    writer.EndLine();
+  };
+
+  writer.Put("BEGIN:VTIMEZONE");
+  writer.EndLine();
+  writer.Put("TZID:");
+  writer.Put(zone.id);
+  writer.EndLine();
+  if (zone.daylightOffset == zone.standardOffset) {
+    putPart("STANDARD", zone.standardOffset, zone.standardOffset, nullptr);
+  } else {
+    putPart("DAYLIGHT", zone.standardOffset, zone.daylightOffset,
+            &zone.daylightStart);
+    putPart("STANDARD", zone.daylightOffset, zone.standardOffset,
+            &zone.standardStart);
+  }
+  writer.Put("END:VTIMEZONE");
+  writer.EndLine();
+}
+
+std::string CalendarExporter::GetFileName(FeedEntity entity, int id,
+                                          FeedFormat format) const
+{
+  const bool         isClass = entity == FeedEntity::Class;
+  const std::string &name    = isClass ? m_Config.classes[id].GetName()
+                                       : m_Config.teachers[id].GetName();
+  return m_Options.filePrefix + (isClass ? "class-" : "teacher-") +
+         std::to_string(id) + "-" + MakeSlug(name) +
+         (format == FeedFormat::ICalendar ? ".ics" : ".csv");
+}
+
+int64_t CalendarExporter::WriteFeed(std::ostream &stream, FeedEntity entity,
+                                    int id, FeedFormat format) const
+{
+  const bool isClass = entity == FeedEntity::Class;
+  const int  count   = static_cast<int>(isClass ? m_Config.classes.size()
+                                                : m_Config.teachers.size());
+  if (!m_Valid || id < 0 || id >= count) {
+    return -1;
+  }
+
+  const bool         ics = format == FeedFormat::ICalendar;
+  FeedWriter         writer(stream, m_Options.bufferBytes, ics);
+  const auto         first = m_Calendar.GetFirstDate();
+  const auto         last  = m_Calendar.GetLastDate();
+  const LessonLabels empty;
+
+  const auto range = isClass
+                         ? m_Calendar.GetClassOccurrences(id, first, last)
+                         : m_Calendar.GetTeacherOccurrences(id, first, last);
+
+  if (ics) {
+    const std::string &name = isClass ? m_Config.classes[id].GetName()
+                                      : m_Config.teachers[id].GetName();
+    writer.Put("BEGIN:VCALENDAR");
+    writer.EndLine();
+    writer.Put("VERSION:2.0");
+    writer.EndLine();
+    writer.Put("PRODID:-//TimetableWeaver//Calendar Export//EN");
+    writer.EndLine();
+    writer.Put("CALSCALE:GREGORIAN");
+    writer.EndLine();
+    writer.Put("METHOD:PUBLISH");
+    writer.EndLine();
+    writer.Put("X-WR-CALNAME:");
+    writer.Put(EscapeText(name));
+    writer.EndLine();
+    if (!m_Options.timeZone.id.empty()) {
+      writer.Put("X-WR-TIMEZONE:");
+      writer.Put(m_Options.timeZone.id);
+      writer.EndLine();
+      PutTimeZone(writer);
+    }
+  } else {
+    writer.Put("date,start,end,period,subject,class,teacher");
+    writer.EndLine();
+  }
+
+  // DTSTART and DTEND, with the zone when one is set.
+  auto putDateTime = [&](const char *property, const CalendarDate &date,
+                         int minute) {
+    writer.Put(property);
+    if (!m_Options.timeZone.id.empty()) {
+      writer.Put(";TZID=");
+      writer.Put(m_Options.timeZone.id);
+    }
+    writer.Put(':');
+    PutDate(writer, date, "");
+    writer.Put('T');
+    PutTime(writer, minute, "");
+    writer.Put("00");
+    writer.EndLine();
+  };
+
+  int64_t events = 0;
+  for (const auto &occurrence : range) {
+    const ScheduledLesson &lesson = occurrence.lesson;
+    const LessonLabels    &labels =
+        lesson.lesson >= 0 && lesson.lesson < static_cast<int>(m_Labels.size())
+               ? m_Labels[lesson.lesson]
+               : empty;
+    const int start = GetStartMinute(lesson.period);
+    const int end   = start + m_Options.periodMinutes;
+
+    if (ics) {
+      writer.Put("BEGIN:VEVENT");
+      writer.EndLine();
+      writer.Put("UID:");
+      PutDate(writer, occurrence.date, "");
+      writer.Put('-');
+      writer.PutNumber(lesson.period, 1);
+      writer.Put('-');
+      writer.PutNumber(lesson.lesson, 1);
+      writer.Put('@');
+      writer.Put(m_Options.uidDomain);
+      writer.EndLine();
+      writer.Put("DTSTAMP:");
+      writer.Put(m_Stamp);
+      writer.EndLine();
+      putDateTime("DTSTART", occurrence.date, start);
+      putDateTime("DTEND", occurrence.date, end);
+      writer.Put("SUMMARY:");
+      writer.Put(isClass ? labels.classSummary : labels.teacherSummary);
+      writer.EndLine();
+      writer.Put("END:VEVENT");
+      writer.EndLine();
+    } else {
+      PutDate(writer, occurrence.date, "-");
+      writer.Put(',');
+      PutTime(writer, start, ":");
+      writer.Put(',');
+      PutTime(writer, end, ":");
+      writer.Put(',');
+      writer.PutNumber(lesson.period + 1, 1);
+      writer.Put(',');
+      writer.Put(labels.subject);
+      writer.Put(',');
+      writer.Put(labels.group);
+      writer.Put(',');
+      writer.Put(labels.teacher);
+      writer.EndLine();
+    }
+    ++events;
+  }
+
+  if (ics) {
+    writer.Put("END:VCALENDAR");
+    writer.EndLine();
+  }
+  return writer.Flush() ? events : -1;
+}
+
+FeedReport CalendarExporter::ExportAll(
+    const std::string &directory, const std::vector<FeedFormat> &formats) const
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  struct Task {
+    FeedEntity entity;
+    int        id;
+    FeedFormat format;
+  };
+  std::vector<Task> tasks;
+  for (FeedFormat format : formats) {
+    for (size_t c = 0; c < m_Config.classes.size(); ++c) {
+      tasks.push_back({FeedEntity::Class, static_cast<int>(c), format});
+    }
+    for (size_t t = 0; t < m_Config.teachers.size(); ++t) {
+      tasks.push_back({FeedEntity::Teacher, static_cast<int>(t), format});
+    }
+  }
+
+  FeedReport report;
+  if (!m_Valid) {
+    report.failed = static_cast<int>(tasks.size());
+    return report;
+  }
+
+  std::atomic<int>      next{0};
+  std::atomic<int>      files{0};
+  std::atomic<int>      failed{0};
+  std::atomic<uint64_t> events{0};
+  std::atomic<uint64_t> bytes{0};
+  auto                  worker = [&]() {
+    for (int i = next++; i < static_cast<int>(tasks.size()); i = next++) {
+      const Task       &task = tasks[i];
+      const std::string path =
+          directory + "/" + GetFileName(task.entity, task.id, task.format);
+      std::ofstream file(path, std::ios::binary);
+      const int64_t written =
+          file ? WriteFeed(file, task.entity, task.id, task.format) : -1;
+      if (written < 0) {
+        std::cerr << "Cannot write " << path << "\n";
+        ++failed;
+        continue;
+      }
+      ++files;
+      events += static_cast<uint64_t>(written);
+      bytes += static_cast<uint64_t>(file.tellp());
+    }
+  };
+
+  unsigned threads = m_Options.threads > 0
+                         ? static_cast<unsigned>(m_Options.threads)
+                         : std::max(1u, std::thread::hardware_concurrency());
+  threads = std::max(1u, std::min(threads,
+                                  static_cast<unsigned>(tasks.size())));
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t) {
+    pool.emplace_back(worker);
+  }
+  for (auto &thread : pool) {
+    thread.join();
+  }
+
+  report.files   = files;
+  report.failed  = failed;
+  report.events  = events;
+  report.bytes   = bytes;
+  report.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return report;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "TermCalendar.hpp"
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+enum class FeedFormat { ICalendar, Csv };
+enum class FeedEntity { Class, Teacher };
+
+// Yearly change between standard and daylight time, e.g. the last Sunday
+// of March at 02:00 local time.
+struct ZoneTransition {
+  int month   = 3;
+  int week    = -1;  // 1 to 4, or -1 for the last in the month
+  int weekday = 0;   // 0 for Sunday
+  int minute  = 120; // Local time before the change, after midnight
+};
+
+// Time zone of the feed times. RFC 5545 wants a VTIMEZONE component for
+// every TZID a calendar uses, so the exporter writes one from these rules.
+struct FeedTimeZone {
+  std::string    id;                 // e.g. "Europe/Vienna"
+  int            standardOffset = 0; // Minutes east of UTC
+  int            daylightOffset = 0; // Same as standard without DST
+  ZoneTransition daylightStart;
+  ZoneTransition standardStart{10, -1, 0, 180};
+
+  // Zone without daylight saving time.
+  static FeedTimeZone Fixed(const std::string &id, int offset);
+  // Zone on the EU rule: daylight time from the last Sunday of March to the
+  // last Sunday of October, changing at 01:00 UTC.
+  static FeedTimeZone European(const std::string &id, int standardOffset);
+};
+
+struct FeedOptions {
+  // Period times. Period p starts at periodStarts[p] minutes after midnight
+  // when given, else dayStart + p * (periodMinutes + breakMinutes). Every
+  // period must end by midnight; the exporter refuses other bell schedules.
+  std::vector<int> periodStarts;
+  int              dayStart      = 8 * 60;
+  int              periodMinutes = 45;
+  int              breakMinutes  = 10;
+
+  // Zone of DTSTART/DTEND. An empty id writes floating times, which
+  // calendar apps show in the viewer's zone.
+  FeedTimeZone timeZone;
+
+  // Right-hand side of event UIDs; events are the same in the class and
+  // teacher feeds, so an app subscribed to both merges them.
+  std::string uidDomain = "timetableweaver";
+
+  // Prepended to feed file names, e.g. a school id when the feeds of a
+  // district share one directory.
+  std::string filePrefix;
+
+  int    threads     = 0; // Concurrent feeds, 0 for one per core
+  size_t bufferBytes = 64 << 10;
+};
+
+struct FeedReport {
+  int      files   = 0;
+  int      failed  = 0;
+  uint64_t events  = 0;
+  uint64_t bytes   = 0;
+  double   seconds = 0.0;
+};
+
+class FeedWriter;
+
+// Per-class and per-teacher calendar feeds of a term, as iCalendar
+// (RFC 5545) or CSV (RFC 4180) files for calendar apps and spreadsheets.
+//
+// Events are the dated lessons of the TermCalendar, so holidays, exam weeks
+// and closures are left out. The exporter prepares the escaped names of
+// every lesson once; writing a feed then walks the entity's occurrences and
+// formats each event straight into a buffer that is flushed in large
+// blocks, without building strings per event. ExportAll writes the feeds
+// of all entities on several threads. The config and calendar must outlive
+// the exporter and not change while it writes.
+class CalendarExporter
+{
+public:
+  CalendarExporter(const TimetableConfig &config,
+                   const TermCalendar    &calendar,
+                   const FeedOptions     &options = FeedOptions());
+
+  // False when the options hold a period that runs past midnight or an
+  // invalid zone rule; such an exporter writes no feeds.
+  bool IsValid() const { return m_Valid; }
+
+  // Writes one entity's feed; returns the number of events, or -1 when the
+  // exporter or id is invalid or the stream failed.
+  int64_t WriteFeed(std::ostream &stream, FeedEntity entity, int id,
+                    FeedFormat format) const;
+
+  // Writes a feed per class and teacher to `directory`, which must exist,
+  // named like "class-3-7b.ics" or "teacher-12-Smith.csv" after the file
+  // prefix, in every given format.
+  FeedReport ExportAll(const std::string             &directory,
+                       const std::vector<FeedFormat> &formats) const;
+
+  // File name of an entity's feed, without the directory.
+  std::string GetFileName(FeedEntity entity, int id, FeedFormat format) const;
+
+private:
+  // Labels of one config lesson, escaped for each format.
+  struct LessonLabels {
+    std::string classSummary;   // iCalendar, for class feeds
+    std::string teacherSummary; // iCalendar, for teacher feeds
+    std::string subject;        // CSV fields
+    std::string group;
+    std::string teacher;
+  };
+
+  int  GetStartMinute(int period) const;
+  bool CheckOptions() const;
+  void PutTimeZone(FeedWriter &writer) const;
+
+  const TimetableConfig    &m_Config;
+  const TermCalendar       &m_Calendar;
+  FeedOptions               m_Options;
+  std::string               m_Stamp; // DTSTAMP, the export's UTC time
+  std::vector<LessonLabels> m_Labels;
+  bool                      m_Valid = true;
+};
+}; // namespace TimetableWeaver
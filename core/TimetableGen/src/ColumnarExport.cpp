@@ -0,0 +1,364 @@
+#include "ColumnarExport.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+static const char     kColumnarMagic[4] = {'T', 'W', 'C', 'O'};
+static const char     kTrailerMagic[4]  = {'T', 'W', 'C', 'X'};
+static const uint32_t kColumnarFormat   = 1;
+
+struct ColumnSpec {
+  const char *name;
+  ColumnType  type;
+};
+
+static const ColumnSpec kLessonColumns[] = {
+    {"school", ColumnType::UInt32},
+    {"lesson", ColumnType::UInt32},
+    {"class", ColumnType::UInt16},
+    {"teacher", ColumnType::UInt16},
+    {"subject", ColumnType::UInt16},
+    {"day", ColumnType::UInt8},
+    {"period", ColumnType::UInt8},
+    {"teacher_day_load", ColumnType::UInt8},
+    {"teacher_day_gaps", ColumnType::UInt8},
+    {"class_day_load", ColumnType::UInt8},
+    {"subject_day_count", ColumnType::UInt8},
+};
+static_assert(sizeof(kLessonColumns) / sizeof(kLessonColumns[0]) ==
+                  static_cast<size_t>(LessonColumn::Count),
+              "every lesson column needs a spec");
+
+static const int kColumnCount = static_cast<int>(LessonColumn::Count);
+
+template <typename T>
+static bool ReadStruct(const MappedFile &file, uint64_t offset, T &out)
+{
+  if (offset > file.GetSize() || file.GetSize() - offset < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&out, file.GetData() + offset, sizeof(T));
+  return true;
+}
+
+/**
+ * ColumnarReader
+ */
+bool ColumnarReader::Open(const std::string &path)
+{
+  Close();
+  if (!m_File.Open(path)) {
+    return false;
+  }
+
+  ColumnarHeader  header;
+  ColumnarTrailer trailer;
+  if (!ReadStruct(m_File, 0, header) ||
+      std::memcmp(header.magic, kColumnarMagic, 4) != 0 ||
+      header.format != kColumnarFormat ||
+      m_File.GetSize() < sizeof(ColumnarHeader) + sizeof(ColumnarTrailer) ||
+      !ReadStruct(m_File, m_File.GetSize() - sizeof(ColumnarTrailer),
+                  trailer) ||
+      std::memcmp(trailer.magic, kTrailerMagic, 4) != 0) {
+    Close();
+    return false;
+  }
+
+  // Column specs, group table, chunk table and names all lie before the
+  // trailer. Counts are checked by division against the space they claim,
+  // so a corrupt file can neither overflow the products nor read past the
+  // mapping.
+  const uint64_t end = m_File.GetSize() - sizeof(ColumnarTrailer);
+  if (header.columnCount >
+          (end - sizeof(ColumnarHeader)) / sizeof(ColumnarColumn) ||
+      trailer.groupTableOffset > trailer.namesOffset ||
+      trailer.namesOffset > end) {
+    Close();
+    return false;
+  }
+  const uint64_t tables = trailer.namesOffset - trailer.groupTableOffset;
+  const uint64_t groups = trailer.groupCount;
+  if (groups > tables / sizeof(ColumnarGroup) ||
+      (header.columnCount > 0 &&
+       groups > (tables - groups * sizeof(ColumnarGroup)) / sizeof(uint64_t) /
+                    header.columnCount)) {
+    Close();
+    return false;
+  }
+
+  m_Columns.resize(header.columnCount);
+  for (uint32_t c = 0; c < header.columnCount; ++c) {
+    if (!ReadStruct(m_File,
+                    sizeof(ColumnarHeader) + c * sizeof(ColumnarColumn),
+                    m_Columns[c])) {
+      Close();
+      return false;
+    }
+  }
+
+  const uint64_t chunkTable =
+      trailer.groupTableOffset + groups * sizeof(ColumnarGroup);
+  m_Groups.resize(groups);
+  m_Chunks.resize(groups * header.columnCount);
+  if (!m_Groups.empty()) {
+    std::memcpy(m_Groups.data(), m_File.GetData() + trailer.groupTableOffset,
+                groups * sizeof(ColumnarGroup));
+  }
+  if (!m_Chunks.empty()) {
+    std::memcpy(m_Chunks.data(), m_File.GetData() + chunkTable,
+                m_Chunks.size() * sizeof(uint64_t));
+  }
+
+  uint64_t offset = trailer.namesOffset;
+  for (uint64_t g = 0; g < groups; ++g) {
+    uint32_t length = 0;
+    if (!ReadStruct(m_File, offset, length) ||
+        m_File.GetSize() - offset - sizeof(length) < length) {
+      Close();
+      return false;
+    }
+    const char *name = reinterpret_cast<const char *>(m_File.GetData()) +
+                       offset + sizeof(length);
+    m_Names.emplace_back(name, length);
+    offset += sizeof(length) + length;
+  }
+
+  // Every chunk must lie inside the file.
+  for (uint64_t g = 0; g < groups; ++g) {
+    for (uint32_t c = 0; c < header.columnCount; ++c) {
+      const uint64_t chunk = m_Chunks[g * header.columnCount + c];
+      const uint64_t bytes =
+          static_cast<uint64_t>(m_Groups[g].rowCount) * m_Columns[c].type;
+      if (chunk % 8 != 0 || chunk > trailer.groupTableOffset ||
+          trailer.groupTableOffset - chunk < bytes) {
+        Close();
+        return false;
+      }
+    }
+  }
+
+  m_RowCount = trailer.rowCount;
+  return true;
+}
+
+void ColumnarReader::Close()
+{
+  m_File.Close();
+  m_RowCount = 0;
+  m_Columns.clear();
+  m_Groups.clear();
+  m_Chunks.clear();
+  m_Names.clear();
+}
+
+int ColumnarReader::FindColumn(const std::string &name) const
+{
+  for (size_t c = 0; c < m_Columns.size(); ++c) {
+    if (std::strncmp(m_Columns[c].name, name.c_str(),
+                     sizeof(m_Columns[c].name)) == 0) {
+      return static_cast<int>(c);
+    }
+  }
+  return -1;
+}
+
+uint32_t ColumnarReader::GetGroupRows(int group) const
+{
+  return m_Groups[group].rowCount;
+}
+
+/**
+ * ColumnarWriter
+ */
+bool ColumnarWriter::Open(const std::string &path)
+{
+  m_Stream.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_Stream.good()) {
+    std::cerr << "Cannot create columnar export " << path << "\n";
+    return false;
+  }
+  m_Path       = path;
+  m_FileSize   = 0;
+  m_RolledBack = false;
+  m_RowCount   = 0;
+  m_Groups.clear();
+  m_Chunks.clear();
+  m_Names.clear();
+
+  ColumnarHeader header{};
+  std::memcpy(header.magic, kColumnarMagic, 4);
+  header.format      = kColumnarFormat;
+  header.columnCount = kColumnCount;
+  if (!Write(&header, sizeof(header))) {
+    return false;
+  }
+  for (const auto &spec : kLessonColumns) {
+    ColumnarColumn column{};
+    std::strncpy(column.name, spec.name, sizeof(column.name) - 1);
+    column.type = static_cast<uint32_t>(spec.type);
+    if (!Write(&column, sizeof(column))) {
+      return false;
+    }
+  }
+  return Pad();
+}
+
+bool ColumnarWriter::Close()
+{
+  if (!m_Stream.is_open()) {
+    return false;
+  }
+
+  const uint64_t tables = m_Groups.size() * sizeof(ColumnarGroup) +
+                          m_Chunks.size() * sizeof(uint64_t);
+
+  ColumnarTrailer trailer{};
+  std::memcpy(trailer.magic, kTrailerMagic, 4);
+  trailer.groupCount       = static_cast<uint32_t>(m_Groups.size());
+  trailer.rowCount         = m_RowCount;
+  trailer.groupTableOffset = m_FileSize;
+  trailer.namesOffset      = m_FileSize + tables;
+
+  bool written =
+      Write(m_Groups.data(), m_Groups.size() * sizeof(ColumnarGroup)) &&
+      Write(m_Chunks.data(), m_Chunks.size() * sizeof(uint64_t));
+  for (const auto &name : m_Names) {
+    const uint32_t length = static_cast<uint32_t>(name.size());
+    written = written && Write(&length, sizeof(length)) &&
+              Write(name.data(), name.size());
+  }
+  written = written && Write(&trailer, sizeof(trailer));
+  m_Stream.close();
+
+  // A rolled back group may have left bytes beyond the trailer.
+  if (written && m_RolledBack) {
+    std::error_code error;
+    std::filesystem::resize_file(m_Path, m_FileSize, error);
+    written = !error;
+  }
+  return written;
+}
+
+bool ColumnarWriter::Append(const std::string &school,
+                            const Schedule    &schedule)
+{
+  assert(m_Stream.is_open());
+
+  const int days = schedule.GetDays();
+
+  std::vector<ScheduledLesson> entries = schedule.GetEntries();
+  std::sort(entries.begin(), entries.end(),
+            [](const ScheduledLesson &a, const ScheduledLesson &b) {
+              if (a.day != b.day) {
+                return a.day < b.day;
+              }
+              if (a.period != b.period) {
+                return a.period < b.period;
+              }
+              return a.classId < b.classId;
+            });
+
+  // Daily masks per teacher and class, and subject counts per class day.
+  int numSubjects = 0;
+  for (const auto &entry : entries) {
+    if (entry.classId < 0 || entry.classId > UINT16_MAX ||
+        entry.teacherId < 0 || entry.teacherId > UINT16_MAX ||
+        entry.subjectId < 0 || entry.subjectId > UINT16_MAX) {
+      std::cerr << "School " << school << " has ids beyond the "
+                << "16-bit export columns\n";
+      return false;
+    }
+    numSubjects = std::max(numSubjects, entry.subjectId + 1);
+  }
+  std::vector<uint32_t> teacherMasks(schedule.GetNumTeachers() * days, 0);
+  std::vector<uint32_t> classMasks(schedule.GetNumClasses() * days, 0);
+  std::vector<uint8_t>  subjectCounts(
+      static_cast<size_t>(schedule.GetNumClasses()) * numSubjects * days, 0);
+  for (const auto &entry : entries) {
+    teacherMasks[entry.teacherId * days + entry.day] |= 1u << entry.period;
+    classMasks[entry.classId * days + entry.day] |= 1u << entry.period;
+    auto &count =
+        subjectCounts[(entry.classId * numSubjects + entry.subjectId) * days +
+                      entry.day];
+    count = static_cast<uint8_t>(std::min(count + 1, 255));
+  }
+
+  const size_t          rows = entries.size();
+  std::vector<uint32_t> schools(rows, static_cast<uint32_t>(m_Groups.size()));
+  std::vector<uint32_t> lessons(rows);
+  std::vector<uint16_t> classes(rows), teachers(rows), subjects(rows);
+  std::vector<uint8_t>  dayColumn(rows), periodColumn(rows);
+  std::vector<uint8_t>  teacherLoads(rows), teacherGaps(rows);
+  std::vector<uint8_t>  classLoads(rows), subjectDays(rows);
+  for (size_t r = 0; r < rows; ++r) {
+    const auto &entry      = entries[r];
+    const int   classDay   = entry.classId * days + entry.day;
+    const int   teacherDay = entry.teacherId * days + entry.day;
+    const int   subjectDay =
+        (entry.classId * numSubjects + entry.subjectId) * days + entry.day;
+
+    lessons[r]      = static_cast<uint32_t>(entry.lesson);
+    classes[r]      = static_cast<uint16_t>(entry.classId);
+    teachers[r]     = static_cast<uint16_t>(entry.teacherId);
+    subjects[r]     = static_cast<uint16_t>(entry.subjectId);
+    dayColumn[r]    = static_cast<uint8_t>(entry.day);
+    periodColumn[r] = static_cast<uint8_t>(entry.period);
+    teacherLoads[r] = static_cast<uint8_t>(PopCount(teacherMasks[teacherDay]));
+    teacherGaps[r]  = static_cast<uint8_t>(GapCount(teacherMasks[teacherDay]));
+    classLoads[r]   = static_cast<uint8_t>(PopCount(classMasks[classDay]));
+    subjectDays[r]  = subjectCounts[subjectDay];
+  }
+
+  const void *columns[kColumnCount] = {
+      schools.data(),      lessons.data(),      classes.data(),
+      teachers.data(),     subjects.data(),     dayColumn.data(),
+      periodColumn.data(), teacherLoads.data(), teacherGaps.data(),
+      classLoads.data(),   subjectDays.data()};
+
+  ColumnarGroup group{};
+  group.firstRow = m_RowCount;
+  group.rowCount = static_cast<uint32_t>(rows);
+
+  // A group is all or nothing: on failure its chunks are forgotten and the
+  // next write starts where this group did.
+  const size_t   firstChunk = m_Chunks.size();
+  const uint64_t start      = m_FileSize;
+  for (int c = 0; c < kColumnCount; ++c) {
+    m_Chunks.push_back(m_FileSize);
+    const size_t width = static_cast<size_t>(kLessonColumns[c].type);
+    if (!Write(columns[c], rows * width) || !Pad()) {
+      m_Chunks.resize(firstChunk);
+      m_FileSize   = start;
+      m_RolledBack = true;
+      m_Stream.clear();
+      m_Stream.seekp(static_cast<std::streamoff>(start));
+      return false;
+    }
+  }
+  m_Groups.push_back(group);
+  m_Names.push_back(school);
+  m_RowCount += rows;
+  return true;
+}
+
+bool ColumnarWriter::Write(const void *data, size_t size)
+{
+  m_Stream.write(static_cast<const char *>(data),
+                 static_cast<std::streamsize>(size));
+  m_FileSize += size;
+  return m_Stream.good();
+}
+
+bool ColumnarWriter::Pad()
+{
+  static const uint8_t kZeros[8] = {};
+  return Write(kZeros, (8 - m_FileSize % 8) % 8);
+}
+}; // namespace TimetableWeaver
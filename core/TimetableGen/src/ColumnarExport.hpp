@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Schedule.hpp"
+
+namespace TimetableWeaver
+{
+// Columnar export of lesson-slot rows across many schools, for analytics.
+//
+// File layout (little-endian):
+//   ColumnarHeader
+//   ColumnarColumn per column: the schema
+//   per school, one row group: a chunk per column, each a plain array of
+//     its fixed-width type, padded to 8 bytes
+//   group table: ColumnarGroup per school
+//   chunk table: one uint64 offset per group and column
+//   school names, each a uint32 length and its bytes
+//   ColumnarTrailer
+//
+// Every row is one lesson period of one school with the facts analyses keep
+// recomputing: how loaded the teacher and class are that day, the teacher's
+// free periods between lessons that day, and how many periods of the
+// subject the class has that day. Rows of a school are sorted by slot, then
+// class. Chunks are aligned, so a reader scans a mapped column as a typed
+// array without copying.
+
+enum class ColumnType : uint32_t { UInt8 = 1, UInt16 = 2, UInt32 = 4 };
+
+// Columns in file order.
+enum class LessonColumn {
+  School,          // Row group index
+  Lesson,          // Config lesson index
+  Class,           // Config class index
+  Teacher,         // Config teacher index
+  Subject,         // Config subject index
+  Day,
+  Period,
+  TeacherDayLoad,  // Periods the teacher teaches that day
+  TeacherDayGaps,  // Free periods between the teacher's first and last
+  ClassDayLoad,    // Periods the class has that day
+  SubjectDayCount, // Periods of this subject the class has that day
+  Count
+};
+
+struct ColumnarHeader {
+  char     magic[4];
+  uint32_t format;
+  uint32_t columnCount;
+  uint32_t reserved;
+};
+
+struct ColumnarColumn {
+  char     name[24]; // Zero padded
+  uint32_t type;     // ColumnType, the width in bytes
+  uint32_t reserved;
+};
+
+struct ColumnarGroup {
+  uint64_t firstRow;
+  uint32_t rowCount;
+  uint32_t reserved;
+};
+
+struct ColumnarTrailer {
+  char     magic[4];
+  uint32_t groupCount;
+  uint64_t rowCount;
+  uint64_t groupTableOffset;
+  uint64_t namesOffset;
+};
+
+class ColumnarReader
+{
+public:
+  bool Open(const std::string &path);
+  void Close();
+
+  int GetColumnCount() const { return static_cast<int>(m_Columns.size()); }
+  const ColumnarColumn &GetColumn(int column) const
+  {
+    return m_Columns[column];
+  }
+  // Index of the named column, or -1.
+  int FindColumn(const std::string &name) const;
+
+  int      GetGroupCount() const { return static_cast<int>(m_Groups.size()); }
+  uint64_t GetRowCount() const { return m_RowCount; }
+
+  uint32_t           GetGroupRows(int group) const;
+  const std::string &GetGroupName(int group) const { return m_Names[group]; }
+
+  // Values of one column in one row group, or nullptr when T does not
+  // match the column's type.
+  template <typename T>
+  const T *GetChunk(int group, int column) const
+  {
+    if (sizeof(T) != m_Columns[column].type) {
+      return nullptr;
+    }
+    return reinterpret_cast<const T *>(
+        m_File.GetData() + m_Chunks[group * m_Columns.size() + column]);
+  }
+
+private:
+  MappedFile                  m_File;
+  uint64_t                    m_RowCount = 0;
+  std::vector<ColumnarColumn> m_Columns;
+  std::vector<ColumnarGroup>  m_Groups;
+  std::vector<uint64_t>       m_Chunks;
+  std::vector<std::string>    m_Names;
+};
+
+// Streams one school at a time: only the rows of the school being appended
+// are held in memory, plus a small directory entry per school.
+class ColumnarWriter
+{
+public:
+  bool Open(const std::string &path);
+
+  // Writes the footer; the file is unreadable until it is closed.
+  bool Close();
+
+  // Adds the school's lessons as one row group. Fails without adding
+  // anything when a class, teacher or subject id does not fit the uint16
+  // columns, or when the group cannot be written.
+  bool Append(const std::string &school, const Schedule &schedule);
+
+  int      GetGroupCount() const { return static_cast<int>(m_Groups.size()); }
+  uint64_t GetRowCount() const { return m_RowCount; }
+
+private:
+  bool Write(const void *data, size_t size);
+  bool Pad();
+
+  std::ofstream              m_Stream;
+  std::string                m_Path;
+  uint64_t                   m_FileSize   = 0;
+  bool                       m_RolledBack = false; // Bytes past m_FileSize
+  uint64_t                   m_RowCount = 0;
+  std::vector<ColumnarGroup> m_Groups;
+  std::vector<uint64_t>      m_Chunks;
+  std::vector<std::string>   m_Names;
+};
+}; // namespace TimetableWeaver
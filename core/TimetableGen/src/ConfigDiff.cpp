@@ -0,0 +1,401 @@
+#include "ConfigDiff.hpp"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace TimetableWeaver
+{
+using NameSet = std::unordered_set<std::string>;
+
+// Whether old index `a` was matched to new index `b`; -1 for every entity
+// only matches itself.
+static bool SameIndex(const std::vector<int> &map, int a, int b)
+{
+  if (a < 0) {
+    return b == a;
+  }
+  return a < static_cast<int>(map.size()) && map[a] >= 0 && map[a] == b;
+}
+
+static bool SameRule(const DailyRule &a, const DailyRule &b,
+                     const ConfigChanges &changes)
+{
+  const auto &map = a.target == RuleTarget::Teachers ? changes.teacherMap
+                                                     : changes.classMap;
+  return a.kind == b.kind && a.target == b.target &&
+         SameIndex(map, a.entityId, b.entityId) && a.limit == b.limit &&
+         a.firstPeriod == b.firstPeriod && a.lastPeriod == b.lastPeriod &&
+         a.hard == b.hard && a.weight == b.weight;
+}
+
+static bool SameSpread(const SpreadRule &a, const SpreadRule &b,
+                       const ConfigChanges &changes)
+{
+  return SameIndex(changes.lessonMap, a.lesson, b.lesson) &&
+         a.blocks == b.blocks && a.minDayGap == b.minDayGap &&
+         a.hard == b.hard && a.weight == b.weight;
+}
+
+template <typename T>
+static bool SamePartitions(const T &, const T &)
+{
+  return true;
+}
+
+static bool SamePartitions(const Class &a, const Class &b)
+{
+  const auto &left  = a.GetPartitions();
+  const auto &right = b.GetPartitions();
+  return std::equal(left.begin(), left.end(), right.begin(), right.end(),
+                    [](const SubgroupPartition &x, const SubgroupPartition &y) {
+                      return x.name == y.name && x.groups == y.groups;
+                    });
+}
+
+// Adds the entity changes of one kind, fills its old to new index map and
+// collects the names of matched entities whose availability or partitions
+// changed.
+template <typename T>
+static void DiffEntities(DeltaEntity kind, const std::vector<T> &before,
+                         const std::vector<T> &after, int days,
+                         ConfigChanges &changes, std::vector<int> &map,
+                         NameSet &touched)
+{
+  map.assign(before.size(), -1);
+  std::unordered_map<std::string, int> index;
+  index.reserve(before.size());
+  for (size_t i = 0; i < before.size(); ++i) {
+    index.emplace(before[i].GetName(), static_cast<int>(i));
+  }
+
+  std::vector<char> matched(before.size(), 0);
+  for (size_t j = 0; j < after.size(); ++j) {
+    const int newIndex = static_cast<int>(j);
+    auto      it       = index.find(after[j].GetName());
+    if (it == index.end()) {
+      changes.entities.push_back({ChangeKind::Added, kind, -1, newIndex});
+      continue;
+    }
+    const int oldIndex = it->second;
+    matched[oldIndex]  = 1;
+    map[oldIndex]      = newIndex;
+
+    bool changed = !SamePartitions(before[oldIndex], after[j]);
+    for (int day = 0; day < days; ++day) {
+      const uint32_t flipped =
+          before[oldIndex].GetAvailability().GetDay(day) ^
+          after[j].GetAvailability().GetDay(day);
+      if (flipped != 0) {
+        changes.availability.push_back({kind, newIndex, day, flipped});
+        changed = true;
+      }
+    }
+    if (changed) {
+      changes.entities.push_back(
+          {ChangeKind::Changed, kind, oldIndex, newIndex});
+      touched.insert(after[j].GetName());
+    }
+  }
+  for (size_t i = 0; i < before.size(); ++i) {
+    if (!matched[i]) {
+      changes.entities.push_back(
+          {ChangeKind::Removed, kind, static_cast<int>(i), -1});
+    }
+  }
+}
+
+static std::string LessonKey(const Lesson &lesson)
+{
+  const Subgroup &subgroup = lesson.GetSubgroup();
+  return lesson.GetClass()->GetName() + '\x1f' +
+         lesson.GetTeacher()->GetName() + '\x1f' +
+         lesson.GetSubject()->GetName() + '\x1f' +
+         std::to_string(subgroup.partition) + ':' +
+         std::to_string(subgroup.group);
+}
+
+bool ConfigChanges::IsEmpty() const
+{
+  return !shapeChanged && !rulesChanged && entities.empty() &&
+         availability.empty();
+}
+
+ConfigChanges DiffConfigs(const TimetableConfig &before,
+                          const TimetableConfig &after)
+{
+  ConfigChanges changes;
+  changes.shapeChanged = before.days != after.days ||
+                         before.periodsPerDay != after.periodsPerDay;
+
+  const int days = std::min(before.days, after.days);
+  NameSet   subjects, teachers, classes;
+  DiffEntities(DeltaEntity::Subject, before.subjects, after.subjects, days,
+               changes, changes.subjectMap, subjects);
+  DiffEntities(DeltaEntity::Teacher, before.teachers, after.teachers, days,
+               changes, changes.teacherMap, teachers);
+  DiffEntities(DeltaEntity::Class, before.classes, after.classes, days,
+               changes, changes.classMap, classes);
+
+  changes.rulesChanged =
+      !std::equal(before.rules.begin(), before.rules.end(),
+                  after.rules.begin(), after.rules.end(),
+                  [&](const DailyRule &a, const DailyRule &b) {
+                    return SameRule(a, b, changes);
+                  });
+
+  // Old lessons by key, each list consumed front to back.
+  std::unordered_map<std::string, std::pair<size_t, std::vector<int>>> keys;
+  keys.reserve(before.lessons.size());
+  for (size_t i = 0; i < before.lessons.size(); ++i) {
+    keys[LessonKey(*before.lessons[i])].second.push_back(static_cast<int>(i));
+  }
+
+  const auto       &lessons = after.lessons;
+  std::vector<char> dirty(lessons.size(), 0);
+  changes.lessonMap.assign(before.lessons.size(), -1);
+  for (size_t j = 0; j < lessons.size(); ++j) {
+    const int newIndex = static_cast<int>(j);
+    auto      it       = keys.find(LessonKey(*lessons[j]));
+    if (it == keys.end() || it->second.first == it->second.second.size()) {
+      changes.entities.push_back(
+          {ChangeKind::Added, DeltaEntity::Lesson, -1, newIndex});
+      dirty[j] = 1;
+      continue;
+    }
+    const int oldIndex          = it->second.second[it->second.first++];
+    changes.lessonMap[oldIndex] = newIndex;
+    if (before.lessons[oldIndex]->GetPeriodsPerWeek() !=
+        lessons[j]->GetPeriodsPerWeek()) {
+      changes.entities.push_back(
+          {ChangeKind::Changed, DeltaEntity::Lesson, oldIndex, newIndex});
+      dirty[j] = 1;
+    }
+  }
+
+  // Spreads name their lesson by index, so they compare once lessons are
+  // matched.
+  changes.rulesChanged =
+      changes.rulesChanged ||
+      !std::equal(before.spreads.begin(), before.spreads.end(),
+                  after.spreads.begin(), after.spreads.end(),
+                  [&](const SpreadRule &a, const SpreadRule &b) {
+                    return SameSpread(a, b, changes);
+                  });
+
+  // Lessons left behind by removed ones may now fit elsewhere.
+  for (size_t i = 0; i < before.lessons.size(); ++i) {
+    if (changes.lessonMap[i] < 0) {
+      changes.entities.push_back({ChangeKind::Removed, DeltaEntity::Lesson,
+                                  static_cast<int>(i), -1});
+      classes.insert(before.lessons[i]->GetClass()->GetName());
+      teachers.insert(before.lessons[i]->GetTeacher()->GetName());
+    }
+  }
+
+  for (size_t j = 0; j < lessons.size(); ++j) {
+    if (dirty[j] || classes.count(lessons[j]->GetClass()->GetName()) ||
+        teachers.count(lessons[j]->GetTeacher()->GetName()) ||
+        subjects.count(lessons[j]->GetSubject()->GetName())) {
+      changes.dirtyLessons.push_back(static_cast<int>(j));
+    }
+  }
+  return changes;
+}
+
+// Day and period in one int, independent of the periods per day.
+static int SlotKey(const ScheduledLesson &entry)
+{
+  return entry.day * 32 + entry.period;
+}
+
+ScheduleChanges DiffSchedules(const Schedule &before, const Schedule &after,
+                              const std::vector<int> &lessonMap)
+{
+  ScheduleChanges changes;
+
+  auto mapLesson = [&](int lesson) {
+    if (lessonMap.empty()) {
+      return lesson;
+    }
+    return lesson < static_cast<int>(lessonMap.size()) ? lessonMap[lesson]
+                                                       : -1;
+  };
+
+  int numLessons = 0;
+  for (const auto &entry : before.GetEntries()) {
+    numLessons = std::max(numLessons, mapLesson(entry.lesson) + 1);
+  }
+  for (const auto &entry : after.GetEntries()) {
+    numLessons = std::max(numLessons, entry.lesson + 1);
+  }
+
+  std::vector<std::vector<int>> oldSlots(numLessons), newSlots(numLessons);
+  std::vector<int>              oldLessons(numLessons, -1);
+  for (const auto &entry : before.GetEntries()) {
+    const int lesson = mapLesson(entry.lesson);
+    if (lesson < 0) {
+      PlacementChange change;
+      change.oldLesson  = entry.lesson;
+      change.fromDay    = entry.day;
+      change.fromPeriod = entry.period;
+      changes.placements.push_back(change);
+      continue;
+    }
+    oldSlots[lesson].push_back(SlotKey(entry));
+    oldLessons[lesson] = entry.lesson;
+  }
+  for (const auto &entry : after.GetEntries()) {
+    newSlots[entry.lesson].push_back(SlotKey(entry));
+  }
+
+  std::vector<int> removed, added;
+  for (int lesson = 0; lesson < numLessons; ++lesson) {
+    auto &from = oldSlots[lesson];
+    auto &to   = newSlots[lesson];
+    std::sort(from.begin(), from.end());
+    std::sort(to.begin(), to.end());
+
+    removed.clear();
+    added.clear();
+    size_t i = 0, j = 0;
+    while (i < from.size() || j < to.size()) {
+      if (j == to.size() || (i < from.size() && from[i] < to[j])) {
+        removed.push_back(from[i++]);
+      } else if (i == from.size() || to[j] < from[i]) {
+        added.push_back(to[j++]);
+      } else {
+        ++changes.unchanged;
+        ++i;
+        ++j;
+      }
+    }
+
+    // Pair removed and added slots up as moves.
+    const size_t count = std::max(removed.size(), added.size());
+    for (size_t k = 0; k < count; ++k) {
+      PlacementChange change;
+      change.lesson    = lesson;
+      change.oldLesson = oldLessons[lesson];
+      if (k < removed.size()) {
+        change.fromDay    = removed[k] / 32;
+        change.fromPeriod = removed[k] % 32;
+      }
+      if (k < added.size()) {
+        change.toDay    = added[k] / 32;
+        change.toPeriod = added[k] % 32;
+      }
+      changes.placements.push_back(change);
+    }
+  }
+  return changes;
+}
+
+static const char *EntityLabel(DeltaEntity entity)
+{
+  switch (entity) {
+  case DeltaEntity::Subject:
+    return "subject";
+  case DeltaEntity::Teacher:
+    return "teacher";
+  case DeltaEntity::Class:
+    return "class";
+  default:
+    return "lesson";
+  }
+}
+
+static void PrintEntity(std::ostream &stream, const TimetableConfig &config,
+                        DeltaEntity entity, int index)
+{
+  stream << EntityLabel(entity) << " ";
+  switch (entity) {
+  case DeltaEntity::Subject:
+    stream << "'" << config.subjects[index].GetName() << "'";
+    break;
+  case DeltaEntity::Teacher:
+    stream << "'" << config.teachers[index].GetName() << "'";
+    break;
+  case DeltaEntity::Class:
+    stream << "'" << config.classes[index].GetName() << "'";
+    break;
+  case DeltaEntity::Lesson: {
+    const Lesson &lesson = *config.lessons[index];
+    stream << index << " (" << lesson.GetClass()->GetName() << ", "
+           << lesson.GetTeacher()->GetName() << ", "
+           << lesson.GetSubject()->GetName() << ", "
+           << lesson.GetPeriodsPerWeek() << " per week)";
+    break;
+  }
+  }
+}
+
+void PrintChanges(std::ostream &stream, const TimetableConfig &before,
+                  const TimetableConfig &after, const ConfigChanges &config,
+                  const ScheduleChanges &schedule)
+{
+  stream << "Config: " << config.entities.size() << " entity changes, "
+         << config.availability.size() << " availability days changed, "
+         << config.dirtyLessons.size() << " lessons to re-solve\n";
+  if (config.shapeChanged) {
+    stream << "  ~ week is now " << after.days << " days of "
+           << after.periodsPerDay << " periods\n";
+  }
+  if (config.rulesChanged) {
+    stream << "  ~ daily or spread rules changed\n";
+  }
+  for (const auto &change : config.entities) {
+    switch (change.kind) {
+    case ChangeKind::Added:
+      stream << "  + ";
+      PrintEntity(stream, after, change.entity, change.newIndex);
+      break;
+    case ChangeKind::Removed:
+      stream << "  - ";
+      PrintEntity(stream, before, change.entity, change.oldIndex);
+      break;
+    case ChangeKind::Changed:
+      stream << "  ~ ";
+      PrintEntity(stream, after, change.entity, change.newIndex);
+      break;
+    }
+    stream << "\n";
+  }
+  for (const auto &change : config.availability) {
+    stream << "  ~ ";
+    PrintEntity(stream, after, change.entity, change.index);
+    stream << " day " << change.day << " periods";
+    for (int period = 0; period < 32; ++period) {
+      if (change.flipped >> period & 1) {
+        stream << " " << period;
+      }
+    }
+    stream << " flipped\n";
+  }
+
+  stream << "Schedule: " << schedule.unchanged << " placements kept, "
+         << schedule.placements.size() << " changed\n";
+  for (const auto &change : schedule.placements) {
+    stream << "  lesson ";
+    if (change.lesson >= 0) {
+      stream << change.lesson;
+    } else {
+      stream << change.oldLesson << " (removed)";
+    }
+    stream << ": ";
+    if (change.fromDay >= 0) {
+      stream << "day " << change.fromDay << " period " << change.fromPeriod;
+    } else {
+      stream << "new";
+    }
+    stream << " -> ";
+    if (change.toDay >= 0) {
+      stream << "day " << change.toDay << " period " << change.toPeriod;
+    } else {
+      stream << "dropped";
+    }
+    stream << "\n";
+  }
+}
+}; // namespace TimetableWeaver
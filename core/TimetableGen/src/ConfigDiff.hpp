@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "ConfigSync.hpp"
+#include "Schedule.hpp"
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+// Structural diffs between two versions of a config and between two
+// schedules, in time linear in their sizes.
+//
+// Subjects, teachers and classes are matched by name through a hash map,
+// and daily rules compare their entity through that match, so reordering
+// entities changes no rule. Lessons are matched by class, teacher, subject
+// and subgroup; several lessons with the same key pair up in order, and
+// spreads compare their lesson through that match. Availability is
+// compared a day word at a time, keeping the XOR of both words, so a change
+// set names exactly the periods that flipped.
+
+enum class ChangeKind : uint8_t { Added, Removed, Changed };
+
+struct EntityChange {
+  ChangeKind  kind     = ChangeKind::Changed;
+  DeltaEntity entity   = DeltaEntity::Lesson;
+  int         oldIndex = -1; // -1 when added
+  int         newIndex = -1; // -1 when removed
+};
+
+struct AvailabilityChange {
+  DeltaEntity entity  = DeltaEntity::Teacher;
+  int         index   = -1; // In the new config
+  int         day     = 0;
+  uint32_t    flipped = 0;  // Periods that opened or closed
+};
+
+struct ConfigChanges {
+  bool shapeChanged = false; // Days or periods per day
+  bool rulesChanged = false;
+
+  std::vector<EntityChange>       entities;
+  std::vector<AvailabilityChange> availability;
+
+  // Old lesson index to new, -1 for removed lessons.
+  std::vector<int> lessonMap;
+
+  // The same for entities, matched by name.
+  std::vector<int> subjectMap;
+  std::vector<int> teacherMap;
+  std::vector<int> classMap;
+
+  // Sorted new indices of lessons that were added or changed, that belong
+  // to an entity whose availability flipped, or that share a class or
+  // teacher with a removed lesson. Their class/teacher components are what
+  // needs solving again, see ConfigSync::GetAffectedLessons.
+  std::vector<int> dirtyLessons;
+
+  // Nothing a solve depends on changed, so a cached schedule still holds
+  // after renumbering its lessons with lessonMap and its class, teacher
+  // and subject ids with the entity maps, which differ from the identity
+  // when entities were reordered.
+  bool IsEmpty() const;
+};
+
+ConfigChanges DiffConfigs(const TimetableConfig &before,
+                          const TimetableConfig &after);
+
+// One placement that is in one schedule but not the other. A lesson that
+// moved has both ends; a placement that was only added or only removed has
+// -1 for the missing one.
+struct PlacementChange {
+  int lesson     = -1; // In the new numbering, -1 for a removed lesson
+  int oldLesson  = -1;
+  int fromDay    = -1;
+  int fromPeriod = -1;
+  int toDay      = -1;
+  int toPeriod   = -1;
+};
+
+struct ScheduleChanges {
+  std::vector<PlacementChange> placements;
+  int                          unchanged = 0; // Placements in both
+
+  bool IsEmpty() const { return placements.empty(); }
+};
+
+// Lesson indices of `before` are translated with lessonMap when it is given,
+// e.g. from DiffConfigs or ConfigSync, so both sides use the new numbering.
+ScheduleChanges DiffSchedules(const Schedule         &before,
+                              const Schedule         &after,
+                              const std::vector<int> &lessonMap = {});
+
+// Human-readable "changes since last publish" report.
+void PrintChanges(std::ostream &stream, const TimetableConfig &before,
+                  const TimetableConfig &after, const ConfigChanges &config,
+                  const ScheduleChanges &schedule);
+}; // namespace TimetableWeaver
@@ -0,0 +1,573 @@
+#include "ConfigSync.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace TimetableWeaver
+{
+static const char kDeltaMagic[4] = {'T', 'W', 'D', 'L'};
+
+static void PutVarint(std::vector<uint8_t> &buffer, uint32_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static bool GetVarint(const uint8_t *&cursor, const uint8_t *end,
+                      uint32_t &value)
+{
+  value     = 0;
+  int shift = 0;
+  while (cursor < end && shift < 35) {
+    uint8_t byte = *cursor++;
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+    shift += 7;
+  }
+  return false;
+}
+
+// Indices and counts that may be -1 travel shifted by one.
+static void PutIndex(std::vector<uint8_t> &buffer, int value)
+{
+  PutVarint(buffer, static_cast<uint32_t>(value + 1));
+}
+
+static bool GetIndex(const uint8_t *&cursor, const uint8_t *end, int &value)
+{
+  uint32_t raw = 0;
+  if (!GetVarint(cursor, end, raw) || raw > 0x7fffffffu) {
+    return false;
+  }
+  value = static_cast<int>(raw) - 1;
+  return true;
+}
+
+std::vector<uint8_t> EncodeDeltaBatch(const DeltaBatch &batch)
+{
+  std::vector<uint8_t> buffer(kDeltaMagic, kDeltaMagic + 4);
+  PutVarint(buffer, static_cast<uint32_t>(batch.baseVersion));
+  PutVarint(buffer, static_cast<uint32_t>(batch.baseVersion >> 32));
+  PutVarint(buffer, static_cast<uint32_t>(batch.deltas.size()));
+  for (const auto &delta : batch.deltas) {
+    buffer.push_back(static_cast<uint8_t>(delta.op));
+    buffer.push_back(static_cast<uint8_t>(delta.entity));
+    PutIndex(buffer, delta.index);
+    PutVarint(buffer, static_cast<uint32_t>(delta.name.size()));
+    buffer.insert(buffer.end(), delta.name.begin(), delta.name.end());
+    PutVarint(buffer, static_cast<uint32_t>(delta.day));
+    PutVarint(buffer, delta.mask);
+    PutIndex(buffer, delta.classId);
+    PutIndex(buffer, delta.teacherId);
+    PutIndex(buffer, delta.subjectId);
+    PutIndex(buffer, delta.periodsPerWeek);
+    buffer.push_back(delta.setSubgroup ? 1 : 0);
+    PutIndex(buffer, delta.subgroup.partition);
+    PutIndex(buffer, delta.subgroup.group);
+  }
+  return buffer;
+}
+
+bool DecodeDeltaBatch(const uint8_t *data, size_t size, DeltaBatch &batch)
+{
+  const uint8_t *cursor = data;
+  const uint8_t *end    = data + size;
+
+  uint32_t low = 0, high = 0, count = 0;
+  if (size < 4 || std::memcmp(data, kDeltaMagic, 4) != 0) {
+    return false;
+  }
+  cursor += 4;
+  if (!GetVarint(cursor, end, low) || !GetVarint(cursor, end, high) ||
+      !GetVarint(cursor, end, count)) {
+    return false;
+  }
+  batch.baseVersion = static_cast<uint64_t>(high) << 32 | low;
+  batch.deltas.clear();
+
+  for (uint32_t i = 0; i < count; ++i) {
+    ConfigDelta delta;
+    uint32_t    length = 0, day = 0;
+    if (end - cursor < 2 ||
+        cursor[0] > static_cast<uint8_t>(DeltaOp::SetAvailability) ||
+        cursor[1] > static_cast<uint8_t>(DeltaEntity::Lesson)) {
+      return false;
+    }
+    delta.op     = static_cast<DeltaOp>(*cursor++);
+    delta.entity = static_cast<DeltaEntity>(*cursor++);
+    if (!GetIndex(cursor, end, delta.index) ||
+        !GetVarint(cursor, end, length) ||
+        static_cast<size_t>(end - cursor) < length) {
+      return false;
+    }
+    delta.name.assign(reinterpret_cast<const char *>(cursor), length);
+    cursor += length;
+    if (!GetVarint(cursor, end, day) || day > 0x7fffffffu ||
+        !GetVarint(cursor, end, delta.mask) ||
+        !GetIndex(cursor, end, delta.classId) ||
+        !GetIndex(cursor, end, delta.teacherId) ||
+        !GetIndex(cursor, end, delta.subjectId) ||
+        !GetIndex(cursor, end, delta.periodsPerWeek) || cursor == end) {
+      return false;
+    }
+    delta.day         = static_cast<int>(day);
+    delta.setSubgroup = *cursor++ != 0;
+    if (!GetIndex(cursor, end, delta.subgroup.partition) ||
+        !GetIndex(cursor, end, delta.subgroup.group)) {
+      return false;
+    }
+    batch.deltas.push_back(std::move(delta));
+  }
+  return cursor == end;
+}
+
+// Per entity of one kind, its index before the batch (-1 for new ones).
+struct EntityOrigins {
+  std::vector<int> origin;
+  bool             reindexed = false;
+};
+
+// The config being edited by one batch, with per lesson its index before
+// the batch (-1 for new lessons), its entity indices and whether it is
+// dirty, and the origins of subjects, teachers and classes in DeltaEntity
+// order.
+struct PendingEdit {
+  TimetableConfig   config;
+  std::vector<int>  origin;
+  LessonIds         ids;
+  std::vector<char> dirty;
+  bool              reindexed = false;
+  EntityOrigins     entities[3];
+};
+
+// Old index to new from the origins of the current items; empty when no
+// item was removed.
+static std::vector<int> MakeIndexMap(const std::vector<int> &origin,
+                                     size_t oldCount, bool reindexed)
+{
+  std::vector<int> map;
+  if (reindexed) {
+    map.assign(oldCount, -1);
+    for (size_t i = 0; i < origin.size(); ++i) {
+      if (origin[i] >= 0) {
+        map[origin[i]] = static_cast<int>(i);
+      }
+    }
+  }
+  return map;
+}
+
+static std::vector<int> &GetEntityIds(LessonIds &ids, DeltaEntity entity)
+{
+  switch (entity) {
+  case DeltaEntity::Subject:
+    return ids.subjects;
+  case DeltaEntity::Teacher:
+    return ids.teachers;
+  default:
+    return ids.classes;
+  }
+}
+
+static void MarkLessonsOf(PendingEdit &edit, DeltaEntity entity, int index)
+{
+  const std::vector<int> &ids = GetEntityIds(edit.ids, entity);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (ids[i] == index) {
+      edit.dirty[i] = 1;
+    }
+  }
+}
+
+static void BuildLesson(TimetableConfig &config, size_t index, int classId,
+                        int teacherId, int subjectId, int periodsPerWeek,
+                        const Subgroup &subgroup)
+{
+  config.lessons[index] = std::make_shared<Lesson>(
+      std::make_shared<Class>(config.classes[classId]),
+      std::make_shared<Teacher>(config.teachers[teacherId]),
+      std::make_shared<Subject>(config.subjects[subjectId]), periodsPerWeek,
+      subgroup);
+}
+
+// Rebuilds the lessons holding a copy of the entity at `index`, which was
+// just changed.
+static void RelinkLessonsOf(PendingEdit &edit, DeltaEntity entity, int index)
+{
+  TimetableConfig        &config = edit.config;
+  const LessonIds        &ids    = edit.ids;
+  const std::vector<int> &owners = GetEntityIds(edit.ids, entity);
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    if (owners[i] != index) {
+      continue;
+    }
+    const auto lesson = config.lessons[i];
+    BuildLesson(config, i, ids.classes[i], ids.teachers[i], ids.subjects[i],
+                lesson->GetPeriodsPerWeek(), lesson->GetSubgroup());
+  }
+}
+
+template <typename T>
+static T Remake(const T &, const std::string &name,
+                const Availability &availability)
+{
+  return T(name, availability);
+}
+
+static Class Remake(const Class &cls, const std::string &name,
+                    const Availability &availability)
+{
+  Class copy(name, availability);
+  for (const auto &partition : cls.GetPartitions()) {
+    copy.AddPartition(partition.name, partition.groups);
+  }
+  return copy;
+}
+
+template <typename T>
+static bool HasName(const std::vector<T> &entities, const std::string &name)
+{
+  return std::any_of(entities.begin(), entities.end(),
+                     [&](const T &entity) { return entity.GetName() == name; });
+}
+
+// Whether the daily rule is aimed at one entity of the kind; subjects have
+// no rules.
+static bool IsRuleOfKind(const DailyRule &rule, DeltaEntity entity)
+{
+  const RuleTarget target = entity == DeltaEntity::Teacher
+                                ? RuleTarget::Teachers
+                                : RuleTarget::Classes;
+  return entity != DeltaEntity::Subject && rule.target == target &&
+         rule.entityId >= 0;
+}
+
+template <typename T>
+static bool ApplyEntityDelta(PendingEdit &edit, std::vector<T> &entities,
+                             const ConfigDelta &delta, std::string &error)
+{
+  TimetableConfig &config  = edit.config;
+  EntityOrigins   &origins = edit.entities[static_cast<int>(delta.entity)];
+  const int        count   = static_cast<int>(entities.size());
+
+  if (delta.op == DeltaOp::Add) {
+    if (delta.name.empty() || HasName(entities, delta.name)) {
+      error = "name '" + delta.name + "' is empty or taken";
+      return false;
+    }
+    Availability availability(config.days, config.periodsPerDay);
+    for (int day = 0; day < config.days; ++day) {
+      availability.SetDay(day, true);
+    }
+    entities.emplace_back(delta.name, availability);
+    origins.origin.push_back(-1);
+    return true;
+  }
+
+  if (delta.index < 0 || delta.index >= count) {
+    error = "no entity " + std::to_string(delta.index);
+    return false;
+  }
+  const T          &entity  = entities[delta.index];
+  const std::string oldName = entity.GetName();
+  Availability      availability(entity.GetAvailability());
+  std::string       name = oldName;
+
+  switch (delta.op) {
+  case DeltaOp::Remove: {
+    std::vector<int> &ids   = GetEntityIds(edit.ids, delta.entity);
+    auto             &rules = config.rules;
+    if (std::find(ids.begin(), ids.end(), delta.index) != ids.end()) {
+      error = "'" + oldName + "' is still taught";
+      return false;
+    }
+    if (std::any_of(rules.begin(), rules.end(), [&](const DailyRule &rule) {
+          return IsRuleOfKind(rule, delta.entity) &&
+                 rule.entityId == delta.index;
+        })) {
+      error = "'" + oldName + "' still has daily rules";
+      return false;
+    }
+    entities.erase(entities.begin() + delta.index);
+    origins.origin.erase(origins.origin.begin() + delta.index);
+    origins.reindexed = true;
+    for (int &id : ids) {
+      id -= id > delta.index ? 1 : 0;
+    }
+    // Rules of later entities follow them down by one.
+    for (DailyRule &rule : rules) {
+      if (IsRuleOfKind(rule, delta.entity) && rule.entityId > delta.index) {
+        --rule.entityId;
+      }
+    }
+    return true;
+  }
+  case DeltaOp::Update:
+    if (delta.name.empty() ||
+        (delta.name != oldName && HasName(entities, delta.name))) {
+      error = "name '" + delta.name + "' is empty or taken";
+      return false;
+    }
+    name = delta.name;
+    break;
+  case DeltaOp::SetAvailability:
+    if (delta.day < 0 || delta.day >= config.days) {
+      error = "no day " + std::to_string(delta.day);
+      return false;
+    }
+    availability.SetDayMask(delta.day, delta.mask);
+    MarkLessonsOf(edit, delta.entity, delta.index);
+    break;
+  default:
+    break;
+  }
+  entities[delta.index] = Remake(entity, name, availability);
+  RelinkLessonsOf(edit, delta.entity, delta.index);
+  return true;
+}
+
+static bool IsValidSubgroup(const Class &cls, const Subgroup &subgroup)
+{
+  if (subgroup.IsWholeClass()) {
+    return true;
+  }
+  const auto &partitions = cls.GetPartitions();
+  return subgroup.partition < static_cast<int>(partitions.size()) &&
+         subgroup.group >= 0 &&
+         subgroup.group <
+             static_cast<int>(partitions[subgroup.partition].groups.size());
+}
+
+static bool ApplyLessonDelta(PendingEdit &edit, const ConfigDelta &delta,
+                             std::string &error)
+{
+  TimetableConfig &config  = edit.config;
+  auto            &lessons = config.lessons;
+  const int        count   = static_cast<int>(lessons.size());
+
+  if (delta.op == DeltaOp::SetAvailability) {
+    error = "lessons have no availability";
+    return false;
+  }
+  if (delta.op != DeltaOp::Add && (delta.index < 0 || delta.index >= count)) {
+    error = "no lesson " + std::to_string(delta.index);
+    return false;
+  }
+
+  if (delta.op == DeltaOp::Remove) {
+    MarkLessonsOf(edit, DeltaEntity::Class, edit.ids.classes[delta.index]);
+    MarkLessonsOf(edit, DeltaEntity::Teacher, edit.ids.teachers[delta.index]);
+    lessons.erase(lessons.begin() + delta.index);
+    edit.origin.erase(edit.origin.begin() + delta.index);
+    edit.ids.classes.erase(edit.ids.classes.begin() + delta.index);
+    edit.ids.teachers.erase(edit.ids.teachers.begin() + delta.index);
+    edit.ids.subjects.erase(edit.ids.subjects.begin() + delta.index);
+    edit.dirty.erase(edit.dirty.begin() + delta.index);
+    edit.reindexed = true;
+    return true;
+  }
+
+  int      classId = -1, teacherId = -1, subjectId = -1, periods = -1;
+  Subgroup subgroup;
+  if (delta.op == DeltaOp::Update) {
+    const Lesson &lesson = *lessons[delta.index];
+    classId              = edit.ids.classes[delta.index];
+    teacherId            = edit.ids.teachers[delta.index];
+    subjectId            = edit.ids.subjects[delta.index];
+    periods              = lesson.GetPeriodsPerWeek();
+    subgroup             = lesson.GetSubgroup();
+  }
+  const int oldClass   = classId;
+  const int oldTeacher = teacherId;
+
+  classId   = delta.classId >= 0 ? delta.classId : classId;
+  teacherId = delta.teacherId >= 0 ? delta.teacherId : teacherId;
+  subjectId = delta.subjectId >= 0 ? delta.subjectId : subjectId;
+  periods   = delta.periodsPerWeek >= 0 ? delta.periodsPerWeek : periods;
+  subgroup  = delta.setSubgroup ? delta.subgroup : subgroup;
+
+  if (classId < 0 || classId >= static_cast<int>(config.classes.size()) ||
+      teacherId < 0 || teacherId >= static_cast<int>(config.teachers.size()) ||
+      subjectId < 0 || subjectId >= static_cast<int>(config.subjects.size())) {
+    error = "lesson refers to a missing class, teacher or subject";
+    return false;
+  }
+  if (periods < 1) {
+    error = "lesson needs at least one period a week";
+    return false;
+  }
+  if (!IsValidSubgroup(config.classes[classId], subgroup)) {
+    error = "class '" + config.classes[classId].GetName() +
+            "' has no such subgroup";
+    return false;
+  }
+
+  size_t index = static_cast<size_t>(delta.index);
+  if (delta.op == DeltaOp::Add) {
+    index = lessons.size();
+    lessons.emplace_back();
+    edit.origin.push_back(-1);
+    edit.ids.classes.push_back(classId);
+    edit.ids.teachers.push_back(teacherId);
+    edit.ids.subjects.push_back(subjectId);
+    edit.dirty.push_back(0);
+  } else {
+    // The lessons it leaves behind may now fit elsewhere.
+    if (classId != oldClass) {
+      MarkLessonsOf(edit, DeltaEntity::Class, oldClass);
+    }
+    if (teacherId != oldTeacher) {
+      MarkLessonsOf(edit, DeltaEntity::Teacher, oldTeacher);
+    }
+  }
+  edit.ids.classes[index]  = classId;
+  edit.ids.teachers[index] = teacherId;
+  edit.ids.subjects[index] = subjectId;
+  BuildLesson(config, index, classId, teacherId, subjectId, periods,
+              subgroup);
+  edit.dirty[index] = 1;
+  return true;
+}
+
+/**
+ * ConfigSync
+ */
+ConfigSync::ConfigSync(const TimetableConfig &config, uint64_t version)
+    : m_Config(config), m_Version(version)
+{
+}
+
+DeltaResult ConfigSync::Apply(const DeltaBatch &batch)
+{
+  DeltaResult result;
+  result.version = m_Version;
+  if (batch.baseVersion != m_Version) {
+    result.error = "batch is based on version " +
+                   std::to_string(batch.baseVersion) + ", current is " +
+                   std::to_string(m_Version);
+    return result;
+  }
+
+  const size_t lessonCount = m_Config.lessons.size();
+  PendingEdit  edit;
+  edit.config = m_Config;
+  edit.origin.resize(lessonCount);
+  edit.ids = m_Config.GetLessonIds();
+  edit.dirty.assign(lessonCount, 0);
+  std::iota(edit.origin.begin(), edit.origin.end(), 0);
+  const size_t entityCounts[3] = {m_Config.subjects.size(),
+                                  m_Config.teachers.size(),
+                                  m_Config.classes.size()};
+  for (int kind = 0; kind < 3; ++kind) {
+    auto &origin = edit.entities[kind].origin;
+    origin.resize(entityCounts[kind]);
+    std::iota(origin.begin(), origin.end(), 0);
+  }
+
+  for (size_t i = 0; i < batch.deltas.size(); ++i) {
+    const ConfigDelta &delta = batch.deltas[i];
+    std::string        error;
+    bool               ok = false;
+    switch (delta.entity) {
+    case DeltaEntity::Subject:
+      ok = ApplyEntityDelta(edit, edit.config.subjects, delta, error);
+      break;
+    case DeltaEntity::Teacher:
+      ok = ApplyEntityDelta(edit, edit.config.teachers, delta, error);
+      break;
+    case DeltaEntity::Class:
+      ok = ApplyEntityDelta(edit, edit.config.classes, delta, error);
+      break;
+    case DeltaEntity::Lesson:
+      ok = ApplyLessonDelta(edit, delta, error);
+      break;
+    }
+    if (!ok) {
+      result.error = "delta " + std::to_string(i) + ": " + error;
+      return result;
+    }
+  }
+
+  for (size_t i = 0; i < edit.dirty.size(); ++i) {
+    if (edit.dirty[i]) {
+      result.dirtyLessons.push_back(static_cast<int>(i));
+    }
+  }
+  result.lessonMap = MakeIndexMap(edit.origin, lessonCount, edit.reindexed);
+  if (edit.reindexed) {
+    // Spreads follow their lesson and go with it.
+    auto &spreads = edit.config.spreads;
+    for (SpreadRule &spread : spreads) {
+      spread.lesson = spread.lesson >= 0 &&
+                              spread.lesson < static_cast<int>(lessonCount)
+                          ? result.lessonMap[spread.lesson]
+                          : -1;
+    }
+    spreads.erase(std::remove_if(spreads.begin(), spreads.end(),
+                                 [](const SpreadRule &spread) {
+                                   return spread.lesson < 0;
+                                 }),
+                  spreads.end());
+  }
+  std::vector<int> *entityMaps[3] = {&result.subjectMap, &result.teacherMap,
+                                     &result.classMap};
+  for (int kind = 0; kind < 3; ++kind) {
+    const EntityOrigins &origins = edit.entities[kind];
+    *entityMaps[kind] =
+        MakeIndexMap(origins.origin, entityCounts[kind], origins.reindexed);
+  }
+
+  m_Config       = std::move(edit.config);
+  result.applied = true;
+  result.version = ++m_Version;
+  return result;
+}
+
+static int FindRoot(std::vector<int> &parents, int node)
+{
+  while (parents[node] != node) {
+    parents[node] = parents[parents[node]];
+    node          = parents[node];
+  }
+  return node;
+}
+
+std::vector<int>
+ConfigSync::GetAffectedLessons(const std::vector<int> &lessons) const
+{
+  // Union-find over classes and then teachers, joined by their lessons.
+  const int        numClasses = static_cast<int>(m_Config.classes.size());
+  const auto      &all        = m_Config.lessons;
+  std::vector<int> parents(numClasses + m_Config.teachers.size());
+  std::vector<int> nodes(all.size());
+  const LessonIds  ids = m_Config.GetLessonIds();
+  std::iota(parents.begin(), parents.end(), 0);
+  for (size_t i = 0; i < all.size(); ++i) {
+    int classNode   = ids.classes[i];
+    int teacherNode = numClasses + ids.teachers[i];
+    parents[FindRoot(parents, classNode)] = FindRoot(parents, teacherNode);
+    nodes[i]                              = classNode;
+  }
+
+  // Lessons the config does not have are skipped.
+  std::vector<char> affected(parents.size(), 0);
+  for (int lesson : lessons) {
+    if (lesson >= 0 && lesson < static_cast<int>(all.size())) {
+      affected[FindRoot(parents, nodes[lesson])] = 1;
+    }
+  }
+  std::vector<int> result;
+  for (size_t i = 0; i < all.size(); ++i) {
+    if (affected[FindRoot(parents, nodes[i])]) {
+      result.push_back(static_cast<int>(i));
+    }
+  }
+  return result;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+// Incremental edits of a config as the client sends them, so an edit costs
+// the size of the change rather than a full config upload.
+//
+// The client and the core each hold a replica of the config. Every batch of
+// deltas names the version it was made against; the core applies it only
+// when that is still its current version, all deltas or none, and then
+// bumps the version. A rejected batch tells the client to resync.
+
+enum class DeltaEntity : uint8_t { Subject, Teacher, Class, Lesson };
+
+enum class DeltaOp : uint8_t {
+  Add,             // Appends an entity; a new lesson takes the lesson fields
+  Update,          // Renames an entity, or changes a lesson's fields
+  Remove,          // Subjects, teachers and classes no lesson or rule uses
+  SetAvailability, // Replaces one day word of an entity's availability
+};
+
+struct ConfigDelta {
+  DeltaOp     op     = DeltaOp::Update;
+  DeltaEntity entity = DeltaEntity::Lesson;
+  int         index  = -1; // Entity to change; unused by Add
+  std::string name;        // Add and Update of subjects, teachers, classes
+
+  // SetAvailability: bit p of the mask is period p of the day.
+  int      day  = 0;
+  uint32_t mask = 0;
+
+  // Lesson fields for Add and Update; on Update, -1 keeps the current
+  // value and the subgroup only changes when setSubgroup is true.
+  int      classId        = -1;
+  int      teacherId      = -1;
+  int      subjectId      = -1;
+  int      periodsPerWeek = -1;
+  bool     setSubgroup    = false;
+  Subgroup subgroup;
+};
+
+struct DeltaBatch {
+  uint64_t                 baseVersion = 0;
+  std::vector<ConfigDelta> deltas;
+};
+
+// Wire form of a batch: magic "TWDL", then varints for the base version
+// (low and high word), the delta count and per delta its fields. Decoding
+// fails on truncated or malformed input.
+std::vector<uint8_t> EncodeDeltaBatch(const DeltaBatch &batch);
+bool DecodeDeltaBatch(const uint8_t *data, size_t size, DeltaBatch &batch);
+
+struct DeltaResult {
+  bool        applied = false;
+  uint64_t    version = 0; // Current version after the call
+  std::string error;       // Why the batch was rejected
+
+  // Lessons whose own constraints changed or that now compete with a
+  // different set of lessons, as sorted indices into the new lesson list.
+  std::vector<int> dirtyLessons;
+
+  // Old lesson index to new, -1 for removed lessons; empty when no lesson
+  // was removed and indices are unchanged. Spreads of kept lessons are
+  // already renumbered, those of removed lessons dropped.
+  std::vector<int> lessonMap;
+
+  // The same per entity kind, for the entity indices of the config; daily
+  // rules of the kept entities are already renumbered.
+  std::vector<int> subjectMap;
+  std::vector<int> teacherMap;
+  std::vector<int> classMap;
+};
+
+// Core side replica of the client's config.
+//
+// Lessons hold copies of their class, teacher and subject, so changing an
+// entity rebuilds the lessons that refer to it. The dirty lessons of a
+// batch are those that were added or changed, those of an entity whose
+// availability changed, and those sharing a class or teacher with a lesson
+// that was removed or moved away, which gained room. Lessons outside the
+// class and teacher components of the dirty ones keep their placements, so
+// only GetAffectedLessons(dirty) needs indexing and solving again.
+class ConfigSync
+{
+public:
+  explicit ConfigSync(const TimetableConfig &config, uint64_t version = 0);
+
+  uint64_t               GetVersion() const { return m_Version; }
+  const TimetableConfig &GetConfig() const { return m_Config; }
+
+  DeltaResult Apply(const DeltaBatch &batch);
+
+  // The given lessons plus all lessons connected to them through shared
+  // classes and teachers, sorted. Indices outside the config are ignored.
+  std::vector<int> GetAffectedLessons(const std::vector<int> &lessons) const;
+
+private:
+  TimetableConfig m_Config;
+  uint64_t        m_Version;
+};
+}; // namespace TimetableWeaver
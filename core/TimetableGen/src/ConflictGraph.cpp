@@ -0,0 +1,56 @@
+#include "ConflictGraph.hpp"
+
+#include <algorithm>
+
+namespace TimetableWeaver
+{
+/**
+ * ConflictGraph
+ */
+ConflictGraph::ConflictGraph(const std::vector<std::vector<int>> &resources,
+                             int                                 numResources)
+{
+  const int numItems = static_cast<int>(resources.size());
+
+  // Items per resource, then every item's neighbours through them.
+  std::vector<std::vector<int>> users(numResources);
+  for (int i = 0; i < numItems; ++i) {
+    for (int r : resources[i]) {
+      if (r >= 0 && r < numResources) {
+        users[r].push_back(i);
+      }
+    }
+  }
+
+  std::vector<int> seenBy(numItems, -1);
+  m_Offsets.reserve(numItems + 1);
+  for (int i = 0; i < numItems; ++i) {
+    const size_t first = m_Neighbours.size();
+    seenBy[i]          = i;
+    for (int r : resources[i]) {
+      if (r < 0 || r >= numResources) {
+        continue;
+      }
+      for (int j : users[r]) {
+        if (seenBy[j] != i) {
+          seenBy[j] = i;
+          m_Neighbours.push_back(j);
+        }
+      }
+    }
+    std::sort(m_Neighbours.begin() + first, m_Neighbours.end());
+    m_Offsets.push_back(static_cast<int64_t>(m_Neighbours.size()));
+  }
+}
+
+int ConflictGraph::GetDegree(int item) const
+{
+  return static_cast<int>(m_Offsets[item + 1] - m_Offsets[item]);
+}
+
+ConflictGraph::Range ConflictGraph::GetNeighbours(int item) const
+{
+  const int *data = m_Neighbours.data();
+  return {data + m_Offsets[item], data + m_Offsets[item + 1]};
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace TimetableWeaver
+{
+// Undirected graph between items that share a resource, e.g. exams sitting
+// by the same student group or lessons of the same teacher. Neighbours are
+// kept as compressed adjacency lists, sorted and without duplicates.
+class ConflictGraph
+{
+public:
+  struct Range {
+    const int *first = nullptr;
+    const int *last  = nullptr;
+
+    const int *begin() const { return first; }
+    const int *end() const { return last; }
+  };
+
+  ConflictGraph() = default;
+
+  // `resources[i]` lists the resource ids item i uses; ids are in
+  // [0, numResources).
+  ConflictGraph(const std::vector<std::vector<int>> &resources,
+                int                                 numResources);
+
+  int     GetSize() const { return static_cast<int>(m_Offsets.size()) - 1; }
+  int64_t GetEdgeCount() const { return m_Neighbours.size() / 2; }
+
+  int   GetDegree(int item) const;
+  Range GetNeighbours(int item) const;
+
+private:
+  std::vector<int64_t> m_Offsets = {0};
+  std::vector<int>     m_Neighbours;
+};
+}; // namespace TimetableWeaver
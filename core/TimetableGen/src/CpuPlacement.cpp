@@ -0,0 +1,349 @@
+#include "CpuPlacement.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace TimetableWeaver
+{
+#ifdef __linux__
+static const char kSysCpu[]  = "/sys/devices/system/cpu/";
+static const char kSysNode[] = "/sys/devices/system/node/";
+
+// Parses a kernel CPU list such as "0-3,8,10-11".
+static std::vector<int> ParseCpuList(const std::string &text)
+{
+  std::vector<int> cpus;
+  size_t           position = 0;
+  while (position < text.size()) {
+    size_t end = text.find(',', position);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    const std::string range = text.substr(position, end - position);
+    const size_t      dash  = range.find('-');
+    try {
+      const int first = std::stoi(range.substr(0, dash));
+      const int last  = dash == std::string::npos
+                            ? first
+                            : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception &) {
+      // Blank or malformed entries are skipped.
+    }
+    position = end + 1;
+  }
+  return cpus;
+}
+
+static std::string ReadLine(const std::string &path)
+{
+  std::ifstream stream(path);
+  std::string   line;
+  std::getline(stream, line);
+  return line;
+}
+
+static int ReadInt(const std::string &path, int fallback)
+{
+  try {
+    return std::stoi(ReadLine(path));
+  } catch (const std::exception &) {
+    return fallback;
+  }
+}
+#endif
+
+static std::vector<int> GetThreadAffinity()
+{
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+static bool SetThreadAffinity(const std::vector<int> &cpus)
+{
+  if (cpus.empty()) {
+    return false;
+  }
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+  DWORD_PTR mask = 0;
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < static_cast<int>(sizeof(mask) * 8)) {
+      mask |= DWORD_PTR(1) << cpu;
+    }
+  }
+  return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * CpuTopology
+ */
+CpuTopology::CpuTopology(std::vector<LogicalCpu> cpus)
+    : m_Cpus(std::move(cpus))
+{
+}
+
+CpuTopology CpuTopology::Detect()
+{
+  std::vector<LogicalCpu> cpus;
+#ifdef __linux__
+  std::map<int, int> nodeOf;
+  for (int node : ParseCpuList(ReadLine(std::string(kSysNode) + "online"))) {
+    const std::string path =
+        kSysNode + std::string("node") + std::to_string(node) + "/cpulist";
+    for (int cpu : ParseCpuList(ReadLine(path))) {
+      nodeOf[cpu] = node;
+    }
+  }
+  for (int id : GetThreadAffinity()) {
+    const std::string topology =
+        kSysCpu + std::string("cpu") + std::to_string(id) + "/topology/";
+    LogicalCpu cpu;
+    cpu.id      = id;
+    cpu.core    = ReadInt(topology + "core_id", id);
+    cpu.package = ReadInt(topology + "physical_package_id", 0);
+    cpu.node    = nodeOf.count(id) ? nodeOf[id] : 0;
+    cpus.push_back(cpu);
+  }
+#endif
+  if (cpus.empty()) {
+    const int count = std::max(1u, std::thread::hardware_concurrency());
+    for (int id = 0; id < count; ++id) {
+      LogicalCpu cpu;
+      cpu.id   = id;
+      cpu.core = id;
+      cpus.push_back(cpu);
+    }
+  }
+  return CpuTopology(std::move(cpus));
+}
+
+int CpuTopology::GetNodeCount() const
+{
+  std::set<int> nodes;
+  for (const auto &cpu : m_Cpus) {
+    nodes.insert(cpu.node);
+  }
+  return static_cast<int>(nodes.size());
+}
+
+int CpuTopology::GetCoreCount() const
+{
+  std::set<std::pair<int, int>> cores;
+  for (const auto &cpu : m_Cpus) {
+    cores.insert({cpu.package, cpu.core});
+  }
+  return static_cast<int>(cores.size());
+}
+
+void CpuTopology::Print(std::ostream &stream) const
+{
+  stream << m_Cpus.size() << " CPUs, " << GetCoreCount() << " cores, "
+         << GetNodeCount() << " NUMA nodes\n";
+  std::map<int, std::vector<int>> byNode;
+  for (const auto &cpu : m_Cpus) {
+    byNode[cpu.node].push_back(cpu.id);
+  }
+  for (const auto &[node, ids] : byNode) {
+    stream << "  node " << node << ":";
+    for (int id : ids) {
+      stream << " " << id;
+    }
+    stream << "\n";
+  }
+}
+
+// Cores, or single CPUs, handed out as a whole.
+struct CpuUnit {
+  int              node = 0;
+  std::vector<int> cpus;
+};
+
+static CpuPartition MakePartition(std::vector<CpuUnit>::const_iterator first,
+                                  std::vector<CpuUnit>::const_iterator last)
+{
+  CpuPartition partition;
+  partition.node = first != last ? first->node : -1;
+  for (auto unit = first; unit != last; ++unit) {
+    partition.cpus.insert(partition.cpus.end(), unit->cpus.begin(),
+                          unit->cpus.end());
+    partition.node = unit->node == partition.node ? partition.node : -1;
+    ++partition.cores;
+  }
+  return partition;
+}
+
+// Splits [first, last) into `count` contiguous runs of near equal size.
+static void SplitRun(std::vector<CpuUnit>::const_iterator first,
+                     std::vector<CpuUnit>::const_iterator last, int count,
+                     std::vector<CpuPartition> &partitions)
+{
+  const int size = static_cast<int>(last - first);
+  for (int k = 0; k < count; ++k) {
+    partitions.push_back(MakePartition(first + k * size / count,
+                                       first + (k + 1) * size / count));
+  }
+}
+
+std::vector<CpuPartition> PartitionCpus(const CpuTopology &topology,
+                                        int                count)
+{
+  count = std::max(1, count);
+
+  std::vector<LogicalCpu> cpus = topology.GetCpus();
+  std::sort(cpus.begin(), cpus.end(),
+            [](const LogicalCpu &a, const LogicalCpu &b) {
+              return std::tie(a.node, a.package, a.core, a.id) <
+                     std::tie(b.node, b.package, b.core, b.id);
+            });
+
+  std::vector<CpuUnit> units;
+  const bool           splitCores = count > topology.GetCoreCount();
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    const bool sibling = i > 0 && !splitCores &&
+                         cpus[i].node == cpus[i - 1].node &&
+                         cpus[i].package == cpus[i - 1].package &&
+                         cpus[i].core == cpus[i - 1].core;
+    if (!sibling) {
+      units.push_back({cpus[i].node, {}});
+    }
+    units.back().cpus.push_back(cpus[i].id);
+  }
+
+  std::vector<CpuPartition> partitions;
+  const int                 numUnits = static_cast<int>(units.size());
+  if (numUnits == 0) {
+    return std::vector<CpuPartition>(count);
+  }
+  if (count > numUnits) {
+    for (int p = 0; p < count; ++p) {
+      const auto unit = units.cbegin() + p % numUnits;
+      partitions.push_back(MakePartition(unit, unit + 1));
+    }
+    return partitions;
+  }
+
+  // Runs of units per node, in node order.
+  std::vector<std::pair<int, int>> runs; // First unit, unit count
+  for (int u = 0; u < numUnits; ++u) {
+    if (u == 0 || units[u].node != units[u - 1].node) {
+      runs.push_back({u, 0});
+    }
+    ++runs.back().second;
+  }
+  const int numNodes = static_cast<int>(runs.size());
+  if (count < numNodes) {
+    SplitRun(units.begin(), units.end(), count, partitions);
+    return partitions;
+  }
+
+  // Partitions per node in proportion to its units, at least one each.
+  std::vector<int> shares(numNodes);
+  int              assigned = 0;
+  for (int n = 0; n < numNodes; ++n) {
+    shares[n] = std::max(1, count * runs[n].second / numUnits);
+    shares[n] = std::min(shares[n], runs[n].second);
+    assigned += shares[n];
+  }
+  auto unitsPer = [&](int n) {
+    return static_cast<double>(runs[n].second) / shares[n];
+  };
+  while (assigned < count) {
+    int best = -1;
+    for (int n = 0; n < numNodes; ++n) {
+      if (shares[n] < runs[n].second &&
+          (best < 0 || unitsPer(n) > unitsPer(best))) {
+        best = n;
+      }
+    }
+    ++shares[best];
+    ++assigned;
+  }
+  while (assigned > count) {
+    int best = -1;
+    for (int n = 0; n < numNodes; ++n) {
+      if (shares[n] > 1 && (best < 0 || unitsPer(n) < unitsPer(best))) {
+        best = n;
+      }
+    }
+    --shares[best];
+    --assigned;
+  }
+
+  for (int n = 0; n < numNodes; ++n) {
+    const auto first = units.cbegin() + runs[n].first;
+    SplitRun(first, first + runs[n].second, shares[n], partitions);
+  }
+  return partitions;
+}
+
+/**
+ * ScopedAffinity
+ */
+ScopedAffinity::ScopedAffinity(const CpuPartition &partition)
+{
+#ifdef _WIN32
+  // Windows hands back the old mask when setting a new one.
+  DWORD_PTR mask = 0;
+  for (int cpu : partition.cpus) {
+    if (cpu >= 0 && cpu < static_cast<int>(sizeof(mask) * 8)) {
+      mask |= DWORD_PTR(1) << cpu;
+    }
+  }
+  const DWORD_PTR previous =
+      mask != 0 ? SetThreadAffinityMask(GetCurrentThread(), mask) : 0;
+  for (int cpu = 0; cpu < static_cast<int>(sizeof(previous) * 8); ++cpu) {
+    if (previous >> cpu & 1) {
+      m_Previous.push_back(cpu);
+    }
+  }
+  m_Pinned = previous != 0;
+#else
+  m_Previous = GetThreadAffinity();
+  m_Pinned   = !m_Previous.empty() && SetThreadAffinity(partition.cpus);
+#endif
+}
+
+ScopedAffinity::~ScopedAffinity()
+{
+  if (m_Pinned) {
+    SetThreadAffinity(m_Previous);
+  }
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace TimetableWeaver
+{
+struct LogicalCpu {
+  int id      = 0;
+  int core    = 0; // Physical core id within its package
+  int package = 0;
+  int node    = 0; // NUMA node
+};
+
+// The CPUs this process may run on, with the cores, packages and NUMA
+// nodes they belong to.
+class CpuTopology
+{
+public:
+  CpuTopology() = default;
+  explicit CpuTopology(std::vector<LogicalCpu> cpus);
+
+  // On Linux reads sysfs and keeps the CPUs of the affinity mask, so
+  // taskset and container limits are respected. Elsewhere every hardware
+  // thread counts as its own core on a single node.
+  static CpuTopology Detect();
+
+  const std::vector<LogicalCpu> &GetCpus() const { return m_Cpus; }
+
+  int GetNodeCount() const;
+  int GetCoreCount() const; // Physical cores
+
+  void Print(std::ostream &stream) const;
+
+private:
+  std::vector<LogicalCpu> m_Cpus;
+};
+
+struct CpuPartition {
+  std::vector<int> cpus;       // Logical CPU ids
+  int              cores = 0;  // Physical cores, or CPUs when split finer
+  int              node  = -1; // NUMA node, -1 when it spans several
+
+  // CP-SAT workers to run here: one per core, as SMT siblings add little
+  // to a search that is bound by memory latency.
+  int GetWorkerCount() const { return cores > 0 ? cores : 1; }
+};
+
+// Splits the CPUs into `count` partitions for as many concurrent solves.
+// SMT siblings stay together and partitions do not cross NUMA nodes when
+// there are at least as many partitions as nodes; nodes get partitions in
+// proportion to their cores. With more partitions than cores, siblings are
+// split, and with more than CPUs, partitions share CPUs.
+std::vector<CpuPartition> PartitionCpus(const CpuTopology &topology,
+                                        int                count);
+
+// Pins the calling thread to the partition's CPUs for its lifetime and
+// restores the previous mask afterwards. Pinning is supported on Linux and
+// Windows and does nothing elsewhere. Only on Linux do threads started
+// meanwhile, such as the CP-SAT workers of a solve, inherit the mask;
+// Windows thread affinity is per thread, so there the workers still run
+// on any CPU of the process.
+class ScopedAffinity
+{
+public:
+  explicit ScopedAffinity(const CpuPartition &partition);
+  ~ScopedAffinity();
+
+  ScopedAffinity(const ScopedAffinity &)            = delete;
+  ScopedAffinity &operator=(const ScopedAffinity &) = delete;
+
+  bool IsPinned() const { return m_Pinned; }
+
+private:
+  bool             m_Pinned = false;
+  std::vector<int> m_Previous;
+};
+}; // namespace TimetableWeaver
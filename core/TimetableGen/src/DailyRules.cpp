@@ -0,0 +1,43 @@
+#include "DailyRules.hpp"
+
+namespace TimetableWeaver
+{
+/**
+ * DailyRule
+ */
+DailyRule DailyRule::MaxConsecutive(RuleTarget target, int limit)
+{
+  DailyRule rule;
+  rule.kind   = DailyRuleKind::MaxConsecutive;
+  rule.target = target;
+  rule.limit  = limit;
+  return rule;
+}
+
+DailyRule DailyRule::MaxPerDay(RuleTarget target, int limit)
+{
+  DailyRule rule;
+  rule.kind   = DailyRuleKind::MaxPerDay;
+  rule.target = target;
+  rule.limit  = limit;
+  return rule;
+}
+
+DailyRule DailyRule::NoGaps(RuleTarget target)
+{
+  DailyRule rule;
+  rule.kind   = DailyRuleKind::NoGaps;
+  rule.target = target;
+  return rule;
+}
+
+DailyRule DailyRule::Break(RuleTarget target, int firstPeriod, int lastPeriod)
+{
+  DailyRule rule;
+  rule.kind        = DailyRuleKind::Break;
+  rule.target      = target;
+  rule.firstPeriod = firstPeriod;
+  rule.lastPeriod  = lastPeriod;
+  return rule;
+}
+}; // namespace TimetableWeaver
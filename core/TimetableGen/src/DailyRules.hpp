@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+namespace TimetableWeaver
+{
+enum class DailyRuleKind {
+  MaxConsecutive, // At most `limit` consecutive busy periods
+  MaxPerDay,      // At most `limit` busy periods per day
+  NoGaps,         // No free period between two busy ones
+  Break           // At least one free period in [firstPeriod, lastPeriod]
+};
+
+enum class RuleTarget { Classes, Teachers };
+
+struct DailyRule {
+  DailyRuleKind kind        = DailyRuleKind::MaxPerDay;
+  RuleTarget    target      = RuleTarget::Classes;
+  int           entityId    = -1; // -1 applies the rule to every entity
+  int           limit       = 0;
+  int           firstPeriod = 0;
+  int           lastPeriod  = 0;
+  bool          hard        = true;
+  int           weight      = 1; // Penalty per violation when soft
+
+  static DailyRule MaxConsecutive(RuleTarget target, int limit);
+  static DailyRule MaxPerDay(RuleTarget target, int limit);
+  static DailyRule NoGaps(RuleTarget target);
+  static DailyRule Break(RuleTarget target, int firstPeriod, int lastPeriod);
+};
+
+// Weekly shape of one lesson: its periods come as blocks of consecutive
+// periods, one block per teaching day, e.g. {2, 1, 1} for a double and two
+// singles. Teaching days are at least `minDayGap` apart, so 2 keeps them
+// non-adjacent. Blocks must add up to the lesson's weekly periods, and a
+// lesson has at most one spread. Only the pattern formulation models them.
+struct SpreadRule {
+  int              lesson = -1; // Config lesson index
+  std::vector<int> blocks;
+  int              minDayGap = 1;
+  bool             hard      = true;
+  int              weight    = 1; // Penalty when soft and not met
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,305 @@
+#include "DomainPropagator.hpp"
+
+#include <map>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+// Availability supports at most seven days.
+static const int kMaxDays = 7;
+
+namespace
+{
+// A set of slots as one period mask per day.
+struct SlotSet {
+  uint32_t days[kMaxDays] = {};
+};
+
+bool Intersects(const SlotSet &a, const SlotSet &b, int numDays)
+{
+  for (int d = 0; d < numDays; ++d) {
+    if ((a.days[d] & b.days[d]) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Bipartite matching between the periods a group of lessons needs and the
+// slots in their domains; a lesson holds at most one period per slot.
+class GroupMatching
+{
+public:
+  GroupMatching(const std::vector<SlotSet> &domains, int numDays)
+      : m_Domains(domains), m_Days(numDays), m_Owned(domains.size()),
+        m_Owner(numDays * 32, -1)
+  {
+  }
+
+  // Gives one more slot to the lesson, rerouting others along an
+  // augmenting path if needed.
+  bool Augment(int lesson)
+  {
+    SlotSet visited;
+    return Augment(lesson, visited);
+  }
+
+  const SlotSet &GetOwned(int lesson) const { return m_Owned[lesson]; }
+
+private:
+  bool Augment(int lesson, SlotSet &visited)
+  {
+    const SlotSet &domain = m_Domains[lesson];
+    SlotSet       &owned  = m_Owned[lesson];
+    for (int d = 0; d < m_Days; ++d) {
+      for (uint32_t mask = domain.days[d] & ~owned.days[d]; mask != 0;
+           mask &= mask - 1) {
+        const int      p   = CountTrailingZeros(mask);
+        const uint32_t bit = 1u << p;
+        if ((visited.days[d] & bit) != 0) {
+          continue;
+        }
+        visited.days[d] |= bit;
+
+        int &owner = m_Owner[d * 32 + p];
+        if (owner < 0 || Augment(owner, visited)) {
+          if (owner >= 0) {
+            m_Owned[owner].days[d] &= ~bit;
+          }
+          owner = lesson;
+          owned.days[d] |= bit;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  const std::vector<SlotSet> &m_Domains;
+  int                         m_Days;
+  std::vector<SlotSet>        m_Owned;
+  std::vector<int>            m_Owner; // Per (day, period), -1 when free
+};
+} // namespace
+
+/**
+ * DomainPropagator
+ */
+DomainPropagator::DomainPropagator(const TimetableConfig &config)
+    : m_Config(config), m_Days(config.days), m_Periods(config.periodsPerDay)
+{
+  const uint32_t periodMask =
+      m_Periods >= 32 ? ~0u : (uint32_t(1) << m_Periods) - 1;
+
+  // Whole-class lessons, and subgroup lessons by (partition, group), per
+  // class.
+  std::vector<std::vector<int>> whole(config.classes.size());
+  std::vector<std::map<std::pair<int, int>, std::vector<int>>> split(
+      config.classes.size());
+
+  const LessonIds ids = config.GetLessonIds();
+  m_Groups.resize(config.teachers.size());
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    const auto &lesson = config.lessons[i];
+    m_Demand.push_back(lesson->GetPeriodsPerWeek());
+
+    int size = 0;
+    for (int d = 0; d < m_Days; ++d) {
+      const uint32_t mask = lesson->GetClass()->GetAvailability().GetDay(d) &
+                            lesson->GetTeacher()->GetAvailability().GetDay(d) &
+                            periodMask;
+      m_Domains.push_back(mask);
+      size += PopCount(mask);
+    }
+    m_InitialSizes.push_back(size);
+
+    const int       classId   = ids.classes[i];
+    const int       teacherId = ids.teachers[i];
+    const Subgroup &subgroup  = lesson->GetSubgroup();
+    if (classId >= 0 && subgroup.IsWholeClass()) {
+      whole[classId].push_back(static_cast<int>(i));
+    } else if (classId >= 0) {
+      split[classId][{subgroup.partition, subgroup.group}].push_back(
+          static_cast<int>(i));
+    }
+    if (teacherId >= 0) {
+      m_Groups[teacherId].push_back(static_cast<int>(i));
+    }
+  }
+
+  // Whole-class lessons clash with each other and with every subgroup
+  // lesson; lessons of one group clash with each other.
+  for (size_t c = 0; c < config.classes.size(); ++c) {
+    if (split[c].empty()) {
+      m_Groups.emplace_back(whole[c].begin(), whole[c].end());
+    }
+    for (const auto &[key, lessons] : split[c]) {
+      m_Groups.emplace_back(whole[c].begin(), whole[c].end());
+      m_Groups.back().insert(m_Groups.back().end(), lessons.begin(),
+                             lessons.end());
+    }
+  }
+}
+
+bool DomainPropagator::Propagate()
+{
+  if (m_Days > kMaxDays) {
+    std::cerr << "Domain propagation supports at most " << kMaxDays
+              << " days\n";
+    return false;
+  }
+
+  m_Rounds     = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    ++m_Rounds;
+    for (const auto &group : m_Groups) {
+      if (!Revise(group, changed)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Makes one class or teacher domain consistent. Given a maximum matching,
+// lesson i can take a slot s it does not hold when s is free, or when the
+// lesson holding s can move to another slot and the chain of moves ends in
+// a free slot or in one of i's own slots, which i then releases.
+bool DomainPropagator::Revise(const ArenaVector<int> &group, bool &changed)
+{
+  const int            n = static_cast<int>(group.size());
+  std::vector<SlotSet> domains(n);
+  for (int i = 0; i < n; ++i) {
+    for (int d = 0; d < m_Days; ++d) {
+      domains[i].days[d] = m_Domains[group[i] * m_Days + d];
+    }
+  }
+
+  GroupMatching matching(domains, m_Days);
+  for (int i = 0; i < n; ++i) {
+    for (int k = 0; k < m_Demand[group[i]]; ++k) {
+      if (!matching.Augment(i)) {
+        return false;
+      }
+    }
+  }
+
+  // Slots from which a chain of moves reaches a free slot.
+  SlotSet toFree;
+  for (int i = 0; i < n; ++i) {
+    for (int d = 0; d < m_Days; ++d) {
+      toFree.days[d] |= domains[i].days[d];
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    for (int d = 0; d < m_Days; ++d) {
+      toFree.days[d] &= ~matching.GetOwned(i).days[d];
+    }
+  }
+  std::vector<bool> reachesFree(n, false);
+  for (bool grew = true; grew;) {
+    grew = false;
+    for (int j = 0; j < n; ++j) {
+      if (reachesFree[j]) {
+        continue;
+      }
+      SlotSet open = domains[j];
+      for (int d = 0; d < m_Days; ++d) {
+        open.days[d] &= ~matching.GetOwned(j).days[d];
+      }
+      if (Intersects(open, toFree, m_Days)) {
+        reachesFree[j] = true;
+        grew           = true;
+        for (int d = 0; d < m_Days; ++d) {
+          toFree.days[d] |= matching.GetOwned(j).days[d];
+        }
+      }
+    }
+  }
+
+  // moves[j][k]: lesson j can take over one of k's slots.
+  std::vector<std::vector<bool>> moves(n, std::vector<bool>(n, false));
+  for (int j = 0; j < n; ++j) {
+    for (int k = 0; k < n; ++k) {
+      moves[j][k] =
+          j != k && Intersects(domains[j], matching.GetOwned(k), m_Days);
+    }
+  }
+
+  std::vector<int> queue;
+  for (int i = 0; i < n; ++i) {
+    SlotSet open = toFree;
+    for (int d = 0; d < m_Days; ++d) {
+      open.days[d] |= matching.GetOwned(i).days[d];
+    }
+
+    // Lessons whose slots i can take because they can move towards i.
+    std::vector<bool> seen(n, false);
+    seen[i] = true;
+    queue.assign(1, i);
+    for (size_t q = 0; q < queue.size(); ++q) {
+      for (int j = 0; j < n; ++j) {
+        if (!seen[j] && moves[j][queue[q]]) {
+          seen[j] = true;
+          queue.push_back(j);
+          for (int d = 0; d < m_Days; ++d) {
+            open.days[d] |= matching.GetOwned(j).days[d];
+          }
+        }
+      }
+    }
+
+    uint32_t *domain = &m_Domains[group[i] * m_Days];
+    for (int d = 0; d < m_Days; ++d) {
+      if ((domain[d] & ~open.days[d]) != 0) {
+        domain[d] &= open.days[d];
+        changed = true;
+      }
+    }
+  }
+  return true;
+}
+
+uint32_t DomainPropagator::GetDomain(int lesson, int day) const
+{
+  return m_Domains[lesson * m_Days + day];
+}
+
+int DomainPropagator::GetDomainSize(int lesson) const
+{
+  int size = 0;
+  for (int d = 0; d < m_Days; ++d) {
+    size += PopCount(GetDomain(lesson, d));
+  }
+  return size;
+}
+
+int DomainPropagator::GetInitialDomainSize(int lesson) const
+{
+  return m_InitialSizes[lesson];
+}
+
+void DomainPropagator::Print(std::ostream &stream) const
+{
+  stream << "Lesson domains:\n";
+  for (size_t i = 0; i < m_Config.lessons.size(); ++i) {
+    const auto &lesson   = m_Config.lessons[i];
+    const int   lessonId = static_cast<int>(i);
+    stream << "  Lesson " << i << " (" << lesson->GetClass()->GetName()
+           << ", " << lesson->GetTeacher()->GetName() << ", "
+           << lesson->GetSubject()->GetName() << "): "
+           << GetDomainSize(lessonId) << " of "
+           << GetInitialDomainSize(lessonId) << " slots\n";
+    for (int d = 0; d < m_Days; ++d) {
+      stream << "    Day " << d << ": ";
+      for (int p = 0; p < m_Periods; ++p) {
+        stream << ((GetDomain(lessonId, d) >> p & 1) != 0 ? '#' : '.');
+      }
+      stream << "\n";
+    }
+  }
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "RequestArena.hpp"
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+// Computes the slots every lesson can still take in some clash-free
+// schedule, without searching for one.
+//
+// Each teacher is a cardinality constraint: its lessons need their weekly
+// periods on pairwise different slots. So is each class, or, when it is
+// split, each of its groups together with its whole-class lessons. The
+// propagator makes every such constraint domain consistent with a
+// bipartite matching between lesson periods and slots. A slot stays in a
+// lesson's domain only if some maximum matching gives it to that lesson,
+// which covers Hall sets such as three lessons of one teacher that can only
+// go to three slots. Classes and teachers are revisited until no domain
+// shrinks.
+//
+// Daily rules are not propagated, so the domains may still contain slots
+// that a rule excludes; every removed slot is impossible.
+class DomainPropagator
+{
+public:
+  explicit DomainPropagator(const TimetableConfig &config);
+
+  // Runs to the fixpoint. False when some class or teacher cannot place
+  // its lessons at all; the domains are then meaningless.
+  bool Propagate();
+
+  // Mask of the periods of `day` still open to the lesson.
+  uint32_t GetDomain(int lesson, int day) const;
+  int      GetDomainSize(int lesson) const;
+
+  // Open slots the class and teacher availability alone would allow.
+  int GetInitialDomainSize(int lesson) const;
+
+  int GetRounds() const { return m_Rounds; }
+
+  void Print(std::ostream &stream) const;
+
+private:
+  bool Revise(const ArenaVector<int> &group, bool &changed);
+
+  const TimetableConfig &m_Config;
+
+  int m_Days    = 0;
+  int m_Periods = 0;
+  int m_Rounds  = 0;
+
+  // From the request arena when created inside a RequestScope.
+  ArenaVector<int>              m_Demand;  // Weekly periods per lesson
+  ArenaVector<uint32_t>         m_Domains; // Per (lesson, day)
+  ArenaVector<int>              m_InitialSizes;
+  ArenaVector<ArenaVector<int>> m_Groups; // Lessons that pairwise clash
+};
+}; // namespace TimetableWeaver
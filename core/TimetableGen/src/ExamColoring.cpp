@@ -0,0 +1,325 @@
+#include "ExamColoring.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <tuple>
+
+namespace TimetableWeaver
+{
+/**
+ * ExamColoring
+ */
+ExamColoring::ExamColoring(const ExamConfig &config, const ConflictGraph &graph)
+    : m_Config(config), m_Graph(graph)
+{
+}
+
+bool ExamColoring::Color(const ExamColoringOptions &options)
+{
+  const int periods = m_Config.periodsPerDay;
+  m_NumExams        = static_cast<int>(m_Config.exams.size());
+  m_NumSlots        = m_Config.GetSlotCount();
+  m_Conflicts       = 0;
+  m_Iterations      = 0;
+
+  m_Slots.assign(m_NumExams, -1);
+  m_Allowed.assign(m_NumExams * m_NumSlots, 0);
+  m_Gamma.assign(m_NumExams * m_NumSlots, 0);
+  m_SlotSizes.assign(m_NumSlots, {});
+  m_RoomCapacities.assign(m_NumSlots, {});
+  m_FreeInvigilators.assign(m_NumSlots, 0);
+
+  for (int slot = 0; slot < m_NumSlots; ++slot) {
+    const int day    = slot / periods;
+    const int period = slot % periods;
+    for (const auto &room : m_Config.rooms) {
+      if (room.GetAvailability().Get(day, period)) {
+        m_RoomCapacities[slot].push_back(room.GetCapacity());
+      }
+    }
+    std::sort(m_RoomCapacities[slot].begin(), m_RoomCapacities[slot].end(),
+              std::greater<int>());
+    for (const auto &invigilator : m_Config.invigilators) {
+      if (invigilator.GetAvailability().Get(day, period)) {
+        ++m_FreeInvigilators[slot];
+      }
+    }
+  }
+
+  for (int e = 0; e < m_NumExams; ++e) {
+    bool any = false;
+    for (int d = 0; d < m_Config.days; ++d) {
+      const uint32_t allowed = m_Config.GetAllowedPeriods(e, d);
+      for (int p = 0; p < periods; ++p) {
+        m_Allowed[e * m_NumSlots + d * periods + p] = allowed >> p & 1;
+      }
+      any = any || allowed != 0;
+    }
+    if (!any) {
+      std::cerr << "Exam " << m_Config.exams[e].name
+                << " has no slot all its groups can attend\n";
+      return false;
+    }
+  }
+
+  if (!Dsatur()) {
+    return false;
+  }
+  m_InitialConflicts = m_Conflicts;
+  if (m_Conflicts > 0) {
+    Tabucol(options);
+  }
+  return m_Conflicts == 0;
+}
+
+ExamSchedule ExamColoring::GetSchedule() const
+{
+  ExamSchedule schedule(m_NumExams);
+  for (int e = 0; e < m_NumExams; ++e) {
+    schedule[e].exam   = e;
+    schedule[e].day    = m_Slots[e] / m_Config.periodsPerDay;
+    schedule[e].period = m_Slots[e] % m_Config.periodsPerDay;
+  }
+  return schedule;
+}
+
+bool ExamColoring::Fits(int exam, int slot) const
+{
+  if (!m_Allowed[exam * m_NumSlots + slot] || m_FreeInvigilators[slot] <= 0) {
+    return false;
+  }
+
+  // The k-th largest exam of the slot needs the k-th largest room.
+  const auto &sizes      = m_SlotSizes[slot];
+  const auto &capacities = m_RoomCapacities[slot];
+  if (sizes.size() >= capacities.size()) {
+    return false;
+  }
+  const int students = m_Config.exams[exam].students;
+  bool      merged   = false;
+  size_t    next     = 0;
+  for (size_t k = 0; k <= sizes.size(); ++k) {
+    int size = 0;
+    if (!merged && (next == sizes.size() || students >= sizes[next])) {
+      size   = students;
+      merged = true;
+    } else {
+      size = sizes[next++];
+    }
+    if (size > capacities[k]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ExamColoring::Place(int exam, int slot)
+{
+  auto &sizes = m_SlotSizes[slot];
+  sizes.insert(std::upper_bound(sizes.begin(), sizes.end(),
+                                m_Config.exams[exam].students,
+                                std::greater<int>()),
+               m_Config.exams[exam].students);
+  --m_FreeInvigilators[slot];
+  m_Slots[exam] = slot;
+  Spread(exam, slot, 1);
+}
+
+void ExamColoring::Remove(int exam)
+{
+  const int slot  = m_Slots[exam];
+  auto     &sizes = m_SlotSizes[slot];
+  sizes.erase(std::lower_bound(sizes.begin(), sizes.end(),
+                               m_Config.exams[exam].students,
+                               std::greater<int>()));
+  ++m_FreeInvigilators[slot];
+  m_Slots[exam] = -1;
+  Spread(exam, slot, -1);
+}
+
+void ExamColoring::Spread(int exam, int slot, int delta)
+{
+  const int spacing = std::max(1, m_Config.minSpacing);
+  const int first   = std::max(0, slot - spacing + 1);
+  const int last    = std::min(m_NumSlots - 1, slot + spacing - 1);
+  for (int n : m_Graph.GetNeighbours(exam)) {
+    for (int t = first; t <= last; ++t) {
+      Gamma(n, t) += delta;
+    }
+  }
+}
+
+bool ExamColoring::Dsatur()
+{
+  const int spacing   = std::max(1, m_Config.minSpacing);
+  const int preferred = m_Config.preferredSpacing;
+
+  // Ordered by clash-free slots left, then by degree, largest first.
+  std::vector<int>                    free(m_NumExams, 0);
+  std::set<std::tuple<int, int, int>> queue;
+  for (int e = 0; e < m_NumExams; ++e) {
+    for (int t = 0; t < m_NumSlots; ++t) {
+      free[e] += m_Allowed[e * m_NumSlots + t];
+    }
+    queue.emplace(free[e], -m_Graph.GetDegree(e), e);
+  }
+
+  std::vector<int64_t> cost(m_NumSlots, 0);
+  while (!queue.empty()) {
+    const int exam = std::get<2>(*queue.begin());
+    queue.erase(queue.begin());
+
+    if (preferred > 0) {
+      for (int n : m_Graph.GetNeighbours(exam)) {
+        const int other = m_Slots[n];
+        if (other < 0) {
+          continue;
+        }
+        const int first = std::max(0, other - preferred + 1);
+        const int last  = std::min(m_NumSlots - 1, other + preferred - 1);
+        for (int t = first; t <= last; ++t) {
+          cost[t] += preferred - std::abs(t - other);
+        }
+      }
+    }
+
+    int best = -1;
+    for (int t = 0; t < m_NumSlots; ++t) {
+      if (!Fits(exam, t)) {
+        continue;
+      }
+      if (best < 0 ||
+          std::make_tuple(Gamma(exam, t), cost[t], m_SlotSizes[t].size()) <
+              std::make_tuple(Gamma(exam, best), cost[best],
+                              m_SlotSizes[best].size())) {
+        best = t;
+      }
+    }
+    std::fill(cost.begin(), cost.end(), 0);
+    if (best < 0) {
+      std::cerr << "No slot with a free room and invigilator for exam "
+                << m_Config.exams[exam].name << "\n";
+      return false;
+    }
+
+    const int first = std::max(0, best - spacing + 1);
+    const int last  = std::min(m_NumSlots - 1, best + spacing - 1);
+    for (int n : m_Graph.GetNeighbours(exam)) {
+      if (m_Slots[n] >= 0) {
+        continue;
+      }
+      int lost = 0;
+      for (int t = first; t <= last; ++t) {
+        lost += m_Allowed[n * m_NumSlots + t] && Gamma(n, t) == 0;
+      }
+      if (lost > 0) {
+        queue.erase(std::make_tuple(free[n], -m_Graph.GetDegree(n), n));
+        free[n] -= lost;
+        queue.emplace(free[n], -m_Graph.GetDegree(n), n);
+      }
+    }
+    m_Conflicts += Gamma(exam, best);
+    Place(exam, best);
+  }
+  return true;
+}
+
+void ExamColoring::Tabucol(const ExamColoringOptions &options)
+{
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+
+  std::mt19937     random(options.seed);
+  ArenaVector<int> tabu(m_NumExams * m_NumSlots, 0);
+
+  // Exams with a clash, with their index in the list.
+  std::vector<int> clashing;
+  std::vector<int> position(m_NumExams, -1);
+  auto             refresh = [&](int exam) {
+    const bool clashes = Gamma(exam, m_Slots[exam]) > 0;
+    if (clashes && position[exam] < 0) {
+      position[exam] = static_cast<int>(clashing.size());
+      clashing.push_back(exam);
+    } else if (!clashes && position[exam] >= 0) {
+      const int moved          = clashing.back();
+      clashing[position[exam]] = moved;
+      position[moved]          = position[exam];
+      clashing.pop_back();
+      position[exam] = -1;
+    }
+  };
+  for (int e = 0; e < m_NumExams; ++e) {
+    refresh(e);
+  }
+
+  int              best      = m_Conflicts;
+  std::vector<int> bestSlots = m_Slots;
+  for (; m_Conflicts > 0 && m_Iterations < options.maxIterations;
+       ++m_Iterations) {
+    if ((m_Iterations & 255) == 0 && options.timeLimitSeconds > 0.0 &&
+        std::chrono::duration<double>(Clock::now() - start).count() >
+            options.timeLimitSeconds) {
+      break;
+    }
+
+    int exam = -1, slot = -1, bestDelta = INT_MAX, ties = 0;
+    for (int e : clashing) {
+      const int current = Gamma(e, m_Slots[e]);
+      for (int t = 0; t < m_NumSlots; ++t) {
+        const int delta = Gamma(e, t) - current;
+        if (t == m_Slots[e] || delta > bestDelta ||
+            (tabu[e * m_NumSlots + t] > m_Iterations &&
+             m_Conflicts + delta >= best) ||
+            !Fits(e, t)) {
+          continue;
+        }
+        if (delta < bestDelta) {
+          exam      = e;
+          slot      = t;
+          bestDelta = delta;
+          ties      = 1;
+        } else if (delta == bestDelta && random() % ++ties == 0) {
+          exam = e;
+          slot = t;
+        }
+      }
+    }
+    if (exam < 0) {
+      continue;
+    }
+
+    const int from = m_Slots[exam];
+    Remove(exam);
+    Place(exam, slot);
+    m_Conflicts += bestDelta;
+    tabu[exam * m_NumSlots + from] =
+        m_Iterations + static_cast<int>(random() % 10) +
+        static_cast<int>(0.6 * clashing.size());
+
+    refresh(exam);
+    for (int n : m_Graph.GetNeighbours(exam)) {
+      refresh(n);
+    }
+    if (m_Conflicts < best) {
+      best      = m_Conflicts;
+      bestSlots = m_Slots;
+    }
+  }
+
+  if (m_Conflicts > best) {
+    for (int e = 0; e < m_NumExams; ++e) {
+      Remove(e);
+    }
+    for (int e = 0; e < m_NumExams; ++e) {
+      Place(e, bestSlots[e]);
+    }
+    m_Conflicts = best;
+  }
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ConflictGraph.hpp"
+#include "ExamConfig.hpp"
+#include "RequestArena.hpp"
+
+namespace TimetableWeaver
+{
+struct ExamColoringOptions {
+  int      maxIterations    = 200000; // Tabu search moves
+  double   timeLimitSeconds = 5.0;    // For the tabu search; 0 for none
+  uint32_t seed             = 1;
+};
+
+// Places exams into slots as a graph coloring of the conflict graph, with
+// slots as colours. Two exams clash when they share a group and start less
+// than the minimum spacing apart.
+//
+// DSatur builds the first assignment: the exam with the fewest clash-free
+// slots left goes next, into the free slot with the lowest spacing penalty
+// and then the fewest exams. Exams without a free slot take the one with the
+// fewest clashes, which a Tabucol search then removes by moving clashing
+// exams with a tabu list on (exam, slot) pairs. Both only use slots within
+// the groups' availability where a room and an invigilator are left, so a
+// clash-free result always has its resources.
+class ExamColoring
+{
+public:
+  ExamColoring(const ExamConfig &config, const ConflictGraph &graph);
+
+  // True when the result is clash free. False with a message when some exam
+  // has no slot at all.
+  bool Color(const ExamColoringOptions &options = ExamColoringOptions());
+
+  // Slot per exam, day * periodsPerDay + period.
+  const std::vector<int> &GetSlots() const { return m_Slots; }
+
+  // Exam pairs still clashing.
+  int GetConflicts() const { return m_Conflicts; }
+  int GetInitialConflicts() const { return m_InitialConflicts; }
+  int GetIterations() const { return m_Iterations; }
+
+  ExamSchedule GetSchedule() const;
+
+private:
+  bool Fits(int exam, int slot) const;
+  void Place(int exam, int slot);
+  void Remove(int exam);
+
+  // Adds `delta` to the clash counts of the exam's neighbours around `slot`.
+  void Spread(int exam, int slot, int delta);
+
+  bool Dsatur();
+  void Tabucol(const ExamColoringOptions &options);
+
+  int &Gamma(int exam, int slot) { return m_Gamma[exam * m_NumSlots + slot]; }
+  int  Gamma(int exam, int slot) const
+  {
+    return m_Gamma[exam * m_NumSlots + slot];
+  }
+
+  const ExamConfig    &m_Config;
+  const ConflictGraph &m_Graph;
+
+  int m_NumExams         = 0;
+  int m_NumSlots         = 0;
+  int m_Conflicts        = 0;
+  int m_InitialConflicts = 0;
+  int m_Iterations       = 0;
+
+  std::vector<int>     m_Slots;
+  ArenaVector<uint8_t> m_Allowed; // Per (exam, slot)
+  ArenaVector<int>     m_Gamma;   // Clashing neighbours per (exam, slot)
+
+  // Seats taken and rooms open per slot, both largest first, and the
+  // invigilators still free.
+  std::vector<std::vector<int>> m_SlotSizes;
+  std::vector<std::vector<int>> m_RoomCapacities;
+  std::vector<int>              m_FreeInvigilators;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,152 @@
+#include "ExamConfig.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace TimetableWeaver
+{
+/**
+ * ExamConfig
+ */
+uint32_t ExamConfig::GetAllowedPeriods(int exam, int day) const
+{
+  uint32_t allowed = periodsPerDay >= 32 ? ~0u : (1u << periodsPerDay) - 1;
+  for (int g : exams[exam].groups) {
+    allowed &= groups[g].GetAvailability().GetDay(day);
+  }
+  return allowed;
+}
+
+ConflictGraph ExamConfig::BuildConflictGraph() const
+{
+  std::vector<std::vector<int>> resources(exams.size());
+  for (size_t e = 0; e < exams.size(); ++e) {
+    resources[e] = exams[e].groups;
+  }
+  return ConflictGraph(resources, static_cast<int>(groups.size()));
+}
+
+bool AssignExamResources(const ExamConfig &config, ExamSchedule &schedule)
+{
+  const int periods = config.periodsPerDay;
+
+  std::vector<std::vector<int>> bySlot(config.GetSlotCount());
+  for (size_t e = 0; e < schedule.size(); ++e) {
+    const auto &placement = schedule[e];
+    bySlot[placement.day * periods + placement.period].push_back(e);
+  }
+
+  bool assigned = true;
+  for (int slot = 0; slot < config.GetSlotCount(); ++slot) {
+    auto &exams = bySlot[slot];
+    if (exams.empty()) {
+      continue;
+    }
+    const int day    = slot / periods;
+    const int period = slot % periods;
+
+    std::vector<int> rooms;
+    for (size_t r = 0; r < config.rooms.size(); ++r) {
+      if (config.rooms[r].GetAvailability().Get(day, period)) {
+        rooms.push_back(r);
+      }
+    }
+    std::vector<int> invigilators;
+    for (size_t i = 0; i < config.invigilators.size(); ++i) {
+      if (config.invigilators[i].GetAvailability().Get(day, period)) {
+        invigilators.push_back(i);
+      }
+    }
+
+    // Rooms nest by capacity, so pairing the k-th largest exam with the
+    // k-th largest room fails only when no assignment exists.
+    std::sort(exams.begin(), exams.end(), [&](int a, int b) {
+      return config.exams[a].students > config.exams[b].students;
+    });
+    std::sort(rooms.begin(), rooms.end(), [&](int a, int b) {
+      return config.rooms[a].GetCapacity() > config.rooms[b].GetCapacity();
+    });
+
+    for (size_t k = 0; k < exams.size(); ++k) {
+      auto &placement = schedule[exams[k]];
+      placement.room  = -1;
+      if (k < rooms.size() && config.rooms[rooms[k]].GetCapacity() >=
+                                  config.exams[exams[k]].students) {
+        placement.room = rooms[k];
+      }
+      placement.invigilator = k < invigilators.size() ? invigilators[k] : -1;
+      if (placement.room < 0 || placement.invigilator < 0) {
+        assigned = false;
+      }
+    }
+  }
+  return assigned;
+}
+
+int64_t GetSpacingPenalty(const ExamConfig   &config,
+                          const ExamSchedule &schedule)
+{
+  std::vector<std::vector<int>> slots(config.groups.size());
+  for (const auto &placement : schedule) {
+    for (int g : config.exams[placement.exam].groups) {
+      slots[g].push_back(placement.day * config.periodsPerDay +
+                         placement.period);
+    }
+  }
+
+  int64_t penalty = 0;
+  for (auto &group : slots) {
+    std::sort(group.begin(), group.end());
+    for (size_t a = 0; a < group.size(); ++a) {
+      for (size_t b = a + 1; b < group.size(); ++b) {
+        const int distance = group[b] - group[a];
+        if (distance >= config.preferredSpacing) {
+          break;
+        }
+        penalty += config.preferredSpacing - distance;
+      }
+    }
+  }
+  return penalty;
+}
+
+int CountExamViolations(const ExamConfig &config, const ConflictGraph &graph,
+                        const ExamSchedule &schedule)
+{
+  const int periods    = config.periodsPerDay;
+  int       violations = 0;
+  for (int e = 0; e < graph.GetSize(); ++e) {
+    const auto &placement = schedule[e];
+    const uint32_t allowed = config.GetAllowedPeriods(e, placement.day);
+    if ((allowed >> placement.period & 1) == 0) {
+      ++violations;
+    }
+    const int slot = placement.day * periods + placement.period;
+    for (int n : graph.GetNeighbours(e)) {
+      const int other = schedule[n].day * periods + schedule[n].period;
+      if (n > e && std::abs(slot - other) < config.minSpacing) {
+        ++violations;
+      }
+    }
+  }
+  return violations;
+}
+
+void PrintExamSchedule(std::ostream &stream, const ExamConfig &config,
+                       const ExamSchedule &schedule)
+{
+  for (const auto &placement : schedule) {
+    const auto &exam = config.exams[placement.exam];
+    stream << exam.name << ": day " << placement.day << ", period "
+           << placement.period;
+    if (placement.room >= 0) {
+      stream << ", " << config.rooms[placement.room].GetName();
+    }
+    if (placement.invigilator >= 0) {
+      stream << ", "
+             << config.invigilators[placement.invigilator].GetName();
+    }
+    stream << " (" << exam.students << " students)\n";
+  }
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ConflictGraph.hpp"
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+class Room
+{
+public:
+  explicit Room(const std::string &name, int capacity,
+                const Availability &availability)
+      : m_Name(name), m_Capacity(capacity), m_Availability(availability) {};
+
+  const std::string  &GetName() const { return m_Name; }
+  int                 GetCapacity() const { return m_Capacity; }
+  const Availability &GetAvailability() const { return m_Availability; }
+
+private:
+  std::string  m_Name;
+  int          m_Capacity = 0;
+  Availability m_Availability;
+};
+
+struct Exam {
+  std::string      name;
+  std::vector<int> groups;       // Student groups sitting it
+  int              students = 0; // Seats needed, all in one room
+};
+
+// Exam session on the timetable's entity model. Student groups are classes
+// and their availability limits when their exams may be held; invigilators
+// are teachers. Every exam takes one slot, one room large enough for it and
+// one invigilator, each of them used by one exam per slot.
+struct ExamConfig {
+  std::string name          = "Exams";
+  int         days          = 5;
+  int         periodsPerDay = 3;
+
+  std::vector<Class>   groups;
+  std::vector<Teacher> invigilators;
+  std::vector<Room>    rooms;
+  std::vector<Exam>    exams;
+
+  // Exams of one group start at least this many flat slots apart
+  // (day * periodsPerDay + period); 1 only keeps them out of the same slot.
+  // Day boundaries are not special: the last period of one day and the
+  // first of the next are one slot apart. A spacing of periodsPerDay thus
+  // keeps a group's exams a full day's worth of slots apart, which also
+  // forbids e.g. an afternoon exam followed by a morning one; it is not a
+  // one-exam-per-day rule.
+  int minSpacing = 1;
+
+  // Pairs of exams of one group closer than this are penalised by how much
+  // closer they are; 0 disables the objective.
+  int preferredSpacing = 0;
+
+  int GetSlotCount() const { return days * periodsPerDay; }
+
+  // Periods of `day` every group of the exam is available.
+  uint32_t GetAllowedPeriods(int exam, int day) const;
+
+  // Exams sharing a student group.
+  ConflictGraph BuildConflictGraph() const;
+};
+
+struct ExamPlacement {
+  int exam        = -1;
+  int day         = -1;
+  int period      = -1;
+  int room        = -1;
+  int invigilator = -1;
+};
+
+// One placement per exam, in exam order.
+using ExamSchedule = std::vector<ExamPlacement>;
+
+// Gives every exam a room and an invigilator within its slot, largest exams
+// first into the largest free rooms. Returns false when some slot holds
+// more exams than its rooms or invigilators can take.
+bool AssignExamResources(const ExamConfig &config, ExamSchedule &schedule);
+
+// Sum over groups and their pairs of exams closer than the preferred
+// spacing of how much closer they are.
+int64_t GetSpacingPenalty(const ExamConfig   &config,
+                          const ExamSchedule &schedule);
+
+// Pairs of exams of one group closer than the minimum spacing, plus exams
+// outside their groups' availability.
+int CountExamViolations(const ExamConfig &config, const ConflictGraph &graph,
+                        const ExamSchedule &schedule);
+
+void PrintExamSchedule(std::ostream &stream, const ExamConfig &config,
+                       const ExamSchedule &schedule);
+}; // namespace TimetableWeaver
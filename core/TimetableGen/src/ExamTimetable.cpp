@@ -0,0 +1,82 @@
+#include "ExamTimetable.hpp"
+
+#include <algorithm>
+
+#include "RequestArena.hpp"
+
+namespace TimetableWeaver
+{
+/**
+ * ExamTimetable
+ */
+bool ExamTimetable::Generate(const ExamOptions &options)
+{
+  TraceSpan span(m_Trace, "generate-exams", "phase");
+
+  // The coloring's indexes live for this call only.
+  RequestArena arena;
+  RequestScope scope(arena);
+
+  const ConflictGraph graph = m_Config.BuildConflictGraph();
+  ExamColoring        coloring(m_Config, graph);
+
+  TraceSpan  color(m_Trace, "coloring", "phase");
+  const bool colored = coloring.Color(options.coloring);
+  color.AddArg("initial-conflicts",
+               std::to_string(coloring.GetInitialConflicts()));
+  color.AddArg("conflicts", std::to_string(coloring.GetConflicts()));
+  color.AddArg("iterations", std::to_string(coloring.GetIterations()));
+  color.End();
+
+  if (!colored) {
+    std::cout << "No clash-free exam schedule found.\n";
+    return false;
+  }
+
+  ExamSchedule schedule = coloring.GetSchedule();
+  m_InitialPenalty      = GetSpacingPenalty(m_Config, schedule);
+  m_Penalty             = m_InitialPenalty;
+
+  const bool refine = options.refineSeconds > 0.0 && m_InitialPenalty > 0 &&
+                      m_Config.preferredSpacing >
+                          std::max(1, m_Config.minSpacing);
+  if (refine) {
+    if (!m_Backend) {
+      TraceSpan load(m_Trace, "load-backend", "phase");
+      m_Backend = LoadSolverBackend();
+    }
+    if (m_Backend) {
+      m_Backend->SetTraceRecorder(m_Trace);
+
+      SolveOptions solve;
+      solve.timeLimitSeconds = options.refineSeconds;
+
+      ExamSchedule refined = schedule;
+      if (m_Backend->RefineExams(m_Config, refined, solve) &&
+          CountExamViolations(m_Config, graph, refined) == 0) {
+        const int64_t penalty = GetSpacingPenalty(m_Config, refined);
+        if (penalty < m_Penalty) {
+          schedule  = std::move(refined);
+          m_Penalty = penalty;
+        }
+      }
+    } else {
+      std::cerr << "No solver backend available, keeping the coloring\n";
+    }
+  }
+
+  if (!AssignExamResources(m_Config, schedule)) {
+    std::cerr << "Some slot has more exams than rooms or invigilators\n";
+    return false;
+  }
+  m_Schedule = std::move(schedule);
+  return true;
+}
+
+void ExamTimetable::PrintSchedule(std::ostream &stream) const
+{
+  PrintExamSchedule(stream, m_Config, m_Schedule);
+  stream << "Spacing penalty: " << m_Penalty << " (coloring "
+         << m_InitialPenalty << ")\n";
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+#include "ExamColoring.hpp"
+#include "ExamConfig.hpp"
+#include "SolverBackend.hpp"
+
+namespace TimetableWeaver
+{
+struct ExamOptions {
+  ExamColoringOptions coloring;
+
+  // CP-SAT refinement of the spacing penalty; 0 keeps the coloring.
+  double refineSeconds = 10.0;
+};
+
+// Exam timetabling mode. The coloring engine finds a clash-free schedule on
+// its own in well under a second for thousands of exams; when the config
+// asks for a preferred spacing, the solver backend then improves it from
+// that hint within the refinement budget. Rooms and invigilators are
+// assigned last, slot by slot.
+class ExamTimetable
+{
+public:
+  explicit ExamTimetable(const ExamConfig &config) : m_Config(config) {};
+
+  // Refines with the given backend; the OR-tools module is loaded on first
+  // use when none was set.
+  void SetBackend(std::shared_ptr<SolverBackend> backend)
+  {
+    m_Backend = std::move(backend);
+  }
+
+  void SetTraceRecorder(TraceRecorder *recorder) { m_Trace = recorder; }
+
+  bool Generate(const ExamOptions &options = ExamOptions());
+
+  const ExamConfig   &GetConfig() const { return m_Config; }
+  const ExamSchedule &GetSchedule() const { return m_Schedule; }
+
+  // Spacing penalty of the coloring and of the final schedule.
+  int64_t GetInitialPenalty() const { return m_InitialPenalty; }
+  int64_t GetPenalty() const { return m_Penalty; }
+
+  void PrintSchedule(std::ostream &stream) const;
+
+private:
+  ExamConfig                     m_Config;
+  ExamSchedule                   m_Schedule;
+  std::shared_ptr<SolverBackend> m_Backend;
+  TraceRecorder                 *m_Trace          = nullptr;
+  int64_t                        m_InitialPenalty = 0;
+  int64_t                        m_Penalty        = 0;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,275 @@
+#include "InstanceGenerator.hpp"
+
+#include <algorithm>
+
+#include "Bits.hpp"
+#include "ModelEstimate.hpp"
+
+namespace TimetableWeaver
+{
+static int RandomInt(std::mt19937 &random, int low, int high)
+{
+  return std::uniform_int_distribution<int>(low, high)(random);
+}
+
+// Lessons hold their own copies of class, teacher and subject; after an
+// entity changed, point every lesson at a fresh copy of it.
+static void RelinkLesson(TimetableConfig &config, size_t index, int classId,
+                         int teacherId, int subjectId, int periodsPerWeek,
+                         const Subgroup &subgroup = Subgroup())
+{
+  config.lessons[index] = std::make_shared<Lesson>(
+      std::make_shared<Class>(config.classes[classId]),
+      std::make_shared<Teacher>(config.teachers[teacherId]),
+      std::make_shared<Subject>(config.subjects[subjectId]), periodsPerWeek,
+      subgroup);
+}
+
+static void RelinkLessons(TimetableConfig &config)
+{
+  const LessonIds ids = config.GetLessonIds();
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    const auto &lesson = config.lessons[i];
+    RelinkLesson(config, i, ids.classes[i], ids.teachers[i], ids.subjects[i],
+                 lesson->GetPeriodsPerWeek(), lesson->GetSubgroup());
+  }
+}
+
+TimetableConfig GenerateInstance(const GeneratorParams &params)
+{
+  std::mt19937 random(params.seed);
+
+  TimetableConfig config;
+  config.name          = "Generated " + std::to_string(params.seed);
+  config.days          = params.days;
+  config.periodsPerDay = params.periodsPerDay;
+
+  Availability full(params.days, params.periodsPerDay);
+  for (int d = 0; d < params.days; ++d) {
+    full.SetDay(d, true);
+  }
+
+  for (int s = 0; s < params.subjects; ++s) {
+    config.subjects.emplace_back("Subject " + std::to_string(s), full);
+  }
+  for (int c = 0; c < params.classes; ++c) {
+    config.classes.emplace_back("Class " + std::to_string(c), full);
+  }
+
+  std::bernoulli_distribution available(params.teacherAvailability);
+  for (int t = 0; t < params.teachers; ++t) {
+    Availability availability(params.days, params.periodsPerDay);
+    for (int d = 0; d < params.days; ++d) {
+      for (int p = 0; p < params.periodsPerDay; ++p) {
+        availability.Set(d, p, available(random));
+      }
+    }
+    config.teachers.emplace_back("Teacher " + std::to_string(t),
+                                 availability);
+  }
+
+  const int        week = params.days * params.periodsPerDay;
+  std::vector<int> teacherLoad(params.teachers, 0);
+  for (int c = 0; c < params.classes && params.teachers > 0; ++c) {
+    int remaining = static_cast<int>(params.classFill * week);
+    while (remaining > 0) {
+      const int periods = std::min(
+          remaining, RandomInt(random, std::max(params.minPeriodsPerLesson, 1),
+                               std::max(params.maxPeriodsPerLesson, 1)));
+      remaining -= periods;
+
+      int teacher = RandomInt(random, 0, params.teachers - 1);
+      for (int k = 0; k < 2; ++k) {
+        const int other = RandomInt(random, 0, params.teachers - 1);
+        if (teacherLoad[other] < teacherLoad[teacher]) {
+          teacher = other;
+        }
+      }
+      teacherLoad[teacher] += periods;
+
+      const int subject = RandomInt(random, 0, params.subjects - 1);
+      config.lessons.emplace_back();
+      RelinkLesson(config, config.lessons.size() - 1, c, teacher, subject,
+                   periods);
+    }
+  }
+
+  if (params.maxConsecutive > 0) {
+    config.rules.push_back(
+        DailyRule::MaxConsecutive(RuleTarget::Teachers, params.maxConsecutive));
+  }
+  if (params.maxPerDay > 0) {
+    config.rules.push_back(
+        DailyRule::MaxPerDay(RuleTarget::Teachers, params.maxPerDay));
+  }
+  if (params.noGaps) {
+    config.rules.push_back(DailyRule::NoGaps(RuleTarget::Classes));
+    config.rules.back().hard = false;
+  }
+
+  // Drawn last and only when asked for, so spread-free parameters keep
+  // generating the configs they always did.
+  if (params.spreadShare > 0.0) {
+    std::bernoulli_distribution spread(params.spreadShare);
+    for (size_t i = 0; i < config.lessons.size(); ++i) {
+      if (!spread(random)) {
+        continue;
+      }
+      const int periods = config.lessons[i]->GetPeriodsPerWeek();
+      const int count   = std::min(periods, params.days);
+      if (count <= 0 || (periods + count - 1) / count > params.periodsPerDay) {
+        continue;
+      }
+
+      SpreadRule rule;
+      rule.lesson = static_cast<int>(i);
+      for (int b = 0; b < count; ++b) {
+        rule.blocks.push_back(periods / count + (b < periods % count));
+      }
+      rule.minDayGap = 2 * count - 1 <= params.days ? 2 : 1;
+      config.spreads.push_back(std::move(rule));
+    }
+  }
+  return config;
+}
+
+void MutateInstance(TimetableConfig &config, std::mt19937 &random, int count)
+{
+  if (config.lessons.empty() || config.teachers.empty()) {
+    return;
+  }
+
+  for (int m = 0; m < count; ++m) {
+    switch (RandomInt(random, 0, 3)) {
+    case 0: { // Toggle a teacher slot
+      Teacher     &teacher      = config.teachers[RandomInt(
+          random, 0, static_cast<int>(config.teachers.size()) - 1)];
+      Availability availability = teacher.GetAvailability();
+      availability.Toggle(RandomInt(random, 0, config.days - 1),
+                          RandomInt(random, 0, config.periodsPerDay - 1));
+      teacher = Teacher(teacher.GetName(), availability);
+      break;
+    }
+    case 1: { // Toggle a class slot
+      if (config.classes.empty()) {
+        break;
+      }
+      Class &cls = config.classes[RandomInt(
+          random, 0, static_cast<int>(config.classes.size()) - 1)];
+      Availability availability = cls.GetAvailability();
+      availability.Toggle(RandomInt(random, 0, config.days - 1),
+                          RandomInt(random, 0, config.periodsPerDay - 1));
+      Class changed(cls.GetName(), availability);
+      for (const auto &partition : cls.GetPartitions()) {
+        changed.AddPartition(partition.name, partition.groups);
+      }
+      cls = changed;
+      break;
+    }
+    case 2: { // Lengthen or shorten a lesson
+      const int index =
+          RandomInt(random, 0, static_cast<int>(config.lessons.size()) - 1);
+      auto     &lesson  = config.lessons[index];
+      const int periods = std::max(
+          1, lesson->GetPeriodsPerWeek() + (RandomInt(random, 0, 1) ? 1 : -1));
+      lesson = std::make_shared<Lesson>(
+          lesson->GetClass(), lesson->GetTeacher(), lesson->GetSubject(),
+          periods, lesson->GetSubgroup());
+
+      // The blocks no longer add up to the lesson.
+      config.spreads.erase(
+          std::remove_if(config.spreads.begin(), config.spreads.end(),
+                         [&](const SpreadRule &spread) {
+                           return spread.lesson == index;
+                         }),
+          config.spreads.end());
+      break;
+    }
+    case 3: { // Move a lesson to another teacher
+      auto &lesson = config.lessons[RandomInt(
+          random, 0, static_cast<int>(config.lessons.size()) - 1)];
+      const Teacher &teacher = config.teachers[RandomInt(
+          random, 0, static_cast<int>(config.teachers.size()) - 1)];
+      lesson = std::make_shared<Lesson>(
+          lesson->GetClass(), std::make_shared<Teacher>(teacher),
+          lesson->GetSubject(), lesson->GetPeriodsPerWeek(),
+          lesson->GetSubgroup());
+      break;
+    }
+    }
+  }
+  RelinkLessons(config);
+}
+
+InstanceFeatures ComputeFeatures(const TimetableConfig &config)
+{
+  const int numSlots    = config.days * config.periodsPerDay;
+  const int numClasses  = static_cast<int>(config.classes.size());
+  const int numTeachers = static_cast<int>(config.teachers.size());
+
+  std::vector<int> classDemand(numClasses, 0), teacherDemand(numTeachers, 0);
+  int64_t          weeklyPeriods = 0;
+  int64_t          allowedSlots  = 0;
+  int              minSlack      = numSlots;
+
+  const LessonIds ids = config.GetLessonIds();
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    const auto &lesson    = config.lessons[i];
+    const int   classId   = ids.classes[i];
+    const int   teacherId = ids.teachers[i];
+    if (classId < 0 || teacherId < 0) {
+      continue;
+    }
+
+    int allowed = 0;
+    for (int d = 0; d < config.days; ++d) {
+      allowed += PopCount(lesson->GetClass()->GetAvailability().GetDay(d) &
+                          lesson->GetTeacher()->GetAvailability().GetDay(d));
+    }
+    allowedSlots += allowed;
+    minSlack = std::min(minSlack, allowed - lesson->GetPeriodsPerWeek());
+
+    weeklyPeriods += lesson->GetPeriodsPerWeek();
+    classDemand[classId] += lesson->GetPeriodsPerWeek();
+    teacherDemand[teacherId] += lesson->GetPeriodsPerWeek();
+  }
+
+  // Demand over supply of the tightest class and teacher.
+  auto tightest = [&](const auto &entities, const std::vector<int> &demand) {
+    double worst = 0.0;
+    for (size_t i = 0; i < entities.size(); ++i) {
+      int supply = 0;
+      for (int d = 0; d < config.days; ++d) {
+        supply += PopCount(entities[i].GetAvailability().GetDay(d));
+      }
+      if (supply > 0) {
+        worst = std::max(worst, static_cast<double>(demand[i]) / supply);
+      } else if (demand[i] > 0) {
+        worst = std::max(worst, static_cast<double>(demand[i]));
+      }
+    }
+    return worst;
+  };
+
+  const double numLessons = static_cast<double>(config.lessons.size());
+  const auto   estimates  = EstimateModels(config);
+
+  return {
+      {"days", config.days},
+      {"periodsPerDay", config.periodsPerDay},
+      {"classes", numClasses},
+      {"teachers", numTeachers},
+      {"lessons", numLessons},
+      {"weeklyPeriods", static_cast<double>(weeklyPeriods)},
+      {"meanAllowedSlots", numLessons > 0 ? allowedSlots / numLessons : 0.0},
+      {"minLessonSlack", minSlack},
+      {"classTightness", tightest(config.classes, classDemand)},
+      {"teacherTightness", tightest(config.teachers, teacherDemand)},
+      {"rules", static_cast<double>(config.rules.size())},
+      {"spreads", static_cast<double>(config.spreads.size())},
+      {"slotBooleanVariables", static_cast<double>(estimates[0].variables)},
+      {"slotBooleanConstraints",
+       static_cast<double>(estimates[0].constraints)},
+  };
+}
+}; // namespace TimetableWeaver
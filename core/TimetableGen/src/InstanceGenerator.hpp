@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+// Shape of a synthetic school.
+struct GeneratorParams {
+  int days          = 5;
+  int periodsPerDay = 8;
+  int classes       = 10;
+  int teachers      = 15;
+  int subjects      = 8;
+
+  int minPeriodsPerLesson = 1;
+  int maxPeriodsPerLesson = 5;
+
+  double classFill           = 0.8;  // Share of a class's week taught
+  double teacherAvailability = 0.85; // Share of slots a teacher can teach
+
+  int  maxConsecutive = 0; // 0 leaves the rule out
+  int  maxPerDay      = 0;
+  bool noGaps         = false;
+
+  double spreadShare = 0.0; // Share of lessons given a weekly spread
+
+  uint32_t seed = 1;
+};
+
+// Builds a config from the parameters; equal parameters give equal
+// configs. Classes are always available, teachers lose random slots, and
+// every class is filled with lessons of random length taught by the least
+// loaded of a few random teachers. Spread lessons split their periods into
+// near-equal blocks on as many days as possible.
+TimetableConfig GenerateInstance(const GeneratorParams &params);
+
+// Applies `count` small edits: toggling a teacher or class slot, changing
+// a lesson's weekly periods, or moving a lesson to another teacher. Works
+// on any config, generated or not; a lesson whose length changes loses its
+// spread.
+void MutateInstance(TimetableConfig &config, std::mt19937 &random, int count);
+
+// Named numeric description of an instance for cataloguing hard cases.
+using InstanceFeatures = std::vector<std::pair<std::string, double>>;
+
+InstanceFeatures ComputeFeatures(const TimetableConfig &config);
+}; // namespace TimetableWeaver
@@ -0,0 +1,136 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TimetableWeaver
+{
+
+/**
+ * MappedFile
+ */
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const std::string &path) { return Map(path, 0, false); }
+
+bool MappedFile::Create(const std::string &path, size_t size)
+{
+  return size > 0 && Map(path, size, true);
+}
+
+#ifdef _WIN32
+bool MappedFile::Map(const std::string &path, size_t size, bool writable)
+{
+  Close();
+
+  DWORD  access = writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+  DWORD  share  = FILE_SHARE_READ | FILE_SHARE_WRITE;
+  HANDLE file   = CreateFileA(path.c_str(), access, share, nullptr,
+                              writable ? CREATE_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (writable) {
+    fileSize.QuadPart = static_cast<LONGLONG>(size);
+  } else if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(
+      file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+      static_cast<DWORD>(fileSize.QuadPart >> 32),
+      static_cast<DWORD>(fileSize.QuadPart & 0xffffffff), nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void *data = MapViewOfFile(
+      mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  m_File     = file;
+  m_Mapping  = mapping;
+  m_Data     = static_cast<const uint8_t *>(data);
+  m_Size     = static_cast<size_t>(fileSize.QuadPart);
+  m_Writable = writable;
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (m_Data != nullptr) {
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_File);
+  }
+  m_Data     = nullptr;
+  m_Size     = 0;
+  m_Writable = false;
+  m_File     = nullptr;
+  m_Mapping  = nullptr;
+}
+#else
+bool MappedFile::Map(const std::string &path, size_t size, bool writable)
+{
+  Close();
+
+  int fd = writable ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+                    : open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  if (writable) {
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      close(fd);
+      return false;
+    }
+  } else {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+  }
+
+  int   prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *data = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  m_Data     = static_cast<const uint8_t *>(data);
+  m_Size     = size;
+  m_Writable = writable;
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (m_Data != nullptr) {
+    munmap(const_cast<uint8_t *>(m_Data), m_Size);
+  }
+  m_Data     = nullptr;
+  m_Size     = 0;
+  m_Writable = false;
+}
+#endif
+}; // namespace TimetableWeaver
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace TimetableWeaver
+{
+// Memory mapping of a whole file. Pages are only faulted in when they are
+// touched, so readers can jump straight to the bytes they need. Files opened
+// with Create are mapped shared and writable so other processes see writes.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &)            = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool Open(const std::string &path);
+  bool Create(const std::string &path, size_t size);
+  void Close();
+
+  bool IsOpen() const { return m_Data != nullptr; }
+  bool IsWritable() const { return m_Writable; }
+
+  const uint8_t *GetData() const { return m_Data; }
+  uint8_t       *GetMutableData() const
+  {
+    return m_Writable ? const_cast<uint8_t *>(m_Data) : nullptr;
+  }
+  size_t GetSize() const { return m_Size; }
+
+private:
+  bool Map(const std::string &path, size_t size, bool writable);
+
+  const uint8_t *m_Data     = nullptr;
+  size_t         m_Size     = 0;
+  bool           m_Writable = false;
+
+#ifdef _WIN32
+  void *m_File    = nullptr;
+  void *m_Mapping = nullptr;
+#endif
+};
+}; // namespace TimetableWeaver
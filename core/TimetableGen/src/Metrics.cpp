@@ -0,0 +1,236 @@
+#include "Metrics.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace TimetableWeaver
+{
+// Shortest of %.15g and %.17g that reads back as the same double, so
+// bucket labels stay "0.05" rather than "0.050000000000000003".
+static void WriteNumber(std::ostream &stream, double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+  if (std::strtod(buffer, nullptr) != value) {
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+  }
+  stream << buffer;
+}
+
+/**
+ * Histogram
+ */
+Histogram::Histogram(std::vector<double> bounds)
+    : m_Bounds(std::move(bounds)),
+      m_Buckets(new std::atomic<uint64_t>[m_Bounds.size() + 1])
+{
+  for (size_t i = 0; i <= m_Bounds.size(); ++i) {
+    m_Buckets[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void Histogram::Observe(double value)
+{
+  size_t bucket = 0;
+  while (bucket < m_Bounds.size() && value > m_Bounds[bucket]) {
+    ++bucket;
+  }
+  m_Buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+  double sum = m_Sum.load(std::memory_order_relaxed);
+  while (!m_Sum.compare_exchange_weak(sum, sum + value,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t Histogram::GetBucket(size_t index) const
+{
+  return m_Buckets[index].load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetCount() const
+{
+  uint64_t count = 0;
+  for (size_t i = 0; i <= m_Bounds.size(); ++i) {
+    count += GetBucket(i);
+  }
+  return count;
+}
+
+/**
+ * MetricsRegistry
+ */
+Counter &MetricsRegistry::AddCounter(const std::string &name,
+                                     const std::string &help)
+{
+  auto entry     = std::make_unique<Entry>();
+  entry->type    = MetricType::Counter;
+  entry->name    = name;
+  entry->help    = help;
+  entry->counter = std::make_unique<Counter>();
+
+  Counter &counter = *entry->counter;
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.push_back(std::move(entry));
+  return counter;
+}
+
+Gauge &MetricsRegistry::AddGauge(const std::string &name,
+                                 const std::string &help)
+{
+  auto entry   = std::make_unique<Entry>();
+  entry->type  = MetricType::Gauge;
+  entry->name  = name;
+  entry->help  = help;
+  entry->gauge = std::make_unique<Gauge>();
+
+  Gauge &gauge = *entry->gauge;
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.push_back(std::move(entry));
+  return gauge;
+}
+
+Histogram &MetricsRegistry::AddHistogram(const std::string &name,
+                                         const std::string &help,
+                                         std::vector<double> bounds)
+{
+  auto entry       = std::make_unique<Entry>();
+  entry->type      = MetricType::Histogram;
+  entry->name      = name;
+  entry->help      = help;
+  entry->histogram = std::make_unique<Histogram>(std::move(bounds));
+
+  Histogram &histogram = *entry->histogram;
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.push_back(std::move(entry));
+  return histogram;
+}
+
+void MetricsRegistry::AddCallbackGauge(const std::string      &name,
+                                       const std::string      &help,
+                                       std::function<double()> sample)
+{
+  auto entry    = std::make_unique<Entry>();
+  entry->type   = MetricType::Callback;
+  entry->name   = name;
+  entry->help   = help;
+  entry->sample = std::move(sample);
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.push_back(std::move(entry));
+}
+
+void MetricsRegistry::WriteText(std::ostream &stream) const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  for (const auto &entry : m_Entries) {
+    stream << "# HELP " << entry->name << " " << entry->help << "\n";
+
+    switch (entry->type) {
+    case MetricType::Counter:
+      stream << "# TYPE " << entry->name << " counter\n"
+             << entry->name << " " << entry->counter->Get() << "\n";
+      break;
+    case MetricType::Gauge:
+      stream << "# TYPE " << entry->name << " gauge\n"
+             << entry->name << " " << entry->gauge->Get() << "\n";
+      break;
+    case MetricType::Callback:
+      stream << "# TYPE " << entry->name << " gauge\n" << entry->name << " ";
+      WriteNumber(stream, entry->sample());
+      stream << "\n";
+      break;
+    case MetricType::Histogram: {
+      const Histogram &histogram = *entry->histogram;
+      const auto      &bounds    = histogram.GetBounds();
+
+      stream << "# TYPE " << entry->name << " histogram\n";
+      uint64_t cumulative = 0;
+      for (size_t i = 0; i <= bounds.size(); ++i) {
+        cumulative += histogram.GetBucket(i);
+        stream << entry->name << "_bucket{le=\"";
+        if (i < bounds.size()) {
+          WriteNumber(stream, bounds[i]);
+        } else {
+          stream << "+Inf";
+        }
+        stream << "\"} " << cumulative << "\n";
+      }
+      stream << entry->name << "_sum ";
+      WriteNumber(stream, histogram.GetSum());
+      stream << "\n" << entry->name << "_count " << cumulative << "\n";
+      break;
+    }
+    }
+  }
+}
+
+std::string MetricsRegistry::GetText() const
+{
+  std::ostringstream stream;
+  WriteText(stream);
+  return stream.str();
+}
+
+uint64_t GetResidentMemoryBytes()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                               sizeof(counters))) {
+    return 0;
+  }
+  return counters.WorkingSetSize;
+#else
+  // Second field of statm is the resident page count.
+  FILE *file = std::fopen("/proc/self/statm", "r");
+  if (file == nullptr) {
+    return 0;
+  }
+  unsigned long long size = 0, resident = 0;
+  const int fields = std::fscanf(file, "%llu %llu", &size, &resident);
+  std::fclose(file);
+  if (fields != 2) {
+    return 0;
+  }
+  return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/**
+ * SolverMetrics
+ */
+SolverMetrics::SolverMetrics(MetricsRegistry &registry)
+    : queueDepth(registry.AddGauge("timetable_queue_depth",
+                                   "Solve requests waiting for a worker")),
+      activeSolves(registry.AddGauge("timetable_active_solves",
+                                     "Solves currently running")),
+      solves(registry.AddCounter("timetable_solves_total",
+                                 "Solves started")),
+      failures(registry.AddCounter("timetable_solve_failures_total",
+                                   "Solves that ended without a schedule")),
+      cancellations(registry.AddCounter("timetable_cancellations_total",
+                                        "Solves cancelled before finishing")),
+      timeToFirstSolution(registry.AddHistogram(
+          "timetable_time_to_first_solution_seconds",
+          "Time from solve start to the first feasible schedule",
+          {0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 300})),
+      solveSeconds(registry.AddHistogram(
+          "timetable_solve_seconds", "Wall time of complete solves",
+          {0.1, 0.5, 1, 2.5, 5, 10, 30, 60, 120, 300, 600, 1800}))
+{
+  registry.AddCallbackGauge("timetable_resident_memory_bytes",
+                            "Resident set size of the solver process", []() {
+                              return static_cast<double>(
+                                  GetResidentMemoryBytes());
+                            });
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace TimetableWeaver
+{
+// Monotonic count. Updates are single relaxed atomic adds.
+class Counter
+{
+public:
+  void     Increment(uint64_t n = 1) { m_Value.fetch_add(n, kRelaxed); }
+  uint64_t Get() const { return m_Value.load(kRelaxed); }
+
+private:
+  static constexpr std::memory_order kRelaxed = std::memory_order_relaxed;
+
+  std::atomic<uint64_t> m_Value{0};
+};
+
+class Gauge
+{
+public:
+  void    Set(int64_t value) { m_Value.store(value, kRelaxed); }
+  void    Add(int64_t delta) { m_Value.fetch_add(delta, kRelaxed); }
+  int64_t Get() const { return m_Value.load(kRelaxed); }
+
+private:
+  static constexpr std::memory_order kRelaxed = std::memory_order_relaxed;
+
+  std::atomic<int64_t> m_Value{0};
+};
+
+// Histogram over fixed upper bounds chosen at registration. Observing is a
+// short scan of the bounds and two relaxed atomic updates; bucket counts
+// are stored non-cumulatively and summed when exported.
+class Histogram
+{
+public:
+  explicit Histogram(std::vector<double> bounds);
+
+  void Observe(double value);
+
+  const std::vector<double> &GetBounds() const { return m_Bounds; }
+  uint64_t GetBucket(size_t index) const; // bounds.size() is the +Inf bucket
+  uint64_t GetCount() const;
+  double   GetSum() const { return m_Sum.load(std::memory_order_relaxed); }
+
+private:
+  std::vector<double>                    m_Bounds;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_Buckets;
+  std::atomic<double>                    m_Sum{0.0};
+};
+
+// Owns named metrics and renders them in the Prometheus text exposition
+// format. Registration locks; updating a registered metric never does.
+class MetricsRegistry
+{
+public:
+  Counter   &AddCounter(const std::string &name, const std::string &help);
+  Gauge     &AddGauge(const std::string &name, const std::string &help);
+  Histogram &AddHistogram(const std::string &name, const std::string &help,
+                          std::vector<double> bounds);
+
+  // Gauge sampled when the metrics are exported, e.g. process memory.
+  void AddCallbackGauge(const std::string &name, const std::string &help,
+                        std::function<double()> sample);
+
+  void        WriteText(std::ostream &stream) const;
+  std::string GetText() const;
+
+private:
+  enum class MetricType { Counter, Gauge, Histogram, Callback };
+
+  struct Entry {
+    MetricType                 type;
+    std::string                name;
+    std::string                help;
+    std::unique_ptr<Counter>   counter;
+    std::unique_ptr<Gauge>     gauge;
+    std::unique_ptr<Histogram> histogram;
+    std::function<double()>    sample;
+  };
+
+  mutable std::mutex                  m_Mutex;
+  std::vector<std::unique_ptr<Entry>> m_Entries;
+};
+
+// Resident set size of this process in bytes, or 0 when unavailable.
+uint64_t GetResidentMemoryBytes();
+
+// The solver's operational metrics, registered under timetable_*.
+struct SolverMetrics {
+  explicit SolverMetrics(MetricsRegistry &registry);
+
+  Gauge     &queueDepth;
+  Gauge     &activeSolves;
+  Counter   &solves;
+  Counter   &failures;
+  Counter   &cancellations;
+  Histogram &timeToFirstSolution;
+  Histogram &solveSeconds;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,221 @@
+#include "MetricsExporter.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketHandle = SOCKET;
+using SocketLength = int;
+#define CloseSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using SocketHandle = int;
+using SocketLength = socklen_t;
+#define CloseSocket close
+#endif
+
+namespace TimetableWeaver
+{
+// How often the accept loop checks the stop flag.
+static const int kPollIntervalMs = 200;
+
+/**
+ * MetricsServer
+ */
+MetricsServer::MetricsServer(const MetricsRegistry &registry)
+    : m_Registry(registry)
+{
+}
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+bool MetricsServer::Start(int port)
+{
+  if (m_Running) {
+    return true;
+  }
+
+#ifdef _WIN32
+  WSADATA data;
+  if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+    return false;
+  }
+#endif
+
+  SocketHandle listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (static_cast<intptr_t>(listener) < 0) {
+    std::cerr << "Could not create the metrics socket\n";
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return false;
+  }
+
+  int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR,
+             reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+  sockaddr_in address{};
+  address.sin_family      = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port        = htons(static_cast<uint16_t>(port));
+
+  SocketLength length = sizeof(address);
+  if (bind(listener, reinterpret_cast<sockaddr *>(&address), length) != 0 ||
+      listen(listener, 8) != 0 ||
+      getsockname(listener, reinterpret_cast<sockaddr *>(&address),
+                  &length) != 0) {
+    std::cerr << "Could not listen for metrics on port " << port << "\n";
+    CloseSocket(listener);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return false;
+  }
+
+  m_Socket  = static_cast<intptr_t>(listener);
+  m_Port    = ntohs(address.sin_port);
+  m_Running = true;
+  m_Thread  = std::thread(&MetricsServer::Serve, this);
+  return true;
+}
+
+void MetricsServer::Stop()
+{
+  if (!m_Running.exchange(false)) {
+    return;
+  }
+  m_Thread.join();
+  CloseSocket(static_cast<SocketHandle>(m_Socket));
+  m_Socket = -1;
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+void MetricsServer::Serve()
+{
+  const auto listener = static_cast<SocketHandle>(m_Socket);
+
+  while (m_Running) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(listener, &readable);
+    timeval timeout{0, kPollIntervalMs * 1000};
+    if (select(static_cast<int>(listener + 1), &readable, nullptr, nullptr,
+               &timeout) <= 0) {
+      continue;
+    }
+
+    SocketHandle client = accept(listener, nullptr, nullptr);
+    if (static_cast<intptr_t>(client) < 0) {
+      continue;
+    }
+
+    // The request itself is irrelevant; drain what has arrived so the
+    // client does not see a reset, then answer with the page. A client
+    // that connects and never writes must not stall the loop, so wait
+    // at most one poll interval for its request.
+    fd_set pending;
+    FD_ZERO(&pending);
+    FD_SET(client, &pending);
+    timeval wait{0, kPollIntervalMs * 1000};
+    if (select(static_cast<int>(client + 1), &pending, nullptr, nullptr,
+               &wait) > 0) {
+      char request[1024];
+      recv(client, request, sizeof(request), 0);
+    }
+
+    const std::string body   = m_Registry.GetText();
+    const std::string header = "HTTP/1.0 200 OK\r\n"
+                               "Content-Type: text/plain; version=0.0.4\r\n"
+                               "Content-Length: " +
+                               std::to_string(body.size()) +
+                               "\r\nConnection: close\r\n\r\n";
+    const std::string response = header + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+      const auto n = send(client, response.data() + sent,
+                          static_cast<int>(response.size() - sent), 0);
+      if (n <= 0) {
+        break;
+      }
+      sent += static_cast<size_t>(n);
+    }
+    CloseSocket(client);
+  }
+}
+
+/**
+ * StatsFileWriter
+ */
+StatsFileWriter::StatsFileWriter(const MetricsRegistry &registry)
+    : m_Registry(registry)
+{
+}
+
+StatsFileWriter::~StatsFileWriter() { Stop(); }
+
+void StatsFileWriter::Start(const std::string &path, int intervalMs)
+{
+  if (m_Running.exchange(true)) {
+    return;
+  }
+
+  // A non-positive interval would rewrite the file in a hot loop.
+  if (intervalMs <= 0) {
+    intervalMs = kPollIntervalMs;
+  }
+
+  m_Thread = std::thread([this, path, intervalMs]() {
+    const int sleepMs =
+        intervalMs < kPollIntervalMs ? intervalMs : kPollIntervalMs;
+    auto next = std::chrono::steady_clock::now();
+    while (m_Running) {
+      if (std::chrono::steady_clock::now() >= next) {
+        Write(path);
+        next += std::chrono::milliseconds(intervalMs);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+    }
+    Write(path);
+  });
+}
+
+void StatsFileWriter::Stop()
+{
+  if (m_Running.exchange(false)) {
+    m_Thread.join();
+  }
+}
+
+bool StatsFileWriter::Write(const std::string &path) const
+{
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+      return false;
+    }
+    m_Registry.WriteText(stream);
+    if (!stream) {
+      return false;
+    }
+  }
+
+#ifdef _WIN32
+  // rename() does not replace an existing file on Windows.
+  std::remove(path.c_str());
+#endif
+  return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+}; // namespace TimetableWeaver
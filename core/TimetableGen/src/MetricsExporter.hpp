@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "Metrics.hpp"
+
+namespace TimetableWeaver
+{
+// Serves the registry in Prometheus text format over HTTP on the loopback
+// interface. Every request gets the full metrics page, whatever its path.
+// The accept loop runs on its own thread and polls a stop flag, so the
+// solver threads never wait on scrapes.
+class MetricsServer
+{
+public:
+  explicit MetricsServer(const MetricsRegistry &registry);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer &)            = delete;
+  MetricsServer &operator=(const MetricsServer &) = delete;
+
+  // Binds 127.0.0.1:port; port 0 picks a free port. Returns false when the
+  // socket cannot be bound.
+  bool Start(int port);
+  void Stop();
+
+  int GetPort() const { return m_Port; }
+
+private:
+  void Serve();
+
+  const MetricsRegistry &m_Registry;
+
+  intptr_t          m_Socket = -1;
+  int               m_Port   = 0;
+  std::atomic<bool> m_Running{false};
+  std::thread       m_Thread;
+};
+
+// Rewrites a file with the metrics page at a fixed interval, for
+// collectors that read text files. The file is replaced atomically through
+// a temporary next to it.
+class StatsFileWriter
+{
+public:
+  explicit StatsFileWriter(const MetricsRegistry &registry);
+  ~StatsFileWriter();
+
+  StatsFileWriter(const StatsFileWriter &)            = delete;
+  StatsFileWriter &operator=(const StatsFileWriter &) = delete;
+
+  // Rewrites the file every `intervalMs` until Stop(); intervals of zero
+  // or less fall back to 200 ms.
+  void Start(const std::string &path, int intervalMs);
+  void Stop();
+
+  // Writes the file once, immediately.
+  bool Write(const std::string &path) const;
+
+private:
+  const MetricsRegistry &m_Registry;
+
+  std::atomic<bool> m_Running{false};
+  std::thread       m_Thread;
+};
+}; // namespace TimetableWeaver
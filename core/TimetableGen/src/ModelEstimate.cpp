@@ -0,0 +1,268 @@
+#include "ModelEstimate.hpp"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+// Rough costs of one model element across the builder proto, the presolved
+// copy and the solver's internal representation.
+static const int64_t kBytesPerVariable   = 160;
+static const int64_t kBytesPerConstraint = 128;
+static const int64_t kBytesPerTerm       = 32;
+static const int64_t kBytesPerMb         = 1024 * 1024;
+
+// Weekly patterns column generation typically ends up with per lesson.
+static const int64_t kPatternsPerLesson = 8;
+
+const char *GetFormulationName(Formulation formulation)
+{
+  switch (formulation) {
+  case Formulation::Auto:
+    return "auto";
+  case Formulation::SlotBoolean:
+    return "slot-boolean";
+  case Formulation::SlotInteger:
+    return "slot-integer";
+  case Formulation::Pattern:
+    return "pattern";
+  }
+  return "unknown";
+}
+
+static int64_t EstimateBytes(const ModelEstimate &estimate)
+{
+  return estimate.variables * kBytesPerVariable +
+         estimate.constraints * kBytesPerConstraint +
+         estimate.terms * kBytesPerTerm;
+}
+
+// Adds expr <= cap as DailyRuleCompiler does, with its slack variable when
+// the rule is soft.
+static void AddAtMost(ModelEstimate &estimate, const DailyRule &rule,
+                      int64_t terms)
+{
+  estimate.constraints += 1;
+  estimate.terms += terms;
+  if (!rule.hard) {
+    estimate.variables += 1;
+    estimate.terms += 2;
+  }
+}
+
+// Mirrors DailyRuleCompiler::CompileEntity over per-slot literal counts.
+static void EstimateRule(ModelEstimate &estimate, const DailyRule &rule,
+                         const int *slots, int days, int periods)
+{
+  for (int d = 0; d < days; ++d) {
+    const int *day = slots + d * periods;
+    if (std::all_of(day, day + periods, [](int n) { return n == 0; })) {
+      continue;
+    }
+
+    auto sum = [&](int first, int last) {
+      int64_t total = 0;
+      for (int p = first; p <= last; ++p) {
+        total += day[p];
+      }
+      return total;
+    };
+
+    switch (rule.kind) {
+    case DailyRuleKind::MaxConsecutive:
+      for (int start = 0; start + rule.limit + 1 <= periods; ++start) {
+        AddAtMost(estimate, rule, sum(start, start + rule.limit));
+      }
+      break;
+    case DailyRuleKind::MaxPerDay:
+      if (rule.limit < periods) {
+        AddAtMost(estimate, rule, sum(0, periods - 1));
+      }
+      break;
+    case DailyRuleKind::Break: {
+      const int first = std::max(rule.firstPeriod, 0);
+      const int last  = std::min(rule.lastPeriod, periods - 1);
+      if (first <= last) {
+        AddAtMost(estimate, rule, sum(first, last));
+      }
+      break;
+    }
+    case DailyRuleKind::NoGaps:
+      estimate.variables += 2 * periods;
+      estimate.constraints += 6 * periods;
+      estimate.terms += 2 * periods * (3 + 2) + 4 * sum(0, periods - 1);
+      for (int p = 1; p + 1 < periods; ++p) {
+        AddAtMost(estimate, rule, 2 + day[p]);
+      }
+      break;
+    }
+  }
+}
+
+std::vector<ModelEstimate> EstimateModels(const TimetableConfig &config)
+{
+  const int days        = config.days;
+  const int periods     = config.periodsPerDay;
+  const int numSlots    = days * periods;
+  const int numClasses  = static_cast<int>(config.classes.size());
+  const int numTeachers = static_cast<int>(config.teachers.size());
+
+  ModelEstimate boolean;
+  boolean.formulation = Formulation::SlotBoolean;
+  boolean.supported   = config.spreads.empty();
+  ModelEstimate integer;
+  integer.formulation = Formulation::SlotInteger;
+  integer.supported   = config.rules.empty() && config.spreads.empty() &&
+                        !config.HasSubgroupLessons();
+  ModelEstimate pattern;
+  pattern.formulation = Formulation::Pattern;
+  pattern.supported   = !config.HasSubgroupLessons();
+
+  // Number of lesson literals per (entity, slot), which sizes the AtMostOne
+  // constraints and every rule built over the occupancy sums.
+  std::vector<int> classSlots(numClasses * numSlots, 0);
+  std::vector<int> teacherSlots(numTeachers * numSlots, 0);
+
+  // Subgroup literals per (class slot, partition, group).
+  std::map<std::tuple<int, int, int>, int> groupSlots;
+
+  const LessonIds ids = config.GetLessonIds();
+  for (size_t i = 0; i < config.lessons.size(); ++i) {
+    const auto &lesson    = config.lessons[i];
+    const int   classId   = ids.classes[i];
+    const int   teacherId = ids.teachers[i];
+    if (classId < 0 || teacherId < 0) {
+      continue;
+    }
+    const Availability &classAvail   = lesson->GetClass()->GetAvailability();
+    const Availability &teacherAvail = lesson->GetTeacher()->GetAvailability();
+
+    int64_t allowed = 0;
+    for (int d = 0; d < days; ++d) {
+      uint32_t mask = classAvail.GetDay(d) & teacherAvail.GetDay(d);
+      allowed += PopCount(mask);
+      for (; mask != 0; mask &= mask - 1) {
+        const int       slot     = d * periods + CountTrailingZeros(mask);
+        const Subgroup &subgroup = lesson->GetSubgroup();
+        if (subgroup.IsWholeClass()) {
+          classSlots[classId * numSlots + slot]++;
+        } else {
+          groupSlots[{classId * numSlots + slot, subgroup.partition,
+                      subgroup.group}]++;
+        }
+        teacherSlots[teacherId * numSlots + slot]++;
+      }
+    }
+
+    const int64_t weekly = lesson->GetPeriodsPerWeek();
+
+    // Slot-Boolean: a literal per allowed slot and one equality over them.
+    boolean.variables += allowed;
+    boolean.constraints += 1;
+    boolean.terms += allowed;
+
+    // Slot-integer: a variable per weekly period over the allowed slots,
+    // ordered to break symmetry between copies of the same lesson.
+    const int64_t ordered = std::max<int64_t>(weekly - 1, 0);
+    integer.variables += weekly;
+    integer.constraints += ordered;
+    integer.terms += weekly * allowed + 2 * ordered;
+
+    // Pattern: a literal per pattern in the final pool, each in the
+    // lesson's ExactlyOne and the class and teacher AtMostOne of its slots.
+    const int64_t patterns = std::min<int64_t>(kPatternsPerLesson, allowed);
+    pattern.variables += patterns;
+    pattern.constraints += 1;
+    pattern.terms += patterns * (1 + 2 * weekly);
+  }
+
+  // Every partition in use at a class slot adds an activity literal to the
+  // class's AtMostOne, tied to its groups by one capacity constraint per
+  // group and one over all of them.
+  std::pair<int, int> partition(-1, -1);
+  for (const auto &[key, n] : groupSlots) {
+    const auto &[classSlot, partitionId, group] = key;
+    if (partition != std::make_pair(classSlot, partitionId)) {
+      partition = {classSlot, partitionId};
+      boolean.variables += 1;
+      boolean.constraints += 1;
+      boolean.terms += 1;
+      classSlots[classSlot]++;
+    }
+    boolean.constraints += 1;
+    boolean.terms += 2 * n + 1;
+  }
+
+  for (int n : classSlots) {
+    boolean.constraints += n > 1;
+    boolean.terms += n > 1 ? n : 0;
+    pattern.constraints += n > 1;
+  }
+  for (int n : teacherSlots) {
+    boolean.constraints += n > 1;
+    boolean.terms += n > 1 ? n : 0;
+    pattern.constraints += n > 1;
+  }
+
+  // One AllDifferent per class and teacher, over all its lesson copies.
+  integer.constraints += numClasses + numTeachers;
+  integer.terms += 2 * integer.variables;
+
+  for (const auto &rule : config.rules) {
+    const bool  classes = rule.target == RuleTarget::Classes;
+    const int   count   = classes ? numClasses : numTeachers;
+    const auto &slots   = classes ? classSlots : teacherSlots;
+    for (int e = 0; e < count; ++e) {
+      if (rule.entityId < 0 || rule.entityId == e) {
+        EstimateRule(boolean, rule, &slots[e * numSlots], days, periods);
+        EstimateRule(pattern, rule, &slots[e * numSlots], days, periods);
+      }
+    }
+  }
+
+  boolean.bytes = EstimateBytes(boolean);
+  integer.bytes = EstimateBytes(integer);
+  pattern.bytes = EstimateBytes(pattern);
+  return {boolean, integer, pattern};
+}
+
+int SelectFormulation(const std::vector<ModelEstimate> &estimates,
+                      int                               memoryBudgetMb)
+{
+  const int64_t budget = static_cast<int64_t>(memoryBudgetMb) * kBytesPerMb;
+  for (size_t i = 0; i < estimates.size(); ++i) {
+    const ModelEstimate &estimate = estimates[i];
+    if (estimate.supported && (budget <= 0 || estimate.bytes <= budget)) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void PrintEstimates(std::ostream &stream,
+                    const std::vector<ModelEstimate> &estimates,
+                    int                               memoryBudgetMb)
+{
+  stream << "Model estimates (budget ";
+  if (memoryBudgetMb > 0) {
+    stream << memoryBudgetMb << " MB";
+  } else {
+    stream << "unlimited";
+  }
+  stream << "):\n";
+
+  for (const auto &estimate : estimates) {
+    stream << "  " << GetFormulationName(estimate.formulation) << ": "
+           << estimate.variables << " variables, " << estimate.constraints
+           << " constraints, " << estimate.terms << " terms, "
+           << (estimate.bytes + kBytesPerMb - 1) / kBytesPerMb << " MB";
+    if (!estimate.supported) {
+      stream << " (does not support this config)";
+    }
+    stream << "\n";
+  }
+}
+}; // namespace TimetableWeaver
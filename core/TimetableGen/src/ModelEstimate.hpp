@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+enum class Formulation {
+  Auto,        // Cheapest preferred formulation within the budget
+  SlotBoolean, // One literal per lesson and allowed slot; supports rules
+  SlotInteger, // One slot variable per weekly period; no daily rules and
+               // no subgroups
+  Pattern      // One literal per generated weekly pattern of a lesson;
+               // the only one with spreads, no subgroups
+};
+
+const char *GetFormulationName(Formulation formulation);
+
+struct ModelEstimate {
+  Formulation formulation = Formulation::SlotBoolean;
+  bool        supported   = true; // False when the config needs features
+                                  // the formulation lacks
+  int64_t variables   = 0;
+  int64_t constraints = 0;
+  int64_t terms       = 0; // Linear terms and domain values
+  int64_t bytes       = 0; // Model build plus solver working set
+};
+
+// Predicts the size of every formulation from the availability masks and
+// lesson index alone, without building a model. Byte counts use fixed
+// per-variable, per-constraint and per-term costs that include CP-SAT's
+// presolved copy; they are meant to be conservative rather than exact.
+// Estimates are returned in order of preference.
+std::vector<ModelEstimate> EstimateModels(const TimetableConfig &config);
+
+// Index of the first supported estimate within the budget, or -1. A budget
+// of zero accepts every supported formulation.
+int SelectFormulation(const std::vector<ModelEstimate> &estimates,
+                      int                               memoryBudgetMb);
+
+void PrintEstimates(std::ostream &stream,
+                    const std::vector<ModelEstimate> &estimates,
+                    int                               memoryBudgetMb);
+}; // namespace TimetableWeaver
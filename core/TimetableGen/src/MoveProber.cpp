@@ -0,0 +1,203 @@
+#include "MoveProber.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace TimetableWeaver
+{
+const char *GetProbeResultName(ProbeResult result)
+{
+  switch (result) {
+  case ProbeResult::Feasible:
+    return "feasible";
+  case ProbeResult::Infeasible:
+    return "infeasible";
+  case ProbeResult::Unknown:
+    return "unknown";
+  case ProbeResult::Current:
+    return "current";
+  }
+  return "unknown";
+}
+
+/**
+ * MoveProber
+ */
+MoveProber::MoveProber(std::shared_ptr<SolverBackend> backend,
+                       const ProbeOptions            &options)
+    : m_Backend(std::move(backend)), m_Options(options)
+{
+}
+
+ProbeMap MoveProber::Probe(const TimetableConfig &config,
+                           const Schedule        &schedule,
+                           const ScheduledLesson &entry) const
+{
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point start = Clock::now();
+
+  const auto &entries = schedule.GetEntries();
+  const bool  known   = std::any_of(
+      entries.begin(), entries.end(), [&](const ScheduledLesson &e) {
+        return e.lesson == entry.lesson && e.day == entry.day &&
+               e.period == entry.period;
+      });
+  if (!known) {
+    std::cerr << "Probed lesson period is not part of the schedule\n";
+    return {};
+  }
+  if (!m_Backend) {
+    std::cerr << "No solver backend to probe with\n";
+    return {};
+  }
+
+  const int days       = config.days;
+  const int periods    = config.periodsPerDay;
+  const int numLessons = static_cast<int>(config.lessons.size());
+
+  const LessonIds         ids      = config.GetLessonIds();
+  const std::vector<int> &classes  = ids.classes;
+  const std::vector<int> &teachers = ids.teachers;
+
+  // Lessons within the radius, found breadth first.
+  std::vector<bool> inRadius(numLessons, false);
+  std::vector<int>  frontier = {entry.lesson};
+  inRadius[entry.lesson]     = true;
+  for (int hop = 0; hop < m_Options.radius && !frontier.empty(); ++hop) {
+    std::vector<int> next;
+    for (int j = 0; j < numLessons; ++j) {
+      for (int i : frontier) {
+        if (!inRadius[j] &&
+            (classes[j] == classes[i] || teachers[j] == teachers[i])) {
+          inRadius[j] = true;
+          next.push_back(j);
+          break;
+        }
+      }
+    }
+    frontier = std::move(next);
+  }
+
+  std::vector<ScheduledLesson> pinned;
+  std::vector<bool>            blocked(days * periods, false);
+  std::vector<bool>            own(days * periods, false);
+  for (const auto &e : entries) {
+    const int slot = e.day * periods + e.period;
+    if (e.lesson == entry.lesson) {
+      own[slot] = true;
+    } else if (!inRadius[e.lesson]) {
+      pinned.push_back(e);
+      const bool classClash =
+          e.classId == classes[entry.lesson] &&
+          !AreSubgroupsCompatible(config.lessons[e.lesson]->GetSubgroup(),
+                                  config.lessons[entry.lesson]->GetSubgroup());
+      blocked[slot] = blocked[slot] || classClash ||
+                      e.teacherId == teachers[entry.lesson];
+    }
+  }
+
+  const auto &lesson = config.lessons[entry.lesson];
+  ProbeMap    map(days * periods, ProbeResult::Infeasible);
+  for (int slot = 0; slot < days * periods; ++slot) {
+    if (own[slot]) {
+      map[slot] = ProbeResult::Current;
+    }
+  }
+
+  std::vector<int> candidates;
+  for (int d = 0; d < days; ++d) {
+    const uint32_t allowed = lesson->GetClass()->GetAvailability().GetDay(d) &
+                             lesson->GetTeacher()->GetAvailability().GetDay(d);
+    for (int p = 0; p < periods; ++p) {
+      const int slot = d * periods + p;
+      if ((allowed >> p & 1) != 0 && !own[slot] && !blocked[slot]) {
+        candidates.push_back(slot);
+      }
+    }
+  }
+
+  std::atomic<size_t> next{0};
+  auto                worker = [&]() {
+    for (size_t c = next++; c < candidates.size(); c = next++) {
+      const int slot = candidates[c];
+
+      const double remaining =
+          m_Options.budgetSeconds -
+          std::chrono::duration<double>(Clock::now() - start).count();
+      if (remaining <= 0.0) {
+        map[slot] = ProbeResult::Unknown;
+        continue;
+      }
+
+      ScheduledLesson moved = entry;
+      moved.day             = slot / periods;
+      moved.period          = slot % periods;
+
+      SolveStatus  status = SolveStatus::Unknown;
+      SolveOptions options;
+      options.strategy         = SolveStrategy::FirstFeasible;
+      options.timeLimitSeconds = std::min(m_Options.slotSeconds, remaining);
+      options.hint             = &schedule;
+      options.pinned           = pinned;
+      options.pinned.push_back(moved);
+      options.numWorkers = 1;
+      options.status     = &status;
+
+      Schedule result;
+      m_Backend->Solve(config, result, options);
+      map[slot] = status == SolveStatus::Feasible     ? ProbeResult::Feasible
+                  : status == SolveStatus::Infeasible ? ProbeResult::Infeasible
+                                                      : ProbeResult::Unknown;
+    }
+  };
+
+  unsigned threads = m_Options.threads > 0
+                         ? static_cast<unsigned>(m_Options.threads)
+                         : std::max(1u, std::thread::hardware_concurrency());
+  if (!m_Backend->IsReentrant()) {
+    threads = 1;
+  }
+  threads = std::min(threads, static_cast<unsigned>(candidates.size()));
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t) {
+    pool.emplace_back(worker);
+  }
+  for (auto &thread : pool) {
+    thread.join();
+  }
+  return map;
+}
+
+void PrintProbeMap(std::ostream &stream, const TimetableConfig &config,
+                   const ProbeMap &map)
+{
+  stream << "Move probe (* current, + feasible, . infeasible, ? unknown):\n";
+  for (int d = 0; d < config.days; ++d) {
+    stream << "  Day " << d << ": ";
+    for (int p = 0; p < config.periodsPerDay; ++p) {
+      const size_t slot = d * config.periodsPerDay + p;
+      if (slot >= map.size()) {
+        break;
+      }
+      switch (map[slot]) {
+      case ProbeResult::Feasible:
+        stream << '+';
+        break;
+      case ProbeResult::Infeasible:
+        stream << '.';
+        break;
+      case ProbeResult::Unknown:
+        stream << '?';
+        break;
+      case ProbeResult::Current:
+        stream << '*';
+        break;
+      }
+    }
+    stream << "\n";
+  }
+}
+}; // namespace TimetableWeaver
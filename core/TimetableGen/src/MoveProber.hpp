@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "SolverBackend.hpp"
+
+namespace TimetableWeaver
+{
+enum class ProbeResult {
+  Feasible,   // A schedule exists with the period moved there
+  Infeasible, // Not without changing lessons outside the neighbourhood
+  Unknown,    // The probe ran out of time
+  Current     // The lesson already holds the slot
+};
+
+const char *GetProbeResultName(ProbeResult result);
+
+struct ProbeOptions {
+  double budgetSeconds = 2.0; // For the whole map
+  double slotSeconds   = 0.5; // For each re-solve
+  int    radius        = 1;   // Hops through shared classes and teachers
+  int    threads       = 0;   // 0 for one per core
+};
+
+// Results per slot, indexed by day * periodsPerDay + period.
+using ProbeMap = std::vector<ProbeResult>;
+
+// Answers "where else could this lesson period go?" for an existing
+// schedule. Every candidate slot gets a short first-feasible re-solve with
+// the period pinned there. Lessons within `radius` hops of the selected
+// lesson, counting a shared class or teacher as one hop, are free and
+// hinted from the schedule; every other lesson is pinned where it is.
+// Slots taken by a pinned lesson of the same class or teacher, or outside
+// the lesson's availability, are ruled out without a solve; slots the
+// lesson already holds, the probed one included, are marked Current.
+//
+// Re-solves run in parallel with one solver thread each when the backend
+// is reentrant, as the OR-tools backend is. Other backends keep per-solve
+// state in members, so they are probed one slot at a time.
+class MoveProber
+{
+public:
+  explicit MoveProber(std::shared_ptr<SolverBackend> backend,
+                      const ProbeOptions &options = ProbeOptions());
+
+  // `entry` must be one of the schedule's entries. Returns an empty map
+  // when it is not.
+  ProbeMap Probe(const TimetableConfig &config, const Schedule &schedule,
+                 const ScheduledLesson &entry) const;
+
+private:
+  std::shared_ptr<SolverBackend> m_Backend;
+  ProbeOptions                   m_Options;
+};
+
+void PrintProbeMap(std::ostream &stream, const TimetableConfig &config,
+                   const ProbeMap &map);
+}; // namespace TimetableWeaver
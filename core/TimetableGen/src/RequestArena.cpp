@@ -0,0 +1,283 @@
+#include "RequestArena.hpp"
+
+#include <algorithm>
+
+#include "Metrics.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace TimetableWeaver
+{
+static void *MapChunk(size_t size)
+{
+#ifdef _WIN32
+  return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                      PAGE_READWRITE);
+#else
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return data == MAP_FAILED ? nullptr : data;
+#endif
+}
+
+static void UnmapChunk(void *data, size_t size)
+{
+#ifdef _WIN32
+  (void)size;
+  VirtualFree(data, 0, MEM_RELEASE);
+#else
+  munmap(data, size);
+#endif
+}
+
+// Chunks shared by all arenas. Only chunks of the size they were cached
+// with are reused; oversized ones always go back to the system.
+class ChunkPool
+{
+public:
+  void *Acquire(size_t size)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      for (size_t i = m_Cached.size(); i-- > 0;) {
+        if (m_Cached[i].second == size) {
+          void *data = m_Cached[i].first;
+          m_Cached.erase(m_Cached.begin() + i);
+          m_CachedBytes -= size;
+          return data;
+        }
+      }
+    }
+    void *data = MapChunk(size);
+    if (data != nullptr) {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_MappedBytes += size;
+    }
+    return data;
+  }
+
+  void Return(void *data, size_t size)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      if (m_CachedBytes + size <= m_Limit) {
+        m_Cached.emplace_back(data, size);
+        m_CachedBytes += size;
+        return;
+      }
+      m_MappedBytes -= size;
+    }
+    UnmapChunk(data, size);
+  }
+
+  void Trim()
+  {
+    std::vector<std::pair<void *, size_t>> chunks;
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      chunks.swap(m_Cached);
+      m_MappedBytes -= m_CachedBytes;
+      m_CachedBytes = 0;
+    }
+    for (const auto &chunk : chunks) {
+      UnmapChunk(chunk.first, chunk.second);
+    }
+  }
+
+  void SetLimit(size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Limit = bytes;
+  }
+
+  void GetStats(uint64_t &mapped, uint64_t &cached)
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    mapped = m_MappedBytes;
+    cached = m_CachedBytes;
+  }
+
+private:
+  std::mutex                             m_Mutex;
+  std::vector<std::pair<void *, size_t>> m_Cached;
+  size_t                                 m_CachedBytes = 0;
+  size_t                                 m_MappedBytes = 0;
+  size_t                                 m_Limit       = 64 << 20;
+};
+
+static ChunkPool &GetChunkPool()
+{
+  static ChunkPool pool;
+  return pool;
+}
+
+static thread_local RequestArena *g_CurrentArena = nullptr;
+
+/**
+ * RequestArena
+ */
+RequestArena::RequestArena(size_t chunkBytes) : m_ChunkBytes(chunkBytes) {}
+
+RequestArena::~RequestArena()
+{
+  Release();
+}
+
+void *RequestArena::Allocate(size_t bytes, size_t alignment)
+{
+  const uintptr_t cursor  = reinterpret_cast<uintptr_t>(m_Cursor);
+  const uintptr_t aligned = (cursor + alignment - 1) & ~(alignment - 1);
+  if (m_Cursor == nullptr ||
+      aligned + bytes > reinterpret_cast<uintptr_t>(m_End)) {
+    // Requests larger than a chunk get a chunk of their own.
+    const size_t size = std::max(m_ChunkBytes, bytes + alignment);
+    void        *data = GetChunkPool().Acquire(size);
+    if (data == nullptr) {
+      throw std::bad_alloc();
+    }
+    m_Chunks.push_back({data, size});
+    m_Reserved += size;
+    m_Cursor = static_cast<char *>(data);
+    m_End    = m_Cursor + size;
+    return Allocate(bytes, alignment);
+  }
+  m_Cursor = reinterpret_cast<char *>(aligned + bytes);
+  m_Used += bytes;
+  return reinterpret_cast<void *>(aligned);
+}
+
+void RequestArena::Release()
+{
+  for (const auto &chunk : m_Chunks) {
+    GetChunkPool().Return(chunk.data, chunk.size);
+  }
+  m_Chunks.clear();
+  m_Cursor   = nullptr;
+  m_End      = nullptr;
+  m_Used     = 0;
+  m_Reserved = 0;
+}
+
+RequestArena *RequestArena::GetCurrent()
+{
+  return g_CurrentArena;
+}
+
+/**
+ * RequestScope
+ */
+RequestScope::RequestScope(RequestArena &arena) : m_Previous(g_CurrentArena)
+{
+  g_CurrentArena = &arena;
+}
+
+RequestScope::~RequestScope()
+{
+  g_CurrentArena = m_Previous;
+}
+
+void SetArenaCacheLimit(size_t bytes)
+{
+  GetChunkPool().SetLimit(bytes);
+}
+
+HeapReport GetHeapReport()
+{
+  HeapReport report;
+  report.residentBytes = GetResidentMemoryBytes();
+  GetChunkPool().GetStats(report.arenaMappedBytes, report.arenaCachedBytes);
+#if defined(__GLIBC__) &&                                                      \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  const struct mallinfo2 info = mallinfo2();
+  report.heapBytes            = info.arena;
+  report.heapInUseBytes       = info.uordblks;
+  report.heapFreeBytes        = info.fordblks;
+  report.mmapBytes            = info.hblkhd;
+#elif defined(__GLIBC__)
+  // The int fields of the old interface wrap beyond 2 GB.
+  const struct mallinfo info = mallinfo();
+  report.heapBytes           = static_cast<unsigned int>(info.arena);
+  report.heapInUseBytes      = static_cast<unsigned int>(info.uordblks);
+  report.heapFreeBytes       = static_cast<unsigned int>(info.fordblks);
+  report.mmapBytes           = static_cast<unsigned int>(info.hblkhd);
+#endif
+  return report;
+}
+
+void PrintHeapReport(std::ostream &stream, const HeapReport &report)
+{
+  const double mb = 1024.0 * 1024.0;
+  stream << "RSS " << report.residentBytes / mb << " MB, heap "
+         << report.heapBytes / mb << " MB (" << report.heapInUseBytes / mb
+         << " MB in use, " << report.heapFreeBytes / mb << " MB free, "
+         << report.GetFragmentation() * 100 << "% fragmented), mmapped "
+         << report.mmapBytes / mb << " MB, arena chunks "
+         << report.arenaMappedBytes / mb << " MB ("
+         << report.arenaCachedBytes / mb << " MB cached)\n";
+}
+
+uint64_t TrimHeap()
+{
+  const uint64_t before = GetResidentMemoryBytes();
+  GetChunkPool().Trim();
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  const uint64_t after = GetResidentMemoryBytes();
+  return before > after ? before - after : 0;
+}
+
+/**
+ * HeapTrimmer
+ */
+HeapTrimmer::HeapTrimmer(const HeapTrimOptions &options) : m_Options(options)
+{
+}
+
+bool HeapTrimmer::OnRequestDone()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  if (++m_Requests < m_Options.everyRequests) {
+    return false;
+  }
+  m_Requests = 0;
+
+  m_LastReport = GetHeapReport();
+  const bool fragmented =
+      m_LastReport.GetFragmentation() >= m_Options.minFragmentation &&
+      m_LastReport.heapFreeBytes >= m_Options.minFreeBytes;
+  if (!fragmented) {
+    return false;
+  }
+  m_ReleasedBytes += TrimHeap();
+  ++m_Trims;
+  return true;
+}
+
+int HeapTrimmer::GetTrimCount() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Trims;
+}
+
+uint64_t HeapTrimmer::GetReleasedBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_ReleasedBytes;
+}
+
+HeapReport HeapTrimmer::GetLastReport() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_LastReport;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+
+namespace TimetableWeaver
+{
+// Monotonic memory for data that lives exactly as long as one request:
+// indexes, search scratch and propagated domains.
+//
+// Allocations bump a pointer through chunks that are mapped from the
+// system directly rather than taken from malloc, and are all dropped at
+// once when the arena is released or destroyed. Short-lived request data
+// then never interleaves with long-lived heap blocks, which is what leaves
+// a long-running solver's heap fragmented with an RSS that never shrinks.
+// Released chunks are kept in a small process-wide cache for the next
+// request; the rest go back to the system.
+class RequestArena
+{
+public:
+  static constexpr size_t kDefaultChunkBytes = 1 << 20;
+
+  explicit RequestArena(size_t chunkBytes = kDefaultChunkBytes);
+  ~RequestArena();
+
+  RequestArena(const RequestArena &)            = delete;
+  RequestArena &operator=(const RequestArena &) = delete;
+
+  void *Allocate(size_t bytes, size_t alignment);
+
+  // Drops every allocation at once.
+  void Release();
+
+  size_t GetBytesUsed() const { return m_Used; }
+  size_t GetBytesReserved() const { return m_Reserved; }
+
+  // The arena of the innermost RequestScope on this thread, or nullptr.
+  static RequestArena *GetCurrent();
+
+private:
+  friend class RequestScope;
+
+  struct Chunk {
+    void  *data;
+    size_t size;
+  };
+
+  size_t             m_ChunkBytes;
+  std::vector<Chunk> m_Chunks;
+  char              *m_Cursor   = nullptr;
+  char              *m_End      = nullptr;
+  size_t             m_Used     = 0;
+  size_t             m_Reserved = 0;
+};
+
+// Makes an arena current on this thread for its lifetime. Scopes nest;
+// the arena must outlive every container created inside the scope.
+class RequestScope
+{
+public:
+  explicit RequestScope(RequestArena &arena);
+  ~RequestScope();
+
+  RequestScope(const RequestScope &)            = delete;
+  RequestScope &operator=(const RequestScope &) = delete;
+
+private:
+  RequestArena *m_Previous;
+};
+
+// Allocates from the arena that was current when the allocator, usually
+// its container, was constructed, and from the heap outside any scope.
+// Deallocation is a no-op inside an arena.
+template <typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept : m_Arena(RequestArena::GetCurrent()) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+      : m_Arena(other.GetArena())
+  {
+  }
+
+  T *allocate(size_t count)
+  {
+    if (m_Arena == nullptr) {
+      return static_cast<T *>(::operator new(count * sizeof(T)));
+    }
+    return static_cast<T *>(m_Arena->Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *pointer, size_t) noexcept
+  {
+    if (m_Arena == nullptr) {
+      ::operator delete(pointer);
+    }
+  }
+
+  RequestArena *GetArena() const { return m_Arena; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U> &other) const
+  {
+    return m_Arena == other.GetArena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U> &other) const
+  {
+    return m_Arena != other.GetArena();
+  }
+
+private:
+  RequestArena *m_Arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Bytes of released arena chunks kept for reuse; 64 MB by default.
+void SetArenaCacheLimit(size_t bytes);
+
+struct HeapReport {
+  uint64_t residentBytes    = 0;
+  uint64_t heapBytes        = 0; // Held by malloc, excluding mmapped blocks
+  uint64_t heapInUseBytes   = 0;
+  uint64_t heapFreeBytes    = 0; // Free but held: the fragmentation
+  uint64_t mmapBytes        = 0; // Large malloc blocks mapped on their own
+  uint64_t arenaMappedBytes = 0; // Arena chunks in use or cached
+  uint64_t arenaCachedBytes = 0;
+
+  // Share of the heap that is free but not returned to the system.
+  double GetFragmentation() const
+  {
+    return heapBytes == 0 ? 0.0
+                          : static_cast<double>(heapFreeBytes) / heapBytes;
+  }
+};
+
+// The malloc figures are only filled in with glibc.
+HeapReport GetHeapReport();
+void       PrintHeapReport(std::ostream &stream, const HeapReport &report);
+
+// Returns the cached arena chunks and free heap pages to the system.
+// Returns how much the resident set shrank, in bytes.
+uint64_t TrimHeap();
+
+struct HeapTrimOptions {
+  int      everyRequests    = 100;      // Look at the heap this often
+  double   minFragmentation = 0.2;      // Free share of the heap to trim
+  uint64_t minFreeBytes     = 16 << 20; // Free bytes worth a trim
+};
+
+// Periodic trim for long-running services: every few requests it reads
+// the heap report and trims when enough of the heap is free. Trimming
+// walks the heap, so it is not done after every request.
+class HeapTrimmer
+{
+public:
+  explicit HeapTrimmer(const HeapTrimOptions &options = HeapTrimOptions());
+
+  // Call after each request; safe from several threads. True when the
+  // heap was trimmed.
+  bool OnRequestDone();
+
+  int        GetTrimCount() const;
+  uint64_t   GetReleasedBytes() const;
+  HeapReport GetLastReport() const;
+
+private:
+  HeapTrimOptions    m_Options;
+  mutable std::mutex m_Mutex;
+  int                m_Requests      = 0;
+  int                m_Trims         = 0;
+  uint64_t           m_ReleasedBytes = 0;
+  HeapReport         m_LastReport;
+};
+}; // namespace TimetableWeaver
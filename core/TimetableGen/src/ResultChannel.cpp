@@ -0,0 +1,298 @@
+#include "ResultChannel.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+static const char     kChannelMagic[4] = {'T', 'W', 'R', 'C'};
+static const uint32_t kChannelFormat   = 1;
+
+static_assert(sizeof(ResultChannelHeader) == 64, "header must be 64 bytes");
+static_assert(sizeof(ResultFrameHeader) == 64,
+              "frame header must be 64 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory counters need lock-free 64-bit atomics");
+
+static std::atomic<uint64_t> &AsAtomic(uint64_t &value)
+{
+  return *reinterpret_cast<std::atomic<uint64_t> *>(&value);
+}
+
+static const std::atomic<uint64_t> &AsAtomic(const uint64_t &value)
+{
+  return *reinterpret_cast<const std::atomic<uint64_t> *>(&value);
+}
+
+static size_t BitmapWords(uint32_t cellCount) { return (cellCount + 63) / 64; }
+
+/**
+ * ResultChannelWriter
+ */
+bool ResultChannelWriter::Create(const std::string &path, int days,
+                                 int periodsPerDay, int numClasses,
+                                 int capacity)
+{
+  assert(days >= 1 && days <= 7);
+  assert(periodsPerDay >= 1 && periodsPerDay <= 32);
+  assert(numClasses >= 0 && capacity >= 2);
+
+  Close();
+
+  const uint32_t cellCount =
+      static_cast<uint32_t>(numClasses * days * periodsPerDay);
+  size_t frameSize = sizeof(ResultFrameHeader) +
+                     BitmapWords(cellCount) * sizeof(uint64_t) +
+                     cellCount * sizeof(uint16_t);
+  frameSize = (frameSize + 63) & ~static_cast<size_t>(63);
+
+  if (!m_File.Create(path,
+                     sizeof(ResultChannelHeader) + capacity * frameSize)) {
+    return false;
+  }
+
+  m_Header = reinterpret_cast<ResultChannelHeader *>(m_File.GetMutableData());
+  std::memset(m_File.GetMutableData(), 0, m_File.GetSize());
+  std::memcpy(m_Header->magic, kChannelMagic, 4);
+  m_Header->format        = kChannelFormat;
+  m_Header->days          = static_cast<uint32_t>(days);
+  m_Header->periodsPerDay = static_cast<uint32_t>(periodsPerDay);
+  m_Header->numClasses    = static_cast<uint32_t>(numClasses);
+  m_Header->capacity      = static_cast<uint32_t>(capacity);
+  m_Header->frameSize     = static_cast<uint32_t>(frameSize);
+  m_Header->cellCount     = cellCount;
+
+  m_Cells.assign(cellCount, kNoLesson);
+  return true;
+}
+
+void ResultChannelWriter::Close()
+{
+  m_File.Close();
+  m_Header  = nullptr;
+  m_Version = 0;
+  m_Cells.clear();
+}
+
+uint64_t ResultChannelWriter::Publish(const Schedule &schedule)
+{
+  assert(m_Header != nullptr);
+  assert(schedule.GetDays() == static_cast<int>(m_Header->days));
+  assert(schedule.GetPeriodsPerDay() ==
+         static_cast<int>(m_Header->periodsPerDay));
+
+  const uint32_t days    = m_Header->days;
+  const uint32_t periods = m_Header->periodsPerDay;
+
+  std::vector<uint16_t> cells(m_Header->cellCount, kNoLesson);
+  for (const auto &entry : schedule.GetEntries()) {
+    if (static_cast<uint32_t>(entry.classId) >= m_Header->numClasses) {
+      continue;
+    }
+    // Lesson ids from kNoLesson up cannot be told apart from a free cell,
+    // and a slot off the grid would land in another class's cells.
+    if (entry.lesson < 0 || entry.lesson >= kNoLesson ||
+        static_cast<uint32_t>(entry.day) >= days ||
+        static_cast<uint32_t>(entry.period) >= periods) {
+      return 0;
+    }
+    size_t cell = (entry.classId * days + entry.day) * periods + entry.period;
+    if (cells[cell] != kNoLesson) {
+      return 0;
+    }
+    cells[cell] = static_cast<uint16_t>(entry.lesson);
+  }
+
+  const uint64_t version = m_Version + 1;
+  uint8_t *frame = m_File.GetMutableData() + sizeof(ResultChannelHeader) +
+                   ((version - 1) % m_Header->capacity) * m_Header->frameSize;
+  auto     *frameHeader = reinterpret_cast<ResultFrameHeader *>(frame);
+  uint64_t *bitmap =
+      reinterpret_cast<uint64_t *>(frame + sizeof(ResultFrameHeader));
+  uint16_t *frameCells = reinterpret_cast<uint16_t *>(
+      reinterpret_cast<uint8_t *>(bitmap) +
+      BitmapWords(m_Header->cellCount) * sizeof(uint64_t));
+
+  auto &stamp = AsAtomic(frameHeader->stamp);
+  stamp.store(2 * version - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint32_t changed = 0;
+  std::memset(bitmap, 0, BitmapWords(m_Header->cellCount) * sizeof(uint64_t));
+  for (size_t i = 0; i < cells.size(); ++i) {
+    if (cells[i] != m_Cells[i]) {
+      bitmap[i / 64] |= uint64_t(1) << (i % 64);
+      ++changed;
+    }
+  }
+  std::memcpy(frameCells, cells.data(), cells.size() * sizeof(uint16_t));
+  frameHeader->changedCells = changed;
+  frameHeader->numLessons =
+      static_cast<uint32_t>(schedule.GetEntries().size());
+
+  stamp.store(2 * version, std::memory_order_release);
+  AsAtomic(m_Header->version).store(version, std::memory_order_release);
+
+  m_Cells   = std::move(cells);
+  m_Version = version;
+  return version;
+}
+
+/**
+ * ResultChannelReader
+ */
+bool ResultChannelReader::Open(const std::string &path)
+{
+  Close();
+  if (!m_File.Open(path) || m_File.GetSize() < sizeof(ResultChannelHeader)) {
+    Close();
+    return false;
+  }
+
+  std::memcpy(&m_Header, m_File.GetData(), sizeof(ResultChannelHeader));
+  if (std::memcmp(m_Header.magic, kChannelMagic, 4) != 0 ||
+      m_Header.format != kChannelFormat || m_Header.capacity == 0 ||
+      m_File.GetSize() < sizeof(ResultChannelHeader) +
+                             uint64_t(m_Header.capacity) * m_Header.frameSize) {
+    Close();
+    return false;
+  }
+
+  m_BitmapWords = BitmapWords(m_Header.cellCount);
+  return true;
+}
+
+void ResultChannelReader::Close()
+{
+  m_File.Close();
+  m_Header      = ResultChannelHeader{};
+  m_BitmapWords = 0;
+}
+
+uint64_t ResultChannelReader::GetVersion() const
+{
+  if (!m_File.IsOpen()) {
+    return 0;
+  }
+  const auto *header =
+      reinterpret_cast<const ResultChannelHeader *>(m_File.GetData());
+  return AsAtomic(header->version).load(std::memory_order_acquire);
+}
+
+const ResultFrameHeader *ResultChannelReader::GetFrame(uint64_t version) const
+{
+  return reinterpret_cast<const ResultFrameHeader *>(
+      m_File.GetData() + sizeof(ResultChannelHeader) +
+      ((version - 1) % m_Header.capacity) * m_Header.frameSize);
+}
+
+bool ResultChannelReader::ReadFrame(uint64_t version,
+                                    std::vector<uint16_t> &cells) const
+{
+  if (version == 0 || version > GetVersion()) {
+    return false;
+  }
+
+  const ResultFrameHeader *frame = GetFrame(version);
+  const uint16_t          *frameCells = reinterpret_cast<const uint16_t *>(
+      reinterpret_cast<const uint8_t *>(frame + 1) +
+      m_BitmapWords * sizeof(uint64_t));
+
+  const uint64_t before =
+      AsAtomic(frame->stamp).load(std::memory_order_acquire);
+  if (before != 2 * version) {
+    return false;
+  }
+  cells.assign(frameCells, frameCells + m_Header.cellCount);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return AsAtomic(frame->stamp).load(std::memory_order_relaxed) == before;
+}
+
+bool ResultChannelReader::ReadUpdates(
+    uint64_t &lastSeen, std::vector<ResultCellUpdate> &updates) const
+{
+  updates.clear();
+
+  const uint64_t latest = GetVersion();
+  if (latest == lastSeen) {
+    return true;
+  }
+
+  const uint32_t days    = m_Header.days;
+  const uint32_t periods = m_Header.periodsPerDay;
+  auto           emit    = [&](size_t cell, uint16_t lesson) {
+    ResultCellUpdate update;
+    update.classId = static_cast<int>(cell / (days * periods));
+    update.day     = static_cast<int>(cell / periods % days);
+    update.period  = static_cast<int>(cell % periods);
+    update.lesson  = lesson == kNoLesson ? -1 : lesson;
+    updates.push_back(update);
+  };
+
+  // The frame after `latest` may already be in the writer's hands, so only
+  // frames strictly inside the ring are safe to merge.
+  if (lastSeen == 0 || lastSeen > latest ||
+      latest - lastSeen >= m_Header.capacity) {
+    std::vector<uint16_t> cells;
+    if (!ReadFrame(latest, cells)) {
+      return false;
+    }
+    for (size_t i = 0; i < cells.size(); ++i) {
+      emit(i, cells[i]);
+    }
+    lastSeen = latest;
+    return true;
+  }
+
+  // Union of the change bitmaps of every version the reader missed.
+  std::vector<uint64_t> changed(m_BitmapWords, 0);
+  for (uint64_t v = lastSeen + 1; v <= latest; ++v) {
+    const ResultFrameHeader *frame = GetFrame(v);
+    const uint64_t *bitmap = reinterpret_cast<const uint64_t *>(frame + 1);
+
+    const uint64_t before =
+        AsAtomic(frame->stamp).load(std::memory_order_acquire);
+    if (before != 2 * v) {
+      return false;
+    }
+    for (size_t w = 0; w < m_BitmapWords; ++w) {
+      changed[w] |= bitmap[w];
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (AsAtomic(frame->stamp).load(std::memory_order_relaxed) != before) {
+      return false;
+    }
+  }
+
+  const ResultFrameHeader *frame      = GetFrame(latest);
+  const uint16_t          *frameCells = reinterpret_cast<const uint16_t *>(
+      reinterpret_cast<const uint8_t *>(frame + 1) +
+      m_BitmapWords * sizeof(uint64_t));
+
+  const uint64_t before =
+      AsAtomic(frame->stamp).load(std::memory_order_acquire);
+  if (before != 2 * latest) {
+    return false;
+  }
+  for (size_t w = 0; w < m_BitmapWords; ++w) {
+    uint64_t word = changed[w];
+    while (word != 0) {
+      int    bit  = CountTrailingZeros(word);
+      size_t cell = w * 64 + bit;
+      emit(cell, frameCells[cell]);
+      word &= word - 1;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (AsAtomic(frame->stamp).load(std::memory_order_relaxed) != before) {
+    updates.clear();
+    return false;
+  }
+
+  lastSeen = latest;
+  return true;
+}
+}; // namespace TimetableWeaver
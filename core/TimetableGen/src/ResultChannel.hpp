@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Schedule.hpp"
+
+namespace TimetableWeaver
+{
+// Shared-memory ring of schedule snapshots published by the solver while it
+// improves a solution, read by the UI process without any serialisation.
+//
+// Layout (little-endian):
+//   ResultChannelHeader
+//   capacity x frame, each frameSize bytes:
+//     ResultFrameHeader
+//     changed-cells bitmap, one bit per cell, in uint64 words
+//     lesson id per cell (uint16, kNoLesson when the cell is free)
+//
+// A cell is one (class, day, period); its index is
+// (classId * days + day) * periodsPerDay + period. A cell holds one lesson,
+// so schedules where subgroup lessons of a class share a slot cannot be
+// published; Timetable does not stream at all for configs with subgroup
+// lessons. Every frame's bitmap marks the cells that differ from the
+// previous version, so a reader that keeps up only touches the bitmap and
+// the cells it has to repaint.
+//
+// Frames are guarded by a per-frame seqlock stamp: it is odd while the
+// writer fills the frame and 2 * version once the frame is complete.
+
+static const uint16_t kNoLesson = 0xffff;
+
+struct ResultChannelHeader {
+  char     magic[4];
+  uint32_t format;
+  uint32_t days;
+  uint32_t periodsPerDay;
+  uint32_t numClasses;
+  uint32_t capacity;
+  uint32_t frameSize;
+  uint32_t cellCount;
+  uint64_t version; // Latest complete frame, 0 before the first publish
+  uint8_t  reserved[24];
+};
+
+struct ResultFrameHeader {
+  uint64_t stamp;
+  uint32_t changedCells;
+  uint32_t numLessons;
+  uint8_t  reserved[48];
+};
+
+struct ResultCellUpdate {
+  int classId = 0;
+  int day     = 0;
+  int period  = 0;
+  int lesson  = -1; // -1 when the cell became free
+};
+
+class ResultChannelWriter
+{
+public:
+  bool Create(const std::string &path, int days, int periodsPerDay,
+              int numClasses, int capacity = 8);
+  void Close();
+
+  // Publishes a snapshot and returns its version. Returns 0 and publishes
+  // nothing when two lessons share a class cell, as subgroup lessons do,
+  // when a lesson id does not fit below kNoLesson, or when an entry's day
+  // or period is outside the channel's grid.
+  uint64_t Publish(const Schedule &schedule);
+
+  uint64_t GetVersion() const { return m_Version; }
+
+private:
+  MappedFile            m_File;
+  ResultChannelHeader  *m_Header  = nullptr;
+  uint64_t              m_Version = 0;
+  std::vector<uint16_t> m_Cells;
+};
+
+class ResultChannelReader
+{
+public:
+  bool Open(const std::string &path);
+  void Close();
+
+  uint64_t GetVersion() const;
+
+  // Copies the full cell grid of a version. Fails if the frame has already
+  // been overwritten or is being written.
+  bool ReadFrame(uint64_t version, std::vector<uint16_t> &cells) const;
+
+  // Returns the cells that changed since `lastSeen` and updates it to the
+  // version the updates describe. Falls back to every occupied cell when the
+  // reader fell more than a ring behind.
+  bool ReadUpdates(uint64_t &lastSeen,
+                   std::vector<ResultCellUpdate> &updates) const;
+
+private:
+  const ResultFrameHeader *GetFrame(uint64_t version) const;
+
+  MappedFile          m_File;
+  ResultChannelHeader m_Header{};
+  size_t              m_BitmapWords = 0;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,61 @@
+#include "Schedule.hpp"
+
+#include <cassert>
+
+namespace TimetableWeaver
+{
+
+/**
+ * Schedule
+ */
+Schedule::Schedule(int days, int periodsPerDay, int numClasses,
+                   int numTeachers)
+    : m_Days(days), m_PeriodsPerDay(periodsPerDay), m_NumClasses(numClasses),
+      m_NumTeachers(numTeachers)
+{
+  assert(days >= 1 && days <= 7);
+  assert(periodsPerDay >= 1 && periodsPerDay <= 32);
+}
+
+void Schedule::Add(const ScheduledLesson &entry)
+{
+  assert(entry.day >= 0 && entry.day < m_Days);
+  assert(entry.period >= 0 && entry.period < m_PeriodsPerDay);
+  assert(entry.classId >= 0 && entry.classId < m_NumClasses);
+  assert(entry.teacherId >= 0 && entry.teacherId < m_NumTeachers);
+
+  m_Entries.push_back(entry);
+}
+
+std::vector<ScheduledLesson> Schedule::GetClassLessons(int classId) const
+{
+  std::vector<ScheduledLesson> result;
+  for (const auto &entry : m_Entries) {
+    if (entry.classId == classId) {
+      result.push_back(entry);
+    }
+  }
+  return result;
+}
+
+std::vector<ScheduledLesson> Schedule::GetTeacherLessons(int teacherId) const
+{
+  std::vector<ScheduledLesson> result;
+  for (const auto &entry : m_Entries) {
+    if (entry.teacherId == teacherId) {
+      result.push_back(entry);
+    }
+  }
+  return result;
+}
+
+void Schedule::Print(std::ostream &stream) const
+{
+  for (const auto &entry : m_Entries) {
+    stream << "Lesson " << entry.lesson << " (class " << entry.classId
+           << ", teacher " << entry.teacherId << ", subject "
+           << entry.subjectId << ") at Day " << entry.day << ", Period "
+           << entry.period << "\n";
+  }
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <iostream>
+
+namespace TimetableWeaver
+{
+// A single placed lesson. Entity ids are indices into the vectors of the
+// TimetableConfig the schedule was generated from.
+struct ScheduledLesson {
+  int lesson    = 0;
+  int classId   = 0;
+  int teacherId = 0;
+  int subjectId = 0;
+  int day       = 0;
+  int period    = 0;
+};
+
+class Schedule
+{
+public:
+  Schedule() = default;
+  Schedule(int days, int periodsPerDay, int numClasses, int numTeachers);
+
+  void Add(const ScheduledLesson &entry);
+  void Clear() { m_Entries.clear(); }
+
+  int GetDays() const { return m_Days; }
+  int GetPeriodsPerDay() const { return m_PeriodsPerDay; }
+  int GetNumClasses() const { return m_NumClasses; }
+  int GetNumTeachers() const { return m_NumTeachers; }
+
+  const std::vector<ScheduledLesson> &GetEntries() const { return m_Entries; }
+
+  std::vector<ScheduledLesson> GetClassLessons(int classId) const;
+  std::vector<ScheduledLesson> GetTeacherLessons(int teacherId) const;
+
+  void Print(std::ostream &stream) const;
+
+private:
+  int m_Days          = 0;
+  int m_PeriodsPerDay = 0;
+  int m_NumClasses    = 0;
+  int m_NumTeachers   = 0;
+
+  std::vector<ScheduledLesson> m_Entries;
+};
+}; // namespace TimetableWeaver
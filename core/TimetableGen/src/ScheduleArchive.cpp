@@ -0,0 +1,499 @@
+#include "ScheduleArchive.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace TimetableWeaver
+{
+static const char     kArchiveMagic[4] = {'T', 'W', 'A', 'R'};
+static const char     kTrailerMagic[4] = {'T', 'W', 'I', 'X'};
+static const uint32_t kArchiveFormat   = 2;
+
+// Week shapes a Schedule can hold.
+static const uint32_t kMaxDays          = 7;
+static const uint32_t kMaxPeriodsPerDay = 32;
+
+static_assert(sizeof(ArchiveTrailer) == 48, "trailer must be 48 bytes");
+
+static uint32_t GetChecksum(const ArchiveTrailer &trailer)
+{
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&trailer);
+  uint32_t       hash  = 2166136261u;
+  for (size_t i = 0; i < offsetof(ArchiveTrailer, checksum); ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+template <typename T>
+static bool ReadStruct(const MappedFile &file, uint64_t offset, T &out)
+{
+  if (offset > file.GetSize() || file.GetSize() - offset < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&out, file.GetData() + offset, sizeof(T));
+  return true;
+}
+
+static void PutVarint(std::vector<uint8_t> &buffer, uint32_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static bool GetVarint(const uint8_t *&cursor, const uint8_t *end,
+                      uint32_t &value)
+{
+  value     = 0;
+  int shift = 0;
+  while (cursor < end && shift < 35) {
+    uint8_t byte = *cursor++;
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+    shift += 7;
+  }
+  return false;
+}
+
+// Record layout: count, then per lesson (slot delta, lesson, other entity,
+// subject), sorted by slot. "Other entity" is the teacher of a class record
+// and the class of a teacher record.
+static std::vector<uint8_t> EncodeRecord(std::vector<ScheduledLesson> lessons,
+                                         ArchiveEntity kind, int periodsPerDay)
+{
+  std::sort(lessons.begin(), lessons.end(),
+            [](const ScheduledLesson &a, const ScheduledLesson &b) {
+              if (a.day != b.day) {
+                return a.day < b.day;
+              }
+              if (a.period != b.period) {
+                return a.period < b.period;
+              }
+              return a.lesson < b.lesson;
+            });
+
+  std::vector<uint8_t> buffer;
+  PutVarint(buffer, static_cast<uint32_t>(lessons.size()));
+
+  uint32_t prevSlot = 0;
+  for (const auto &entry : lessons) {
+    uint32_t slot  = static_cast<uint32_t>(entry.day * periodsPerDay +
+                                          entry.period);
+    int      other = kind == ArchiveEntity::Class ? entry.teacherId
+                                                  : entry.classId;
+    PutVarint(buffer, slot - prevSlot);
+    PutVarint(buffer, static_cast<uint32_t>(entry.lesson));
+    PutVarint(buffer, static_cast<uint32_t>(other));
+    PutVarint(buffer, static_cast<uint32_t>(entry.subjectId));
+    prevSlot = slot;
+  }
+  return buffer;
+}
+
+/**
+ * ScheduleArchiveReader
+ */
+bool ScheduleArchiveReader::Open(const std::string &path)
+{
+  Close();
+  if (!m_File.Open(path)) {
+    return false;
+  }
+
+  if (!ReadStruct(m_File, 0, m_Header) ||
+      std::memcmp(m_Header.magic, kArchiveMagic, 4) != 0 ||
+      m_Header.format != kArchiveFormat) {
+    Close();
+    return false;
+  }
+  if (m_Header.days == 0 || m_Header.days > kMaxDays ||
+      m_Header.periodsPerDay == 0 ||
+      m_Header.periodsPerDay > kMaxPeriodsPerDay) {
+    std::cerr << "Archive " << path << " has an invalid week of "
+              << m_Header.days << " x " << m_Header.periodsPerDay
+              << " periods\n";
+    Close();
+    return false;
+  }
+
+  // The last valid trailer ends the archive; anything after it is the tail
+  // of an append that never finished. Without one there are no versions.
+  const uint64_t size = m_File.GetSize();
+  uint64_t offset     = size - std::min<uint64_t>(size, sizeof(ArchiveTrailer));
+  m_ValidSize         = sizeof(ArchiveHeader);
+  for (; offset >= sizeof(ArchiveHeader); --offset) {
+    if (LoadChain(offset)) {
+      m_ValidSize = offset + sizeof(ArchiveTrailer);
+      break;
+    }
+  }
+  return true;
+}
+
+void ScheduleArchiveReader::Close()
+{
+  m_File.Close();
+  m_Header = ArchiveHeader{};
+  m_Versions.clear();
+  m_LastTrailer = 0;
+  m_ValidSize   = 0;
+}
+
+bool ScheduleArchiveReader::ReadTrailer(uint64_t        offset,
+                                        ArchiveTrailer &trailer) const
+{
+  return ReadStruct(m_File, offset, trailer) &&
+         std::memcmp(trailer.magic, kTrailerMagic, 4) == 0 &&
+         trailer.checksum == GetChecksum(trailer) &&
+         trailer.entry.directoryOffset <= offset &&
+         offset - trailer.entry.directoryOffset ==
+             (uint64_t(trailer.entry.numClasses) + trailer.entry.numTeachers) *
+                 sizeof(ArchiveRecordRef);
+}
+
+// Walks the trailers back from `offset` and keeps their versions when the
+// chain is whole.
+bool ScheduleArchiveReader::LoadChain(uint64_t offset)
+{
+  // Every version before this one needs a trailer of its own.
+  ArchiveTrailer trailer;
+  if (!ReadTrailer(offset, trailer) ||
+      trailer.version > offset / sizeof(ArchiveTrailer)) {
+    return false;
+  }
+
+  std::vector<ArchiveVersion> versions(uint64_t(trailer.version) + 1);
+  const uint64_t              last = offset;
+  for (uint32_t v = trailer.version;; --v) {
+    versions[v] = trailer.entry;
+    if (v == 0) {
+      if (trailer.previousOffset != 0) {
+        return false;
+      }
+      break;
+    }
+    // Trailers only point backwards, past the directory they close.
+    const uint64_t previous = trailer.previousOffset;
+    if (previous < sizeof(ArchiveHeader) ||
+        previous + sizeof(ArchiveTrailer) > trailer.entry.directoryOffset ||
+        !ReadTrailer(previous, trailer) || trailer.version != v - 1) {
+      return false;
+    }
+  }
+
+  m_Versions    = std::move(versions);
+  m_LastTrailer = last;
+  return true;
+}
+
+bool ScheduleArchiveReader::GetVersion(int version, ArchiveVersion &out) const
+{
+  if (version < 0 || static_cast<size_t>(version) >= m_Versions.size()) {
+    return false;
+  }
+  out = m_Versions[version];
+  return true;
+}
+
+bool ScheduleArchiveReader::GetRecord(int version, ArchiveEntity kind, int id,
+                                      ArchiveRecordRef &ref) const
+{
+  ArchiveVersion entry;
+  if (!GetVersion(version, entry)) {
+    return false;
+  }
+
+  uint32_t count =
+      kind == ArchiveEntity::Class ? entry.numClasses : entry.numTeachers;
+  if (id < 0 || static_cast<uint32_t>(id) >= count) {
+    return false;
+  }
+
+  uint64_t index = kind == ArchiveEntity::Class ? id : entry.numClasses + id;
+  return ReadStruct(m_File,
+                    entry.directoryOffset + index * sizeof(ArchiveRecordRef),
+                    ref);
+}
+
+bool ScheduleArchiveReader::DecodeRecord(
+    const ArchiveRecordRef &ref, ArchiveEntity kind, int id,
+    std::vector<ScheduledLesson> &out) const
+{
+  if (ref.offset > m_File.GetSize() ||
+      m_File.GetSize() - ref.offset < ref.length) {
+    return false;
+  }
+
+  const uint8_t *cursor        = m_File.GetData() + ref.offset;
+  const uint8_t *end           = cursor + ref.length;
+  const int      periodsPerDay = GetPeriodsPerDay();
+
+  uint32_t count;
+  if (!GetVarint(cursor, end, count)) {
+    return false;
+  }
+
+  uint32_t slot = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t delta, lesson, other, subject;
+    if (!GetVarint(cursor, end, delta) || !GetVarint(cursor, end, lesson) ||
+        !GetVarint(cursor, end, other) || !GetVarint(cursor, end, subject)) {
+      return false;
+    }
+    slot += delta;
+
+    const bool isClass = kind == ArchiveEntity::Class;
+
+    ScheduledLesson entry;
+    entry.lesson    = static_cast<int>(lesson);
+    entry.classId   = isClass ? id : static_cast<int>(other);
+    entry.teacherId = isClass ? static_cast<int>(other) : id;
+    entry.subjectId = static_cast<int>(subject);
+    entry.day       = static_cast<int>(slot) / periodsPerDay;
+    entry.period    = static_cast<int>(slot) % periodsPerDay;
+    out.push_back(entry);
+  }
+  return true;
+}
+
+bool ScheduleArchiveReader::GetClassLessons(
+    int version, int classId, std::vector<ScheduledLesson> &out) const
+{
+  ArchiveRecordRef ref;
+  out.clear();
+  return GetRecord(version, ArchiveEntity::Class, classId, ref) &&
+         DecodeRecord(ref, ArchiveEntity::Class, classId, out);
+}
+
+bool ScheduleArchiveReader::GetTeacherLessons(
+    int version, int teacherId, std::vector<ScheduledLesson> &out) const
+{
+  ArchiveRecordRef ref;
+  out.clear();
+  return GetRecord(version, ArchiveEntity::Teacher, teacherId, ref) &&
+         DecodeRecord(ref, ArchiveEntity::Teacher, teacherId, out);
+}
+
+bool ScheduleArchiveReader::GetSchedule(int version, Schedule &out) const
+{
+  ArchiveVersion entry;
+  if (!GetVersion(version, entry)) {
+    return false;
+  }
+
+  out = Schedule(GetDays(), GetPeriodsPerDay(),
+                 static_cast<int>(entry.numClasses),
+                 static_cast<int>(entry.numTeachers));
+
+  std::vector<ScheduledLesson> lessons;
+  for (uint32_t c = 0; c < entry.numClasses; ++c) {
+    if (!GetClassLessons(version, static_cast<int>(c), lessons)) {
+      return false;
+    }
+    for (const auto &lesson : lessons) {
+      out.Add(lesson);
+    }
+  }
+  return true;
+}
+
+/**
+ * ScheduleArchiveWriter
+ */
+bool ScheduleArchiveWriter::Open(const std::string &path, int days,
+                                 int periodsPerDay)
+{
+  Close();
+  m_Days          = days;
+  m_PeriodsPerDay = periodsPerDay;
+
+  ScheduleArchiveReader reader;
+  if (reader.Open(path)) {
+    if (reader.GetDays() != days ||
+        reader.GetPeriodsPerDay() != periodsPerDay) {
+      std::cerr << "Archive " << path << " has a different week shape\n";
+      return false;
+    }
+
+    m_FileSize     = reader.m_ValidSize;
+    m_VersionCount = static_cast<uint32_t>(reader.GetVersionCount());
+    m_LastTrailer  = reader.m_LastTrailer;
+
+    const uint64_t size = reader.m_File.GetSize();
+
+    // Keep the latest version around so the next append can share records.
+    if (m_VersionCount > 0) {
+      const int             last      = reader.GetVersionCount() - 1;
+      const ArchiveVersion &entry     = reader.m_Versions.back();
+      const uint32_t        counts[2] = {entry.numClasses, entry.numTeachers};
+      const ArchiveEntity   kinds[2]  = {ArchiveEntity::Class,
+                                         ArchiveEntity::Teacher};
+      for (int k = 0; k < 2; ++k) {
+        for (uint32_t id = 0; id < counts[k]; ++id) {
+          ArchiveRecordRef ref;
+          if (!reader.GetRecord(last, kinds[k], static_cast<int>(id), ref) ||
+              ref.offset + ref.length > m_FileSize) {
+            return false;
+          }
+          const uint8_t *data = reader.m_File.GetData() + ref.offset;
+          m_PrevRefs[k].push_back(ref);
+          m_PrevRecords[k].emplace_back(data, data + ref.length);
+        }
+      }
+    }
+    reader.Close();
+
+    if (size > m_FileSize) {
+      std::cerr << "Archive " << path << ": dropping " << size - m_FileSize
+                << " bytes of an unfinished append\n";
+      std::error_code error;
+      std::filesystem::resize_file(path, m_FileSize, error);
+      if (error) {
+        std::cerr << "Could not truncate " << path << ": " << error.message()
+                  << "\n";
+        return false;
+      }
+    }
+
+    m_Stream.open(path, std::ios::binary | std::ios::app);
+    return m_Stream.good();
+  }
+
+  // Never truncate something that exists but failed to parse.
+  if (std::ifstream(path).good()) {
+    std::cerr << "Archive " << path << " is corrupt or unreadable\n";
+    return false;
+  }
+
+  m_Stream.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_Stream.good()) {
+    return false;
+  }
+
+  ArchiveHeader header;
+  std::memcpy(header.magic, kArchiveMagic, 4);
+  header.format        = kArchiveFormat;
+  header.days          = static_cast<uint32_t>(days);
+  header.periodsPerDay = static_cast<uint32_t>(periodsPerDay);
+  if (!Write(&header, sizeof(header))) {
+    return false;
+  }
+  m_Stream.flush();
+  return m_Stream.good();
+}
+
+void ScheduleArchiveWriter::Close()
+{
+  if (m_Stream.is_open()) {
+    m_Stream.close();
+  }
+  m_FileSize     = 0;
+  m_VersionCount = 0;
+  m_LastTrailer  = 0;
+  for (int k = 0; k < 2; ++k) {
+    m_PrevRefs[k].clear();
+    m_PrevRecords[k].clear();
+  }
+}
+
+bool ScheduleArchiveWriter::Write(const void *data, size_t size)
+{
+  m_Stream.write(static_cast<const char *>(data),
+                 static_cast<std::streamsize>(size));
+  m_FileSize += size;
+  return m_Stream.good();
+}
+
+int ScheduleArchiveWriter::Append(const Schedule &schedule)
+{
+  assert(m_Stream.is_open());
+  if (schedule.GetDays() != m_Days ||
+      schedule.GetPeriodsPerDay() != m_PeriodsPerDay) {
+    std::cerr << "Schedule does not match the archive week shape\n";
+    return -1;
+  }
+
+  const uint32_t version   = m_VersionCount;
+  const int      counts[2] = {schedule.GetNumClasses(),
+                              schedule.GetNumTeachers()};
+
+  // Bucket lessons per entity before encoding.
+  std::vector<std::vector<ScheduledLesson>> buckets[2];
+  buckets[0].resize(counts[0]);
+  buckets[1].resize(counts[1]);
+  for (const auto &entry : schedule.GetEntries()) {
+    buckets[0][entry.classId].push_back(entry);
+    buckets[1][entry.teacherId].push_back(entry);
+  }
+
+  std::vector<ArchiveRecordRef>     refs[2];
+  std::vector<std::vector<uint8_t>> records[2];
+  for (int k = 0; k < 2; ++k) {
+    const ArchiveEntity kind =
+        k == 0 ? ArchiveEntity::Class : ArchiveEntity::Teacher;
+    for (int id = 0; id < counts[k]; ++id) {
+      std::vector<uint8_t> record =
+          EncodeRecord(buckets[k][id], kind, m_PeriodsPerDay);
+
+      ArchiveRecordRef ref;
+      if (static_cast<size_t>(id) < m_PrevRecords[k].size() &&
+          m_PrevRecords[k][id] == record) {
+        ref = m_PrevRefs[k][id];
+      } else {
+        ref.offset  = m_FileSize;
+        ref.length  = static_cast<uint32_t>(record.size());
+        ref.version = version;
+        if (!Write(record.data(), record.size())) {
+          return -1;
+        }
+      }
+      refs[k].push_back(ref);
+      records[k].push_back(std::move(record));
+    }
+  }
+
+  ArchiveVersion entry;
+  entry.directoryOffset = m_FileSize;
+  entry.numClasses      = static_cast<uint32_t>(counts[0]);
+  entry.numTeachers     = static_cast<uint32_t>(counts[1]);
+  entry.numEntries      = static_cast<uint32_t>(schedule.GetEntries().size());
+  entry.reserved        = 0;
+  for (int k = 0; k < 2; ++k) {
+    if (!Write(refs[k].data(), refs[k].size() * sizeof(ArchiveRecordRef))) {
+      return -1;
+    }
+  }
+
+  ArchiveTrailer trailer{};
+  std::memcpy(trailer.magic, kTrailerMagic, 4);
+  trailer.version        = version;
+  trailer.previousOffset = m_LastTrailer;
+  trailer.entry          = entry;
+  trailer.checksum       = GetChecksum(trailer);
+  const uint64_t offset  = m_FileSize;
+  if (!Write(&trailer, sizeof(trailer))) {
+    return -1;
+  }
+  m_Stream.flush();
+  if (!m_Stream.good()) {
+    return -1;
+  }
+
+  m_VersionCount = version + 1;
+  m_LastTrailer  = offset;
+  for (int k = 0; k < 2; ++k) {
+    m_PrevRefs[k]    = std::move(refs[k]);
+    m_PrevRecords[k] = std::move(records[k]);
+  }
+  return static_cast<int>(version);
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "Schedule.hpp"
+
+namespace TimetableWeaver
+{
+// Append-only archive holding every published version of a school's
+// schedule.
+//
+// File layout (little-endian):
+//   ArchiveHeader
+//   per appended version:
+//     entity records that changed since the previous version
+//     entity directory: one ArchiveRecordRef per class, then per teacher
+//     ArchiveTrailer, pointing back at the previous version's trailer
+//
+// An append never rewrites existing bytes. Entities whose lessons did not
+// change point back at the record written by an earlier version, and each
+// record is a varint stream of slot deltas, so a version costs bytes
+// proportional to what changed plus its directory. Readers walk the
+// trailer chain once on open; fetching one entity of one version then
+// touches one directory entry and the record itself.
+//
+// Trailers carry a checksum. A crash in the middle of an append leaves a
+// tail without a valid trailer, which readers ignore and the writer cuts
+// off before appending again.
+
+struct ArchiveHeader {
+  char     magic[4];
+  uint32_t format;
+  uint32_t days;
+  uint32_t periodsPerDay;
+};
+
+struct ArchiveRecordRef {
+  uint64_t offset;
+  uint32_t length;
+  uint32_t version; // Version that first wrote the record
+};
+
+struct ArchiveVersion {
+  uint64_t directoryOffset;
+  uint32_t numClasses;
+  uint32_t numTeachers;
+  uint32_t numEntries;
+  uint32_t reserved;
+};
+
+struct ArchiveTrailer {
+  char           magic[4];
+  uint32_t       version;
+  uint64_t       previousOffset; // Trailer of the version before, 0 if none
+  ArchiveVersion entry;
+  uint32_t       checksum; // FNV-1a of the bytes before it
+  uint32_t       reserved;
+};
+
+enum class ArchiveEntity { Class, Teacher };
+
+class ScheduleArchiveReader
+{
+public:
+  bool Open(const std::string &path);
+  void Close();
+
+  int GetVersionCount() const { return static_cast<int>(m_Versions.size()); }
+  int GetDays() const { return static_cast<int>(m_Header.days); }
+  int GetPeriodsPerDay() const
+  {
+    return static_cast<int>(m_Header.periodsPerDay);
+  }
+
+  bool GetClassLessons(int version, int classId,
+                       std::vector<ScheduledLesson> &out) const;
+  bool GetTeacherLessons(int version, int teacherId,
+                         std::vector<ScheduledLesson> &out) const;
+
+  // Rebuilds the full schedule of a version from its class records.
+  bool GetSchedule(int version, Schedule &out) const;
+
+private:
+  friend class ScheduleArchiveWriter;
+
+  bool ReadTrailer(uint64_t offset, ArchiveTrailer &trailer) const;
+  bool LoadChain(uint64_t offset);
+  bool GetVersion(int version, ArchiveVersion &out) const;
+  bool GetRecord(int version, ArchiveEntity kind, int id,
+                 ArchiveRecordRef &ref) const;
+  bool DecodeRecord(const ArchiveRecordRef &ref, ArchiveEntity kind, int id,
+                    std::vector<ScheduledLesson> &out) const;
+
+  MappedFile                  m_File;
+  ArchiveHeader               m_Header{};
+  std::vector<ArchiveVersion> m_Versions;
+  uint64_t                    m_LastTrailer = 0; // 0 without versions
+  uint64_t                    m_ValidSize   = 0; // Up to the last trailer
+};
+
+class ScheduleArchiveWriter
+{
+public:
+  // Creates the archive if it does not exist yet, otherwise checks that it
+  // matches the given week shape and continues after its last complete
+  // version, dropping the tail of an interrupted append.
+  bool Open(const std::string &path, int days, int periodsPerDay);
+  void Close();
+
+  // Returns the version number assigned to the schedule, or -1 on failure.
+  int Append(const Schedule &schedule);
+
+  int GetVersionCount() const { return static_cast<int>(m_VersionCount); }
+
+private:
+  bool Write(const void *data, size_t size);
+
+  std::ofstream m_Stream;
+  uint64_t      m_FileSize      = 0;
+  int           m_Days          = 0;
+  int           m_PeriodsPerDay = 0;
+  uint32_t      m_VersionCount  = 0;
+  uint64_t      m_LastTrailer   = 0;
+
+  // Directory and encoded records of the latest version, used to share
+  // unchanged records with the next one.
+  std::vector<ArchiveRecordRef>     m_PrevRefs[2];
+  std::vector<std::vector<uint8_t>> m_PrevRecords[2];
+};
+}; // namespace TimetableWeaver
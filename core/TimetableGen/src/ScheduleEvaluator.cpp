@@ -0,0 +1,229 @@
+#include "ScheduleEvaluator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+// Periods of a subject beyond the first on the same day.
+static inline int ClusterCount(uint32_t mask)
+{
+  int count = PopCount(mask);
+  return count > 1 ? count - 1 : 0;
+}
+
+static inline int64_t Square(int value)
+{
+  return static_cast<int64_t>(value) * value;
+}
+
+/**
+ * ScheduleEvaluator
+ */
+ScheduleEvaluator::ScheduleEvaluator(const Schedule     &schedule,
+                                     const ScoreWeights &weights)
+    : m_Weights(weights), m_Days(schedule.GetDays()),
+      m_NumClasses(schedule.GetNumClasses()),
+      m_NumTeachers(schedule.GetNumTeachers()),
+      m_Entries(schedule.GetEntries())
+{
+  for (const auto &entry : m_Entries) {
+    m_NumSubjects = std::max(m_NumSubjects, entry.subjectId + 1);
+  }
+
+  m_TeacherMasks.assign(m_NumTeachers * m_Days, 0);
+  m_ClassMasks.assign(m_NumClasses * m_Days, 0);
+  m_SubjectMasks.assign(m_NumClasses * m_NumSubjects * m_Days, 0);
+  m_PreferenceMasks.assign(m_NumTeachers * m_Days, 0xffffffffu);
+  m_ClassCounts.assign(m_ClassMasks.size() * 32, 0);
+  m_SubjectCounts.assign(m_SubjectMasks.size() * 32, 0);
+
+  for (const auto &entry : m_Entries) {
+    const uint32_t bit = uint32_t(1) << entry.period;
+    TeacherMask(entry.teacherId, entry.day) |= bit;
+    ClassMask(entry.classId, entry.day) |= bit;
+    ++ClassCount(entry.classId, entry.day, entry.period);
+    if (entry.subjectId >= 0) {
+      SubjectMask(entry.classId, entry.subjectId, entry.day) |= bit;
+      ++SubjectCount(entry.classId, entry.subjectId, entry.day, entry.period);
+    }
+  }
+
+  m_Score = Total(Evaluate());
+}
+
+void ScheduleEvaluator::SetTeacherPreference(
+    int teacherId, const std::vector<uint32_t> &days)
+{
+  assert(teacherId >= 0 && teacherId < m_NumTeachers);
+  for (int d = 0; d < m_Days; ++d) {
+    m_PreferenceMasks[teacherId * m_Days + d] =
+        d < static_cast<int>(days.size()) ? days[d] : 0xffffffffu;
+  }
+  m_Score = Total(Evaluate());
+}
+
+int64_t ScheduleEvaluator::Total(const ScoreBreakdown &score) const
+{
+  return m_Weights.teacherGap * score.teacherGaps +
+         m_Weights.subjectCluster * score.subjectClusters +
+         m_Weights.loadVariance * score.loadVariance +
+         m_Weights.preference * score.preference;
+}
+
+ScoreBreakdown ScheduleEvaluator::Evaluate() const
+{
+  ScoreBreakdown score;
+
+  // Each kernel is a flat pass over the masks of one resource kind.
+  for (size_t i = 0; i < m_TeacherMasks.size(); ++i) {
+    score.teacherGaps += GapCount(m_TeacherMasks[i]);
+    score.preference += PopCount(m_TeacherMasks[i] & ~m_PreferenceMasks[i]);
+  }
+  for (uint32_t mask : m_SubjectMasks) {
+    score.subjectClusters += ClusterCount(mask);
+  }
+
+  auto variance = [this](const std::vector<uint32_t> &masks, int count) {
+    int64_t result = 0;
+    for (int r = 0; r < count; ++r) {
+      int64_t sum = 0, squares = 0;
+      for (int d = 0; d < m_Days; ++d) {
+        int load = PopCount(masks[r * m_Days + d]);
+        sum += load;
+        squares += Square(load);
+      }
+      result += m_Days * squares - sum * sum;
+    }
+    return result;
+  };
+  score.loadVariance = variance(m_TeacherMasks, m_NumTeachers) +
+                       variance(m_ClassMasks, m_NumClasses);
+
+  score.total = Total(score);
+  return score;
+}
+
+bool ScheduleEvaluator::IsMoveFeasible(int entry, int day, int period) const
+{
+  const ScheduledLesson &lesson = m_Entries[entry];
+  if (lesson.day == day && lesson.period == period) {
+    return true;
+  }
+  const uint32_t bit = uint32_t(1) << period;
+  return (m_TeacherMasks[lesson.teacherId * m_Days + day] & bit) == 0 &&
+         (m_ClassMasks[lesson.classId * m_Days + day] & bit) == 0;
+}
+
+int64_t ScheduleEvaluator::DeltaMove(int entry, int day, int period) const
+{
+  assert(entry >= 0 && entry < static_cast<int>(m_Entries.size()));
+
+  const ScheduledLesson &lesson     = m_Entries[entry];
+  const int              d0         = lesson.day;
+  const int              d1         = day;
+  const uint32_t         bit0       = uint32_t(1) << lesson.period;
+  const uint32_t         bit1       = uint32_t(1) << period;
+  const bool             hasSubject = lesson.subjectId >= 0;
+
+  const int t = lesson.teacherId;
+  const int c = lesson.classId;
+  if (d0 == d1 && bit0 == bit1) {
+    return 0;
+  }
+
+  // Masks of the (at most two) touched days, before and after the move.
+  uint32_t teacher[2] = {m_TeacherMasks[t * m_Days + d0],
+                         m_TeacherMasks[t * m_Days + d1]};
+  uint32_t cls[2]     = {m_ClassMasks[c * m_Days + d0],
+                         m_ClassMasks[c * m_Days + d1]};
+  uint32_t subject[2]   = {0, 0};
+  bool     sharedSubject = false;
+  if (hasSubject) {
+    const int base = (c * m_NumSubjects + lesson.subjectId) * m_Days;
+    subject[0]     = m_SubjectMasks[base + d0];
+    subject[1]     = m_SubjectMasks[base + d1];
+    sharedSubject  = m_SubjectCounts[(base + d0) * 32 + lesson.period] > 1;
+  }
+
+  // Another subgroup lesson at the old slot keeps its bit set.
+  const int  classBit  = (c * m_Days + d0) * 32 + lesson.period;
+  const bool shared[3] = {false, m_ClassCounts[classBit] > 1, sharedSubject};
+
+  auto cost = [&](const uint32_t *tm, const uint32_t *cm, const uint32_t *sm) {
+    const int days = d0 == d1 ? 1 : 2;
+    int64_t   gaps = 0, clusters = 0, squares = 0;
+    for (int i = 0; i < days; ++i) {
+      gaps += GapCount(tm[i]);
+      clusters += ClusterCount(sm[i]);
+      squares += Square(PopCount(tm[i])) + Square(PopCount(cm[i]));
+    }
+    // The weekly load sum is unchanged by a move unless the class keeps
+    // its old slot, handled below, so only the squares count here.
+    return m_Weights.teacherGap * gaps + m_Weights.subjectCluster * clusters +
+           m_Weights.loadVariance * m_Days * squares;
+  };
+
+  int64_t before = cost(teacher, cls, subject);
+
+  uint32_t *after[3] = {teacher, cls, subject};
+  for (int k = 0; k < 3; ++k) {
+    if (after[k] == subject && !hasSubject) {
+      continue;
+    }
+    if (!shared[k]) {
+      after[k][0] &= ~bit0;
+    }
+    after[k][d0 == d1 ? 0 : 1] |= bit1;
+  }
+
+  int64_t delta = cost(teacher, cls, subject) - before;
+  if (shared[1]) {
+    // The class gains a busy period, so its weekly load sum S grows by one
+    // and the variance loses (S + 1)^2 - S^2.
+    int64_t sum = 0;
+    for (int d = 0; d < m_Days; ++d) {
+      sum += PopCount(m_ClassMasks[c * m_Days + d]);
+    }
+    delta -= m_Weights.loadVariance * (2 * sum + 1);
+  }
+
+  const uint32_t pref0 = m_PreferenceMasks[t * m_Days + d0];
+  const uint32_t pref1 = m_PreferenceMasks[t * m_Days + d1];
+  delta += m_Weights.preference *
+           (((pref1 & bit1) == 0 ? 1 : 0) - ((pref0 & bit0) == 0 ? 1 : 0));
+  return delta;
+}
+
+void ScheduleEvaluator::ApplyMove(int entry, int day, int period)
+{
+  m_Score += DeltaMove(entry, day, period);
+
+  ScheduledLesson &lesson = m_Entries[entry];
+  const uint32_t   bit0   = uint32_t(1) << lesson.period;
+  const uint32_t   bit1   = uint32_t(1) << period;
+
+  const int        c      = lesson.classId;
+  const int        s      = lesson.subjectId;
+
+  TeacherMask(lesson.teacherId, lesson.day) &= ~bit0;
+  TeacherMask(lesson.teacherId, day) |= bit1;
+  if (--ClassCount(c, lesson.day, lesson.period) == 0) {
+    ClassMask(c, lesson.day) &= ~bit0;
+  }
+  ++ClassCount(c, day, period);
+  ClassMask(c, day) |= bit1;
+  if (s >= 0) {
+    if (--SubjectCount(c, s, lesson.day, lesson.period) == 0) {
+      SubjectMask(c, s, lesson.day) &= ~bit0;
+    }
+    ++SubjectCount(c, s, day, period);
+    SubjectMask(c, s, day) |= bit1;
+  }
+
+  lesson.day    = day;
+  lesson.period = period;
+}
+}; // namespace TimetableWeaver
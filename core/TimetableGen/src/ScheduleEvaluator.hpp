@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Schedule.hpp"
+
+namespace TimetableWeaver
+{
+struct ScoreWeights {
+  int teacherGap     = 3; // Per free period between two busy ones
+  int subjectCluster = 2; // Per extra period of a subject on the same day
+  int loadVariance   = 1; // Per unit of days * sum of squared daily loads
+  int preference     = 1; // Per lesson outside the teacher's preferred slots
+};
+
+struct ScoreBreakdown {
+  int64_t teacherGaps     = 0;
+  int64_t subjectClusters = 0;
+  int64_t loadVariance    = 0;
+  int64_t preference      = 0;
+  int64_t total           = 0;
+};
+
+// Soft-penalty score of a schedule; lower is better.
+//
+// The schedule is kept as one uint32 period mask per (resource, day), so
+// every penalty is a handful of bit operations per mask: gaps are the
+// zero bits between the lowest and highest set bit, clustering and load
+// come from popcounts. Daily load variance is kept in the integer form
+// days * sum(n^2) - (sum n)^2. Moves are scored incrementally by
+// re-evaluating only the two affected days of one class and one teacher.
+// Lessons of different subgroups may share a class slot, so class and
+// subject masks keep a lesson count per bit, and a move only clears a bit
+// when the last lesson leaves it.
+class ScheduleEvaluator
+{
+public:
+  explicit ScheduleEvaluator(const Schedule     &schedule,
+                             const ScoreWeights &weights = ScoreWeights());
+
+  // Preferred periods of a teacher, one mask per day. Lessons outside it
+  // cost `preference`. Teachers without preferences accept every slot.
+  void SetTeacherPreference(int teacherId, const std::vector<uint32_t> &days);
+
+  ScoreBreakdown Evaluate() const;
+  int64_t        GetScore() const { return m_Score; }
+
+  // True when the entry's class and teacher are both free at the slot. A
+  // slot held by another subgroup of the class counts as taken.
+  bool IsMoveFeasible(int entry, int day, int period) const;
+
+  // Score change of moving one schedule entry to a slot that passes
+  // IsMoveFeasible; the masks cannot represent double bookings.
+  int64_t DeltaMove(int entry, int day, int period) const;
+  void    ApplyMove(int entry, int day, int period);
+
+  const std::vector<ScheduledLesson> &GetEntries() const { return m_Entries; }
+
+private:
+  uint32_t &TeacherMask(int t, int d) { return m_TeacherMasks[t * m_Days + d]; }
+  uint32_t &ClassMask(int c, int d) { return m_ClassMasks[c * m_Days + d]; }
+  uint32_t &SubjectMask(int c, int s, int d)
+  {
+    return m_SubjectMasks[(c * m_NumSubjects + s) * m_Days + d];
+  }
+
+  // Lessons per bit of a class or subject mask, indexed like the masks.
+  uint8_t &ClassCount(int c, int d, int p)
+  {
+    return m_ClassCounts[(c * m_Days + d) * 32 + p];
+  }
+  uint8_t &SubjectCount(int c, int s, int d, int p)
+  {
+    return m_SubjectCounts[((c * m_NumSubjects + s) * m_Days + d) * 32 + p];
+  }
+
+  int64_t Total(const ScoreBreakdown &score) const;
+
+  ScoreWeights m_Weights;
+
+  int m_Days        = 0;
+  int m_NumClasses  = 0;
+  int m_NumTeachers = 0;
+  int m_NumSubjects = 0;
+
+  std::vector<ScheduledLesson> m_Entries;
+
+  std::vector<uint32_t> m_TeacherMasks;
+  std::vector<uint32_t> m_ClassMasks;
+  std::vector<uint32_t> m_SubjectMasks;
+  std::vector<uint32_t> m_PreferenceMasks;
+  std::vector<uint8_t>  m_ClassCounts;
+  std::vector<uint8_t>  m_SubjectCounts;
+
+  int64_t m_Score = 0;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,112 @@
+#include "SolverBackend.hpp"
+
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <limits.h>
+#include <unistd.h>
+#endif
+
+// Normally set by CMake to the file name of the OR-tools backend module.
+#ifndef TIMETABLEGEN_BACKEND_MODULE
+#ifdef _WIN32
+#define TIMETABLEGEN_BACKEND_MODULE "TimetableGenOrTools.dll"
+#else
+#define TIMETABLEGEN_BACKEND_MODULE "libTimetableGenOrTools.so"
+#endif
+#endif
+
+// Library directory relative to the executable directory, from CMake's
+// install libdir, e.g. "../lib64" on Fedora and openSUSE.
+#ifndef TIMETABLEGEN_BACKEND_LIBDIR
+#define TIMETABLEGEN_BACKEND_LIBDIR "../lib"
+#endif
+
+namespace TimetableWeaver
+{
+static std::string GetExecutableDir()
+{
+#ifdef _WIN32
+  char        buffer[MAX_PATH];
+  DWORD       length = GetModuleFileNameA(nullptr, buffer, MAX_PATH);
+  std::string path(buffer, length);
+  size_t      slash = path.find_last_of("\\/");
+#else
+  char    buffer[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+  if (length <= 0) {
+    return "";
+  }
+  std::string path(buffer, static_cast<size_t>(length));
+  size_t      slash = path.find_last_of('/');
+#endif
+  return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+static CreateSolverBackendFn OpenModule(const std::string &path)
+{
+#ifdef _WIN32
+  HMODULE module = LoadLibraryA(path.c_str());
+  if (module == nullptr) {
+    return nullptr;
+  }
+  auto factory = reinterpret_cast<CreateSolverBackendFn>(
+      GetProcAddress(module, kCreateSolverBackendSymbol));
+  if (factory == nullptr) {
+    FreeLibrary(module);
+  }
+#else
+  void *module = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (module == nullptr) {
+    return nullptr;
+  }
+  auto factory = reinterpret_cast<CreateSolverBackendFn>(
+      dlsym(module, kCreateSolverBackendSymbol));
+  if (factory == nullptr) {
+    dlclose(module);
+  }
+#endif
+  return factory;
+}
+
+std::shared_ptr<SolverBackend> LoadSolverBackend(const std::string &path)
+{
+  // Factories of modules loaded so far, keyed by the requested path.
+  static std::mutex mutex;
+  static std::vector<std::pair<std::string, CreateSolverBackendFn>> loaded;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto &[key, factory] : loaded) {
+    if (key == path) {
+      return std::shared_ptr<SolverBackend>(factory());
+    }
+  }
+
+  std::vector<std::string> candidates;
+  if (!path.empty()) {
+    candidates.push_back(path);
+  } else {
+    if (const char *env = std::getenv("TIMETABLEGEN_BACKEND")) {
+      candidates.push_back(env);
+    }
+    const std::string dir = GetExecutableDir();
+    candidates.push_back(dir + TIMETABLEGEN_BACKEND_LIBDIR "/"
+                         TIMETABLEGEN_BACKEND_MODULE);
+    candidates.push_back(dir + TIMETABLEGEN_BACKEND_MODULE);
+    candidates.push_back(TIMETABLEGEN_BACKEND_MODULE);
+  }
+
+  for (const auto &candidate : candidates) {
+    if (CreateSolverBackendFn factory = OpenModule(candidate)) {
+      loaded.emplace_back(path, factory);
+      return std::shared_ptr<SolverBackend>(factory());
+    }
+  }
+  return nullptr;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ExamConfig.hpp"
+#include "Metrics.hpp"
+#include "ModelEstimate.hpp"
+#include "Schedule.hpp"
+#include "TimetableConfig.hpp"
+#include "TraceRecorder.hpp"
+
+#ifdef _WIN32
+#define TIMETABLEGEN_BACKEND_EXPORT extern "C" __declspec(dllexport)
+#else
+#define TIMETABLEGEN_BACKEND_EXPORT                                            \
+  extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace TimetableWeaver
+{
+enum class SolveStrategy {
+  Default,       // Full portfolio search on the objective
+  FirstFeasible, // Ignore soft penalties and stop at the first schedule
+  Lns            // Neighbourhood search only, around the hint
+};
+
+// Why Solve returned; Unknown covers time limits, stop requests and
+// budget refusals.
+enum class SolveStatus { Feasible, Infeasible, Unknown };
+
+struct SolveProgress {
+  double objective = 0.0;
+  double bound     = 0.0;
+  double seconds   = 0.0; // Since the start of this Solve call
+};
+
+struct SolveOptions {
+  SolveStrategy strategy         = SolveStrategy::Default;
+  double        timeLimitSeconds = 0.0; // 0 for no limit
+
+  // Model to build; Auto lets the backend pick by size and budget.
+  Formulation formulation = Formulation::Auto;
+
+  // Schedule to start from, e.g. the incumbent of an earlier run.
+  const Schedule *hint = nullptr;
+
+  // Placements every schedule must contain. Pinning all periods of a
+  // lesson fixes it; pinning some leaves the others free.
+  std::vector<ScheduledLesson> pinned;
+
+  // Solver threads; 0 leaves the backend default, usually every core.
+  int numWorkers = 0;
+
+  // Raised by another thread to end the solve early; the best schedule
+  // found so far is still returned.
+  std::atomic<bool> *stop = nullptr;
+
+  // Called from solver threads for every improving solution and every
+  // tightening of the objective bound.
+  std::function<void(const SolveProgress &)> onSolution;
+  std::function<void(double)>                onBound;
+
+  // Called with every improving schedule, e.g. to publish it to a
+  // ResultChannelWriter. Calls come from solver threads but never overlap.
+  // Backends without intermediate schedules call it once with the result.
+  std::function<void(const Schedule &)> onSchedule;
+
+  // Set before Solve returns, when not null.
+  SolveStatus *status = nullptr;
+};
+
+// Solver behind the core library. Backends live in separately loaded
+// modules so tools that only read, validate or export schedules never load
+// a solver stack.
+class SolverBackend
+{
+public:
+  virtual ~SolverBackend() = default;
+
+  virtual const char *GetName() const = 0;
+
+  // True when one instance may run several Solve calls at once. Backends
+  // that keep search state in members must not claim it.
+  virtual bool IsReentrant() const { return false; }
+
+  // Fills `schedule` and returns true when a feasible timetable was found.
+  virtual bool Solve(const TimetableConfig &config, Schedule &schedule,
+                     const SolveOptions &options) = 0;
+
+  bool Solve(const TimetableConfig &config, Schedule &schedule)
+  {
+    return Solve(config, schedule, SolveOptions());
+  }
+
+  // Lowers the spacing penalty of a clash-free exam schedule, which also
+  // serves as the hint. Returns true when `schedule` was replaced by an
+  // equally clash-free one; its rooms and invigilators are then unset.
+  // Backends without an exam model leave it alone.
+  virtual bool RefineExams(const ExamConfig &, ExamSchedule &,
+                           const SolveOptions &)
+  {
+    return false;
+  }
+
+  // Optional timeline of solve phases and improving solutions.
+  void SetTraceRecorder(TraceRecorder *recorder) { m_Trace = recorder; }
+
+  // Optional operational metrics, e.g. time to first solution.
+  void SetMetrics(SolverMetrics *metrics) { m_Metrics = metrics; }
+
+  // Observers currently set, e.g. to restore them after borrowing the
+  // backend for a solve.
+  TraceRecorder *GetTraceRecorder() const { return m_Trace; }
+  SolverMetrics *GetMetrics() const { return m_Metrics; }
+
+protected:
+  TraceRecorder *m_Trace   = nullptr;
+  SolverMetrics *m_Metrics = nullptr;
+};
+
+// Every backend module exports this factory with C linkage.
+using CreateSolverBackendFn = SolverBackend *(*)();
+static const char *const kCreateSolverBackendSymbol =
+    "CreateTimetableSolverBackend";
+
+// Loads a backend module and creates its backend. With an empty path the
+// TIMETABLEGEN_BACKEND environment variable is tried first, then the
+// default OR-tools module next to the executable and on the loader's search
+// path. Modules stay loaded for the rest of the process. Returns nullptr
+// when no module could be loaded.
+std::shared_ptr<SolverBackend> LoadSolverBackend(const std::string &path = "");
+}; // namespace TimetableWeaver
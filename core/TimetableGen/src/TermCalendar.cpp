@@ -0,0 +1,357 @@
+#include "TermCalendar.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+// Civil date conversions after Howard Hinnant's days_from_civil algorithm.
+int ToDayNumber(const CalendarDate &date)
+{
+  const int      y   = date.month <= 2 ? date.year - 1 : date.year;
+  const int      era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy =
+      (153 * (date.month > 2 ? date.month - 3 : date.month + 9) + 2) / 5 +
+      date.day - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+CalendarDate FromDayNumber(int dayNumber)
+{
+  const int      z   = dayNumber + 719468;
+  const int      era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp  = (5 * doy + 2) / 153;
+
+  CalendarDate date;
+  date.day   = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  date.month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  date.year  = static_cast<int>(yoe) + era * 400 + (date.month <= 2);
+  return date;
+}
+
+int Weekday(int dayNumber)
+{
+  // 1970-01-01 was a Thursday.
+  int weekday = (dayNumber + 3) % 7;
+  return weekday < 0 ? weekday + 7 : weekday;
+}
+
+/**
+ * TermCalendar
+ */
+TermCalendar::TermCalendar(const Schedule &schedule, const CalendarDate &first,
+                           const CalendarDate &last)
+    : m_First(ToDayNumber(first)), m_Last(ToDayNumber(last)),
+      m_Days(schedule.GetDays())
+{
+  assert(m_First <= m_Last);
+
+  m_FirstMon = m_First - Weekday(m_First);
+
+  const int      periods  = schedule.GetPeriodsPerDay();
+  const int      numWeeks = (m_Last - m_FirstMon) / 7 + 1;
+  const uint32_t fullDay =
+      periods >= 32 ? 0xffffffffu : (uint32_t(1) << periods) - 1;
+
+  m_ClassMasks.assign(schedule.GetNumClasses(), std::vector<uint32_t>(7, 0));
+  m_TeacherMasks.assign(schedule.GetNumTeachers(),
+                        std::vector<uint32_t>(7, 0));
+  m_ClassWeekTotals.assign(schedule.GetNumClasses(), 0);
+  m_TeacherWeekTotals.assign(schedule.GetNumTeachers(), 0);
+
+  // A slot taken a second time sets its bit in the next layer of masks.
+  auto addLesson = [](std::vector<uint32_t> &masks, int day, int period) {
+    const uint32_t bit = uint32_t(1) << period;
+    size_t         k   = static_cast<size_t>(day);
+    while (k < masks.size() && (masks[k] & bit) != 0) {
+      k += 7;
+    }
+    if (k >= masks.size()) {
+      masks.resize(masks.size() + 7, 0);
+    }
+    masks[k] |= bit;
+  };
+
+  for (const auto &entry : schedule.GetEntries()) {
+    m_DayEntries[entry.day].push_back(entry);
+    addLesson(m_ClassMasks[entry.classId], entry.day, entry.period);
+    addLesson(m_TeacherMasks[entry.teacherId], entry.day, entry.period);
+    m_ClassWeekTotals[entry.classId]++;
+    m_TeacherWeekTotals[entry.teacherId]++;
+  }
+  for (auto &entries : m_DayEntries) {
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const ScheduledLesson &a, const ScheduledLesson &b) {
+                       return a.period < b.period;
+                     });
+  }
+
+  m_OpenMasks.assign(numWeeks * 7, 0);
+  m_DayKinds.assign(numWeeks * 7, CalendarDayKind::Weekend);
+  m_RegularWeeks.assign((numWeeks + 63) / 64, 0);
+  for (int dn = m_First; dn <= m_Last; ++dn) {
+    if (Weekday(dn) < m_Days) {
+      m_OpenMasks[dn - m_FirstMon] = fullDay;
+      m_DayKinds[dn - m_FirstMon]  = CalendarDayKind::Regular;
+    }
+  }
+
+  // Partial weeks at either end of the term are never regular.
+  for (int w = 0; w < numWeeks; ++w) {
+    int monday = m_FirstMon + w * 7;
+    if (monday >= m_First && monday + 6 <= m_Last) {
+      m_RegularWeeks[w / 64] |= uint64_t(1) << (w % 64);
+    }
+  }
+}
+
+void TermCalendar::CloseDates(int first, int last, CalendarDayKind kind)
+{
+  first = std::max(first, m_First);
+  last  = std::min(last, m_Last);
+  for (int dn = first; dn <= last; ++dn) {
+    if (Weekday(dn) >= m_Days) {
+      continue;
+    }
+    int index          = dn - m_FirstMon;
+    m_OpenMasks[index] = 0;
+    m_DayKinds[index]  = kind;
+    m_RegularWeeks[index / 7 / 64] &= ~(uint64_t(1) << (index / 7 % 64));
+  }
+}
+
+void TermCalendar::AddHoliday(const CalendarDate &first,
+                              const CalendarDate &last)
+{
+  CloseDates(ToDayNumber(first), ToDayNumber(last), CalendarDayKind::Holiday);
+}
+
+void TermCalendar::AddExamWeek(const CalendarDate &first,
+                               const CalendarDate &last)
+{
+  CloseDates(ToDayNumber(first), ToDayNumber(last), CalendarDayKind::ExamWeek);
+}
+
+void TermCalendar::AddClosure(const CalendarDate &date, uint32_t periodMask,
+                              int classId, int teacherId)
+{
+  int dn = ToDayNumber(date);
+  if (dn < m_First || dn > m_Last) {
+    return;
+  }
+
+  int index = dn - m_FirstMon;
+  if (classId < 0 && teacherId < 0) {
+    m_OpenMasks[index] &= ~periodMask;
+  } else {
+    m_Closures[dn].push_back({periodMask, classId, teacherId});
+  }
+  m_RegularWeeks[index / 7 / 64] &= ~(uint64_t(1) << (index / 7 % 64));
+}
+
+CalendarDayKind TermCalendar::GetDayKind(const CalendarDate &date) const
+{
+  int dn = ToDayNumber(date);
+  if (dn < m_First || dn > m_Last) {
+    return CalendarDayKind::Weekend;
+  }
+  return m_DayKinds[dn - m_FirstMon];
+}
+
+uint32_t TermCalendar::GetOpenMask(int dayNumber, int classId,
+                                   int teacherId) const
+{
+  uint32_t mask = m_OpenMasks[dayNumber - m_FirstMon];
+
+  auto it = m_Closures.find(dayNumber);
+  if (it != m_Closures.end()) {
+    for (const auto &closure : it->second) {
+      if ((closure.classId >= 0 && closure.classId == classId) ||
+          (closure.teacherId >= 0 && closure.teacherId == teacherId)) {
+        mask &= ~closure.periodMask;
+      }
+    }
+  }
+  return mask;
+}
+
+bool TermCalendar::Matches(const ScheduledLesson &lesson, int classId,
+                           int teacherId) const
+{
+  return (classId < 0 || lesson.classId == classId) &&
+         (teacherId < 0 || lesson.teacherId == teacherId);
+}
+
+int TermCalendar::CountLessons(const std::vector<uint32_t> &weekMasks,
+                               int weekTotal, int classId, int teacherId,
+                               int first, int last) const
+{
+  first = std::max(first, m_First);
+  last  = std::min(last, m_Last);
+
+  int count = 0;
+  for (int dn = first; dn <= last;) {
+    int index = dn - m_FirstMon;
+    int week  = index / 7;
+
+    // Whole regular weeks contribute their precomputed total.
+    if (index % 7 == 0 && dn + 6 <= last &&
+        (m_RegularWeeks[week / 64] >> (week % 64)) & 1) {
+      count += weekTotal;
+      dn += 7;
+      continue;
+    }
+
+    int weekday = index % 7;
+    if (weekday < m_Days && m_OpenMasks[index] != 0) {
+      if (m_Closures.count(dn) == 0) {
+        for (size_t k = weekday; k < weekMasks.size(); k += 7) {
+          count += PopCount(weekMasks[k] & m_OpenMasks[index]);
+        }
+      } else {
+        // Closures of other entities can cancel lessons too, so check the
+        // lessons one by one.
+        for (const auto &entry : m_DayEntries[weekday]) {
+          if (Matches(entry, classId, teacherId) &&
+              (GetOpenMask(dn, entry.classId, entry.teacherId) >>
+               entry.period) & 1) {
+            ++count;
+          }
+        }
+      }
+    }
+    ++dn;
+  }
+  return count;
+}
+
+int TermCalendar::CountClassLessons(int classId, const CalendarDate &first,
+                                    const CalendarDate &last) const
+{
+  if (classId < 0 || classId >= static_cast<int>(m_ClassMasks.size())) {
+    return 0;
+  }
+  return CountLessons(m_ClassMasks[classId], m_ClassWeekTotals[classId],
+                      classId, -1, ToDayNumber(first), ToDayNumber(last));
+}
+
+int TermCalendar::CountTeacherLessons(int teacherId, const CalendarDate &first,
+                                      const CalendarDate &last) const
+{
+  if (teacherId < 0 || teacherId >= static_cast<int>(m_TeacherMasks.size())) {
+    return 0;
+  }
+  return CountLessons(m_TeacherMasks[teacherId],
+                      m_TeacherWeekTotals[teacherId], -1, teacherId,
+                      ToDayNumber(first), ToDayNumber(last));
+}
+
+TermCalendar::Range TermCalendar::MakeRange(int classId, int teacherId,
+                                            const CalendarDate &first,
+                                            const CalendarDate &last) const
+{
+  int begin = std::max(ToDayNumber(first), m_First);
+  int end   = std::min(ToDayNumber(last), m_Last);
+
+  bool validClass   = classId < static_cast<int>(m_ClassMasks.size());
+  bool validTeacher = teacherId < static_cast<int>(m_TeacherMasks.size());
+  if (begin > end || !validClass || !validTeacher) {
+    begin = end + 1;
+  }
+  return Range(Iterator(this, begin, end, classId, teacherId),
+               Iterator(this, end + 1, end, classId, teacherId));
+}
+
+TermCalendar::Range TermCalendar::GetOccurrences() const
+{
+  return MakeRange(-1, -1, GetFirstDate(), GetLastDate());
+}
+
+TermCalendar::Range TermCalendar::GetOccurrences(const CalendarDate &first,
+                                                 const CalendarDate &last) const
+{
+  return MakeRange(-1, -1, first, last);
+}
+
+TermCalendar::Range
+TermCalendar::GetClassOccurrences(int classId, const CalendarDate &first,
+                                  const CalendarDate &last) const
+{
+  return MakeRange(classId, -1, first, last);
+}
+
+TermCalendar::Range
+TermCalendar::GetTeacherOccurrences(int teacherId, const CalendarDate &first,
+                                    const CalendarDate &last) const
+{
+  return MakeRange(-1, teacherId, first, last);
+}
+
+/**
+ * TermCalendar::Iterator
+ */
+TermCalendar::Iterator::Iterator(const TermCalendar *calendar, int dayNumber,
+                                 int lastDay, int classId, int teacherId)
+    : m_Calendar(calendar), m_DayNumber(dayNumber), m_LastDay(lastDay),
+      m_ClassId(classId), m_TeacherId(teacherId)
+{
+  Settle();
+}
+
+TermCalendar::Iterator &TermCalendar::Iterator::operator++()
+{
+  ++m_Index;
+  Settle();
+  return *this;
+}
+
+void TermCalendar::Iterator::Settle()
+{
+  const TermCalendar &cal = *m_Calendar;
+
+  while (m_DayNumber <= m_LastDay) {
+    int index   = m_DayNumber - cal.m_FirstMon;
+    int weekday = index % 7;
+
+    // Skip whole dates that cannot hold a matching lesson.
+    uint32_t candidates = 0;
+    if (weekday < cal.m_Days) {
+      candidates = cal.m_OpenMasks[index];
+      if (m_ClassId >= 0) {
+        candidates &= cal.m_ClassMasks[m_ClassId][weekday];
+      } else if (m_TeacherId >= 0) {
+        candidates &= cal.m_TeacherMasks[m_TeacherId][weekday];
+      }
+    }
+
+    if (candidates != 0) {
+      const auto &entries = cal.m_DayEntries[weekday];
+      for (; m_Index < static_cast<int>(entries.size()); ++m_Index) {
+        const ScheduledLesson &entry = entries[m_Index];
+        if (!cal.Matches(entry, m_ClassId, m_TeacherId)) {
+          continue;
+        }
+        uint32_t open =
+            cal.GetOpenMask(m_DayNumber, entry.classId, entry.teacherId);
+        if ((open >> entry.period) & 1) {
+          m_Current.date      = FromDayNumber(m_DayNumber);
+          m_Current.dayNumber = m_DayNumber;
+          m_Current.lesson    = entry;
+          return;
+        }
+      }
+    }
+
+    ++m_DayNumber;
+    m_Index = 0;
+  }
+  m_Index = 0;
+}
+}; // namespace TimetableWeaver
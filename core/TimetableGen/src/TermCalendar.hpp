@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "Schedule.hpp"
+
+namespace TimetableWeaver
+{
+struct CalendarDate {
+  int year  = 1970;
+  int month = 1;
+  int day   = 1;
+};
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar.
+int          ToDayNumber(const CalendarDate &date);
+CalendarDate FromDayNumber(int dayNumber);
+// 0 = Monday ... 6 = Sunday, matching the schedule's day indices.
+int Weekday(int dayNumber);
+
+enum class CalendarDayKind { Regular, Weekend, Holiday, ExamWeek };
+
+struct LessonOccurrence {
+  CalendarDate    date;
+  int             dayNumber = 0;
+  ScheduledLesson lesson;
+};
+
+// Expands a weekly Schedule into dated lesson instances over a term.
+//
+// Holidays and exam weeks close whole dates; closures close some periods of
+// one date, either for the whole school or for a single class or teacher.
+// Open periods are kept as one uint32 mask per term date, and every week has
+// a bit telling whether it is untouched by exceptions, so range queries
+// count whole weeks with precomputed totals and only walk exceptional weeks
+// date by date. Occurrences are produced lazily by an input iterator.
+class TermCalendar
+{
+public:
+  TermCalendar(const Schedule &schedule, const CalendarDate &first,
+               const CalendarDate &last);
+
+  void AddHoliday(const CalendarDate &first, const CalendarDate &last);
+  void AddExamWeek(const CalendarDate &first, const CalendarDate &last);
+  void AddClosure(const CalendarDate &date, uint32_t periodMask,
+                  int classId = -1, int teacherId = -1);
+
+  CalendarDayKind GetDayKind(const CalendarDate &date) const;
+
+  CalendarDate GetFirstDate() const { return FromDayNumber(m_First); }
+  CalendarDate GetLastDate() const { return FromDayNumber(m_Last); }
+
+  class Iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = LessonOccurrence;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const LessonOccurrence *;
+    using reference         = const LessonOccurrence &;
+
+    reference operator*() const { return m_Current; }
+    pointer   operator->() const { return &m_Current; }
+    Iterator &operator++();
+
+    bool operator==(const Iterator &other) const
+    {
+      return m_DayNumber == other.m_DayNumber && m_Index == other.m_Index;
+    }
+    bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+  private:
+    friend class TermCalendar;
+
+    Iterator(const TermCalendar *calendar, int dayNumber, int lastDay,
+             int classId, int teacherId);
+
+    void Settle();
+
+    const TermCalendar *m_Calendar  = nullptr;
+    int                 m_DayNumber = 0;
+    int                 m_LastDay   = 0;
+    int                 m_Index     = 0;
+    int                 m_ClassId   = -1;
+    int                 m_TeacherId = -1;
+    LessonOccurrence    m_Current;
+  };
+
+  class Range
+  {
+  public:
+    Iterator begin() const { return m_Begin; }
+    Iterator end() const { return m_End; }
+
+  private:
+    friend class TermCalendar;
+    Range(Iterator begin, Iterator end) : m_Begin(begin), m_End(end) {}
+
+    Iterator m_Begin;
+    Iterator m_End;
+  };
+
+  Range GetOccurrences() const;
+  Range GetOccurrences(const CalendarDate &first,
+                       const CalendarDate &last) const;
+  Range GetClassOccurrences(int classId, const CalendarDate &first,
+                            const CalendarDate &last) const;
+  Range GetTeacherOccurrences(int teacherId, const CalendarDate &first,
+                              const CalendarDate &last) const;
+
+  int CountClassLessons(int classId, const CalendarDate &first,
+                        const CalendarDate &last) const;
+  int CountTeacherLessons(int teacherId, const CalendarDate &first,
+                          const CalendarDate &last) const;
+
+private:
+  struct Closure {
+    uint32_t periodMask;
+    int      classId;
+    int      teacherId;
+  };
+
+  Range MakeRange(int classId, int teacherId, const CalendarDate &first,
+                  const CalendarDate &last) const;
+
+  void     CloseDates(int first, int last, CalendarDayKind kind);
+  uint32_t GetOpenMask(int dayNumber, int classId, int teacherId) const;
+  bool     Matches(const ScheduledLesson &lesson, int classId,
+                   int teacherId) const;
+  int      CountLessons(const std::vector<uint32_t> &weekMasks, int weekTotal,
+                        int classId, int teacherId, int first, int last) const;
+
+  int m_First    = 0; // Inclusive day numbers
+  int m_Last     = 0;
+  int m_FirstMon = 0; // Monday of the first week
+  int m_Days     = 0;
+
+  // Schedule entries of each weekday, sorted by period.
+  std::vector<ScheduledLesson> m_DayEntries[7];
+
+  // Per entity, one period mask per weekday. Subgroup lessons of a class
+  // can share a slot; the n-th lesson in a slot sets its bit in the masks
+  // at weekday + 7 * (n - 1), so counting lessons adds up every layer.
+  std::vector<std::vector<uint32_t>> m_ClassMasks;
+  std::vector<std::vector<uint32_t>> m_TeacherMasks;
+  std::vector<int>                   m_ClassWeekTotals;
+  std::vector<int>                   m_TeacherWeekTotals;
+
+  // Per term date, indexed from m_FirstMon.
+  std::vector<uint32_t>        m_OpenMasks;
+  std::vector<CalendarDayKind> m_DayKinds;
+  // One bit per term week; set while the week has no exceptions.
+  std::vector<uint64_t> m_RegularWeeks;
+
+  std::map<int, std::vector<Closure>> m_Closures;
+};
+}; // namespace TimetableWeaver
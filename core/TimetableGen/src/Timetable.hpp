@@ -1,125 +1,53 @@
 #pragma once
 
-#include <string>
-#include <vector>
 #include <iostream>
-#include <cassert>
 #include <memory>
-#include <iomanip>
-#include <map>
-#include <iostream>
 
-#include "ortools/sat/cp_model.h"
+#include "ResultChannel.hpp"
+#include "Schedule.hpp"
+#include "SolverBackend.hpp"
+#include "TimetableConfig.hpp"
 
 namespace TimetableWeaver
 {
-class Availability
-{
-public:
-  Availability(int days, int periods);
-
-  void Set(int day, int period, bool val);
-  void SetDay(int day, bool val);
-
-  void Toggle(int day, int period);
-  void ToggleDay(int day);
-
-  bool     Get(int day, int period) const;
-  uint32_t GetDay(int day) const;
-
-  void Print(std::ostream &stream) const;
-
-private:
-  int                   m_Days;
-  int                   m_PeriodsPerDay;
-  std::vector<uint32_t> m_Buffer;
-};
-
-class Subject
-{
-public:
-  explicit Subject(const std::string &name, const Availability &availability)
-      : m_Name(name), m_Availability(availability) {};
-
-  const std::string  &GetName() const { return m_Name; }
-  const Availability &GetAvailability() const { return m_Availability; }
-
-private:
-  std::string  m_Name;
-  Availability m_Availability;
-};
-
-class Teacher
-{
-public:
-  explicit Teacher(const std::string &name, const Availability &availability)
-      : m_Name(name), m_Availability(availability) {};
-
-  const std::string  &GetName() const { return m_Name; }
-  const Availability &GetAvailability() const { return m_Availability; }
-
-private:
-  std::string  m_Name;
-  Availability m_Availability;
-};
-
-class Class
-{
-public:
-  explicit Class(const std::string &name, const Availability &availability)
-      : m_Name(name), m_Availability(availability) {};
-
-  const std::string  &GetName() const { return m_Name; }
-  const Availability &GetAvailability() const { return m_Availability; }
-
-private:
-  std::string  m_Name;
-  Availability m_Availability;
-};
-
-class Lesson
+class Timetable
 {
 public:
-  explicit Lesson(std::shared_ptr<const Class>   classPtr,
-                  std::shared_ptr<const Teacher> teacherPtr,
-                  std::shared_ptr<const Subject> subjectPtr,
-                  int                            periodsPerWeek);
-
-  std::shared_ptr<const Class>   GetClass() const { return m_Class; }
-  std::shared_ptr<const Teacher> GetTeacher() const { return m_Teacher; }
-  std::shared_ptr<const Subject> GetSubject() const { return m_Subject; }
-  int GetPeriodsPerWeek() const { return m_PeriodsPerWeek; }
+  explicit Timetable(const TimetableConfig &config) : m_Config(config) {};
 
-private:
-  std::shared_ptr<const Class>   m_Class   = nullptr;
-  std::shared_ptr<const Teacher> m_Teacher = nullptr;
-  std::shared_ptr<const Subject> m_Subject = nullptr;
+  // Solves with the given backend; the OR-tools module is loaded on first
+  // use when none was set.
+  void SetBackend(std::shared_ptr<SolverBackend> backend)
+  {
+    m_Backend = std::move(backend);
+  }
 
-  int m_PeriodsPerWeek = 1;
-};
+  // Records the generate phases into `recorder` while it is recording.
+  void SetTraceRecorder(TraceRecorder *recorder) { m_Trace = recorder; }
 
-struct TimetableConfig {
-  std::string name          = "Timetable";
-  int         days          = 5;
-  int         periodsPerDay = 6;
+  // Counts solves and their timings into `metrics`.
+  void SetMetrics(SolverMetrics *metrics) { m_Metrics = metrics; }
 
-  std::vector<Subject>                 subjects;
-  std::vector<Teacher>                 teachers;
-  std::vector<Class>                   classes;
-  std::vector<std::shared_ptr<Lesson>> lessons;
-};
-
-class Timetable
-{
-public:
-  explicit Timetable(const TimetableConfig &config) : m_Config(config) {};
+  // Publishes every improving schedule to `channel` while generating, for
+  // the UI to repaint. The channel must be created for the config's days,
+  // periods and classes. Configs with subgroup lessons are not streamed,
+  // since a channel cell holds one lesson.
+  void SetResultChannel(ResultChannelWriter *channel) { m_Channel = channel; }
 
   bool Generate();
 
+  const TimetableConfig &GetConfig() const { return m_Config; }
+  const Schedule        &GetSchedule() const { return m_Schedule; }
+
   void PrintConfig(std::ostream &stream) const;
-  // void PrintSchedule(std::ostream &stream) const;
+  void PrintSchedule(std::ostream &stream) const;
 
 private:
-  TimetableConfig m_Config;
+  TimetableConfig                m_Config;
+  Schedule                       m_Schedule;
+  std::shared_ptr<SolverBackend> m_Backend;
+  TraceRecorder                 *m_Trace   = nullptr;
+  SolverMetrics                 *m_Metrics = nullptr;
+  ResultChannelWriter           *m_Channel = nullptr;
 };
 }; // namespace TimetableWeaver
\ No newline at end of file
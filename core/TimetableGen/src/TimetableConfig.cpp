@@ -0,0 +1,214 @@
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+
+/**
+ * Availability
+ */
+Availability::Availability(int days, int periods)
+    : m_Days(days), m_PeriodsPerDay(periods)
+{
+  assert(days >= 1 && days <= 7);
+  assert(periods >= 1 && periods <= 32);
+
+  m_Buffer.resize(m_Days, 0);
+}
+
+void Availability::Set(int day, int period, bool val)
+{
+  assert(day >= 0 && day < m_Days);
+  assert(period >= 0 && period < m_PeriodsPerDay);
+
+  unsigned int mask = 1 << period;
+  if (val) {
+    m_Buffer[day] |= mask;
+  } else {
+    m_Buffer[day] &= ~mask;
+  }
+}
+
+void Availability::SetDay(int day, bool val)
+{
+  assert(day >= 0 && day < m_Days);
+
+  if (val) {
+    m_Buffer[day] = (1 << m_PeriodsPerDay) - 1;
+  } else {
+    m_Buffer[day] = 0;
+  }
+}
+
+void Availability::SetDayMask(int day, uint32_t mask)
+{
+  assert(day >= 0 && day < m_Days);
+
+  uint32_t periods = m_PeriodsPerDay >= 32 ? ~0u
+                                           : (1u << m_PeriodsPerDay) - 1;
+  m_Buffer[day]    = mask & periods;
+}
+
+void Availability::ToggleDay(int day)
+{
+  assert(day >= 0 && day < m_Days);
+
+  int mask = (1 << m_PeriodsPerDay) - 1;
+  m_Buffer[day] ^= mask;
+}
+
+void Availability::Toggle(int day, int period)
+{
+  assert(day >= 0 && day < m_Days);
+  assert(period >= 0 && period < m_PeriodsPerDay);
+
+  unsigned int mask = 1 << period;
+  m_Buffer[day] ^= mask;
+}
+
+bool Availability::Get(int day, int period) const
+{
+  assert(day >= 0 && day < m_Days);
+  assert(period >= 0 && period < m_PeriodsPerDay);
+
+  unsigned int mask = 1 << period;
+  return (m_Buffer[day] & mask) != 0;
+}
+
+uint32_t Availability::GetDay(int day) const
+{
+  assert(day >= 0 && day < m_Days);
+  return m_Buffer[day];
+}
+
+void Availability::Print(std::ostream &stream) const
+{
+  for (int day = 0; day < m_Days; day++) {
+    stream << "Day " << day << ": ";
+    for (int period = 0; period < m_PeriodsPerDay; period++) {
+      bool isAvailable = Get(day, period);
+      stream << isAvailable << ' ';
+    }
+    stream << '\n';
+  }
+}
+
+/**
+ * Class
+ */
+int Class::AddPartition(const std::string              &name,
+                        const std::vector<std::string> &groups)
+{
+  assert(groups.size() >= 2);
+  m_Partitions.push_back({name, groups});
+  return static_cast<int>(m_Partitions.size()) - 1;
+}
+
+bool AreSubgroupsCompatible(const Subgroup &a, const Subgroup &b)
+{
+  return !a.IsWholeClass() && a.partition == b.partition &&
+         a.group != b.group;
+}
+
+/**
+ * Lesson
+ */
+[[maybe_unused]] static bool IsValidSubgroup(const Class    &cls,
+                                             const Subgroup &subgroup)
+{
+  if (subgroup.IsWholeClass()) {
+    return true;
+  }
+  const auto &partitions = cls.GetPartitions();
+  return subgroup.partition < static_cast<int>(partitions.size()) &&
+         subgroup.group >= 0 &&
+         subgroup.group <
+             static_cast<int>(partitions[subgroup.partition].groups.size());
+}
+
+Lesson::Lesson(std::shared_ptr<const Class>   classPtr,
+               std::shared_ptr<const Teacher> teacherPtr,
+               std::shared_ptr<const Subject> subjectPtr, int periodsPerWeek,
+               const Subgroup &subgroup)
+    : m_Class(std::move(classPtr)), m_Teacher(std::move(teacherPtr)),
+      m_Subject(std::move(subjectPtr)), m_PeriodsPerWeek(periodsPerWeek),
+      m_Subgroup(subgroup)
+{
+  assert(m_PeriodsPerWeek >= 1);
+  assert(IsValidSubgroup(*m_Class, m_Subgroup));
+}
+
+/**
+ * TimetableConfig
+ */
+template <typename T>
+static int FindEntityId(const std::vector<T> &entities, const std::string &name)
+{
+  for (size_t i = 0; i < entities.size(); ++i) {
+    if (entities[i].GetName() == name) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+int TimetableConfig::FindClass(const std::string &name) const
+{
+  return FindEntityId(classes, name);
+}
+
+int TimetableConfig::FindTeacher(const std::string &name) const
+{
+  return FindEntityId(teachers, name);
+}
+
+int TimetableConfig::FindSubject(const std::string &name) const
+{
+  return FindEntityId(subjects, name);
+}
+
+template <typename T>
+static std::map<std::string, int> MapEntityIds(const std::vector<T> &entities)
+{
+  std::map<std::string, int> ids;
+  for (size_t i = 0; i < entities.size(); ++i) {
+    ids.emplace(entities[i].GetName(), static_cast<int>(i));
+  }
+  return ids;
+}
+
+static int LookUp(const std::map<std::string, int> &ids,
+                  const std::string                &name)
+{
+  const auto it = ids.find(name);
+  return it == ids.end() ? -1 : it->second;
+}
+
+LessonIds TimetableConfig::GetLessonIds() const
+{
+  const auto classIds   = MapEntityIds(classes);
+  const auto teacherIds = MapEntityIds(teachers);
+  const auto subjectIds = MapEntityIds(subjects);
+
+  LessonIds ids;
+  ids.classes.resize(lessons.size());
+  ids.teachers.resize(lessons.size());
+  ids.subjects.resize(lessons.size());
+  for (size_t i = 0; i < lessons.size(); ++i) {
+    const Lesson &lesson = *lessons[i];
+    ids.classes[i]       = LookUp(classIds, lesson.GetClass()->GetName());
+    ids.teachers[i]      = LookUp(teacherIds, lesson.GetTeacher()->GetName());
+    ids.subjects[i]      = LookUp(subjectIds, lesson.GetSubject()->GetName());
+  }
+  return ids;
+}
+
+bool TimetableConfig::HasSubgroupLessons() const
+{
+  for (const auto &lesson : lessons) {
+    if (!lesson->GetSubgroup().IsWholeClass()) {
+      return true;
+    }
+  }
+  return false;
+}
+}; // namespace TimetableWeaver
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <iomanip>
+#include <map>
+#include <iostream>
+
+#include "DailyRules.hpp"
+
+namespace TimetableWeaver
+{
+class Availability
+{
+public:
+  Availability(int days, int periods);
+
+  void Set(int day, int period, bool val);
+  void SetDay(int day, bool val);
+  void SetDayMask(int day, uint32_t mask); // Bit p is period p
+
+  void Toggle(int day, int period);
+  void ToggleDay(int day);
+
+  bool     Get(int day, int period) const;
+  uint32_t GetDay(int day) const;
+
+  void Print(std::ostream &stream) const;
+
+private:
+  int                   m_Days;
+  int                   m_PeriodsPerDay;
+  std::vector<uint32_t> m_Buffer;
+};
+
+class Subject
+{
+public:
+  explicit Subject(const std::string &name, const Availability &availability)
+      : m_Name(name), m_Availability(availability) {};
+
+  const std::string  &GetName() const { return m_Name; }
+  const Availability &GetAvailability() const { return m_Availability; }
+
+private:
+  std::string  m_Name;
+  Availability m_Availability;
+};
+
+class Teacher
+{
+public:
+  explicit Teacher(const std::string &name, const Availability &availability)
+      : m_Name(name), m_Availability(availability) {};
+
+  const std::string  &GetName() const { return m_Name; }
+  const Availability &GetAvailability() const { return m_Availability; }
+
+private:
+  std::string  m_Name;
+  Availability m_Availability;
+};
+
+// A way of splitting a class into groups that meet separately, e.g. lab
+// groups A and B, or one group per foreign language.
+struct SubgroupPartition {
+  std::string              name;
+  std::vector<std::string> groups;
+};
+
+class Class
+{
+public:
+  explicit Class(const std::string &name, const Availability &availability)
+      : m_Name(name), m_Availability(availability) {};
+
+  const std::string  &GetName() const { return m_Name; }
+  const Availability &GetAvailability() const { return m_Availability; }
+
+  // Returns the index of the new partition.
+  int AddPartition(const std::string              &name,
+                   const std::vector<std::string> &groups);
+
+  const std::vector<SubgroupPartition> &GetPartitions() const
+  {
+    return m_Partitions;
+  }
+
+private:
+  std::string                    m_Name;
+  Availability                   m_Availability;
+  std::vector<SubgroupPartition> m_Partitions;
+};
+
+// Part of a class a lesson is taught to: the whole class, or one group of
+// one of its partitions.
+struct Subgroup {
+  int partition = -1; // -1 for the whole class
+  int group     = -1;
+
+  bool IsWholeClass() const { return partition < 0; }
+};
+
+// Lessons of one class may share a slot only when they are taught to
+// different groups of the same partition.
+bool AreSubgroupsCompatible(const Subgroup &a, const Subgroup &b);
+
+class Lesson
+{
+public:
+  explicit Lesson(std::shared_ptr<const Class>   classPtr,
+                  std::shared_ptr<const Teacher> teacherPtr,
+                  std::shared_ptr<const Subject> subjectPtr,
+                  int                            periodsPerWeek,
+                  const Subgroup                &subgroup = Subgroup());
+
+  std::shared_ptr<const Class>   GetClass() const { return m_Class; }
+  std::shared_ptr<const Teacher> GetTeacher() const { return m_Teacher; }
+  std::shared_ptr<const Subject> GetSubject() const { return m_Subject; }
+  int GetPeriodsPerWeek() const { return m_PeriodsPerWeek; }
+  const Subgroup &GetSubgroup() const { return m_Subgroup; }
+
+private:
+  std::shared_ptr<const Class>   m_Class   = nullptr;
+  std::shared_ptr<const Teacher> m_Teacher = nullptr;
+  std::shared_ptr<const Subject> m_Subject = nullptr;
+
+  int      m_PeriodsPerWeek = 1;
+  Subgroup m_Subgroup;
+};
+
+// Config indices of every lesson's class, teacher and subject, -1 where the
+// lesson points at an entity missing from the config.
+struct LessonIds {
+  std::vector<int> classes;
+  std::vector<int> teachers;
+  std::vector<int> subjects;
+};
+
+struct TimetableConfig {
+  std::string name          = "Timetable";
+  int         days          = 5;
+  int         periodsPerDay = 6;
+
+  std::vector<Subject>                 subjects;
+  std::vector<Teacher>                 teachers;
+  std::vector<Class>                   classes;
+  std::vector<std::shared_ptr<Lesson>> lessons;
+  std::vector<DailyRule>               rules;
+  std::vector<SpreadRule>              spreads;
+
+  // Memory cap for model build and solve in MB; 0 disables it.
+  int memoryBudgetMb = 0;
+
+  // Index of the entity with the given name, or -1.
+  int FindClass(const std::string &name) const;
+  int FindTeacher(const std::string &name) const;
+  int FindSubject(const std::string &name) const;
+
+  // Entity indices of all lessons, resolved by name in one pass. Lessons
+  // hold their entities by pointer, so callers that need indices build this
+  // once per solve or edit rather than searching per lesson.
+  LessonIds GetLessonIds() const;
+
+  // True when some lesson targets a subgroup rather than a whole class.
+  bool HasSubgroupLessons() const;
+};
+}; // namespace TimetableWeaver
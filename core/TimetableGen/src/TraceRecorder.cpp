@@ -0,0 +1,299 @@
+#include "TraceRecorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace TimetableWeaver
+{
+static std::atomic<uint64_t> s_NextRecorderSerial{1};
+
+static void WriteJsonString(std::ostream &stream, const std::string &text)
+{
+  stream << '"';
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      stream << "\\\"";
+      break;
+    case '\\':
+      stream << "\\\\";
+      break;
+    case '\n':
+      stream << "\\n";
+      break;
+    case '\t':
+      stream << "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        stream << escaped;
+      } else {
+        stream << c;
+      }
+    }
+  }
+  stream << '"';
+}
+
+// Trace Event timestamps are microseconds; keep nanosecond precision.
+static void WriteMicros(std::ostream &stream, int64_t nanos)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%lld.%03lld",
+                static_cast<long long>(nanos / 1000),
+                static_cast<long long>(nanos % 1000));
+  stream << buffer;
+}
+
+/**
+ * TraceRecorder
+ */
+TraceRecorder::TraceRecorder()
+    : m_Serial(s_NextRecorderSerial.fetch_add(1)),
+      m_Alive(std::make_shared<const bool>(true)),
+      m_Origin(std::chrono::steady_clock::now())
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+  ThreadBuffer *buffer = m_Buffers.load(std::memory_order_acquire);
+  while (buffer != nullptr) {
+    Chunk *chunk = buffer->head;
+    while (chunk != nullptr) {
+      Chunk *next = chunk->next.load(std::memory_order_relaxed);
+      delete chunk;
+      chunk = next;
+    }
+    ThreadBuffer *next = buffer->next.load(std::memory_order_relaxed);
+    delete buffer;
+    buffer = next;
+  }
+}
+
+void TraceRecorder::Start()
+{
+  m_Recording.store(true, std::memory_order_relaxed);
+}
+
+void TraceRecorder::Stop()
+{
+  m_Recording.store(false, std::memory_order_relaxed);
+}
+
+int64_t TraceRecorder::Now() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - m_Origin)
+      .count();
+}
+
+TraceRecorder::ThreadBuffer *TraceRecorder::GetThreadBuffer()
+{
+  struct CacheEntry {
+    uint64_t                  serial;
+    std::weak_ptr<const bool> alive;
+    ThreadBuffer             *buffer;
+  };
+
+  // Recorder serials are never reused, so entries of destroyed recorders
+  // never match again; they are evicted on the next miss.
+  thread_local std::vector<CacheEntry> cache;
+  for (const CacheEntry &entry : cache) {
+    if (entry.serial == m_Serial) {
+      return entry.buffer;
+    }
+  }
+  cache.erase(std::remove_if(cache.begin(), cache.end(),
+                             [](const CacheEntry &entry) {
+                               return entry.alive.expired();
+                             }),
+              cache.end());
+
+  auto *buffer = new ThreadBuffer();
+  buffer->tid  = m_NextTid.fetch_add(1, std::memory_order_relaxed);
+  buffer->head = buffer->tail = new Chunk();
+
+  ThreadBuffer *head = m_Buffers.load(std::memory_order_relaxed);
+  do {
+    buffer->next.store(head, std::memory_order_relaxed);
+  } while (!m_Buffers.compare_exchange_weak(head, buffer,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+
+  cache.push_back({m_Serial, m_Alive, buffer});
+  return buffer;
+}
+
+void TraceRecorder::Append(TraceEvent &&event)
+{
+  ThreadBuffer *buffer = GetThreadBuffer();
+  Chunk        *chunk  = buffer->tail;
+  int           count  = chunk->count.load(std::memory_order_relaxed);
+  if (count == kChunkSize) {
+    auto *next = new Chunk();
+    chunk->next.store(next, std::memory_order_release);
+    buffer->tail = chunk = next;
+    count                = 0;
+  }
+  chunk->events[count] = std::move(event);
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+void TraceRecorder::Complete(std::string name, const char *category,
+                             int64_t start, int64_t end, TraceArgs args)
+{
+  if (!IsRecording()) {
+    return;
+  }
+  TraceEvent event;
+  event.phase    = 'X';
+  event.category = category;
+  event.name     = std::move(name);
+  event.start    = start;
+  event.duration = end - start;
+  event.args     = std::move(args);
+  Append(std::move(event));
+}
+
+void TraceRecorder::Instant(std::string name, const char *category,
+                            TraceArgs args)
+{
+  if (!IsRecording()) {
+    return;
+  }
+  TraceEvent event;
+  event.phase    = 'i';
+  event.category = category;
+  event.name     = std::move(name);
+  event.start    = Now();
+  event.args     = std::move(args);
+  Append(std::move(event));
+}
+
+void TraceRecorder::SetThreadName(const std::string &name)
+{
+  GetThreadBuffer()->threadName = name;
+}
+
+size_t TraceRecorder::GetEventCount() const
+{
+  size_t count = 0;
+  for (ThreadBuffer *buffer = m_Buffers.load(std::memory_order_acquire);
+       buffer != nullptr;
+       buffer = buffer->next.load(std::memory_order_relaxed)) {
+    for (Chunk *chunk = buffer->head; chunk != nullptr;
+         chunk        = chunk->next.load(std::memory_order_acquire)) {
+      count += chunk->count.load(std::memory_order_acquire);
+    }
+  }
+  return count;
+}
+
+void TraceRecorder::WriteJson(std::ostream &stream) const
+{
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  bool first = true;
+  auto separator = [&]() {
+    stream << (first ? "\n" : ",\n");
+    first = false;
+  };
+
+  for (ThreadBuffer *buffer = m_Buffers.load(std::memory_order_acquire);
+       buffer != nullptr;
+       buffer = buffer->next.load(std::memory_order_relaxed)) {
+    if (!buffer->threadName.empty()) {
+      separator();
+      stream << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+             << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+      WriteJsonString(stream, buffer->threadName);
+      stream << "}}";
+    }
+
+    for (Chunk *chunk = buffer->head; chunk != nullptr;
+         chunk        = chunk->next.load(std::memory_order_acquire)) {
+      const int count = chunk->count.load(std::memory_order_acquire);
+      for (int i = 0; i < count; ++i) {
+        const TraceEvent &event = chunk->events[i];
+
+        separator();
+        stream << "{\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":"
+               << buffer->tid << ",\"cat\":";
+        WriteJsonString(stream, event.category);
+        stream << ",\"name\":";
+        WriteJsonString(stream, event.name);
+        stream << ",\"ts\":";
+        WriteMicros(stream, event.start);
+        if (event.phase == 'X') {
+          stream << ",\"dur\":";
+          WriteMicros(stream, event.duration);
+        } else {
+          stream << ",\"s\":\"t\"";
+        }
+        if (!event.args.empty()) {
+          stream << ",\"args\":{";
+          for (size_t a = 0; a < event.args.size(); ++a) {
+            stream << (a == 0 ? "" : ",");
+            WriteJsonString(stream, event.args[a].first);
+            stream << ':';
+            WriteJsonString(stream, event.args[a].second);
+          }
+          stream << '}';
+        }
+        stream << '}';
+      }
+    }
+  }
+  stream << "\n]}\n";
+}
+
+bool TraceRecorder::WriteJson(const std::string &path) const
+{
+  std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+  if (!stream) {
+    std::cerr << "Could not open trace file " << path << "\n";
+    return false;
+  }
+  WriteJson(stream);
+  return static_cast<bool>(stream);
+}
+
+/**
+ * TraceSpan
+ */
+TraceSpan::TraceSpan(TraceRecorder *recorder, std::string name,
+                     const char *category, TraceArgs args)
+{
+  if (recorder == nullptr || !recorder->IsRecording()) {
+    return;
+  }
+  m_Recorder = recorder;
+  m_Name     = std::move(name);
+  m_Category = category;
+  m_Args     = std::move(args);
+  m_Start    = recorder->Now();
+}
+
+TraceSpan::~TraceSpan() { End(); }
+
+void TraceSpan::End()
+{
+  if (m_Recorder != nullptr) {
+    m_Recorder->Complete(std::move(m_Name), m_Category, m_Start,
+                         m_Recorder->Now(), std::move(m_Args));
+    m_Recorder = nullptr;
+  }
+}
+
+void TraceSpan::AddArg(std::string key, std::string value)
+{
+  if (m_Recorder != nullptr) {
+    m_Args.emplace_back(std::move(key), std::move(value));
+  }
+}
+}; // namespace TimetableWeaver
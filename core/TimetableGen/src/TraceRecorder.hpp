@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace TimetableWeaver
+{
+using TraceArgs = std::vector<std::pair<std::string, std::string>>;
+
+struct TraceEvent {
+  char        phase    = 'X'; // 'X' complete span, 'i' instant
+  const char *category = "";  // Must outlive the recorder
+  std::string name;
+  int64_t     start    = 0;   // Nanoseconds since construction
+  int64_t     duration = 0;
+  TraceArgs   args;
+};
+
+// Records a Chrome Trace Event timeline of a solve, viewable in
+// chrome://tracing or Perfetto.
+//
+// Every thread appends to its own buffer of fixed-size chunks, so recording
+// never takes a lock: the owning thread fills a slot and then publishes it
+// by bumping the chunk's count with release ordering. Buffers are linked
+// into the recorder with a CAS on first use. WriteJson walks the published
+// events; call it after the recording threads have finished.
+//
+// A recorder is shared with backend modules by pointer; each module keeps
+// its own thread-local cache, so a thread may own one buffer per module.
+class TraceRecorder
+{
+public:
+  TraceRecorder();
+  ~TraceRecorder();
+
+  TraceRecorder(const TraceRecorder &)            = delete;
+  TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+  // Events are only kept between Start() and Stop(). The clock starts when
+  // the recorder is constructed, so later sessions extend the same timeline.
+  void Start();
+  void Stop();
+  bool IsRecording() const
+  {
+    return m_Recording.load(std::memory_order_relaxed);
+  }
+
+  // Nanoseconds since construction.
+  int64_t Now() const;
+
+  void Complete(std::string name, const char *category, int64_t start,
+                int64_t end, TraceArgs args = {});
+  void Instant(std::string name, const char *category, TraceArgs args = {});
+
+  // Label shown for the calling thread in the viewer.
+  void SetThreadName(const std::string &name);
+
+  size_t GetEventCount() const;
+
+  void WriteJson(std::ostream &stream) const;
+  bool WriteJson(const std::string &path) const;
+
+private:
+  static const int kChunkSize = 1024;
+
+  struct Chunk {
+    TraceEvent          events[kChunkSize];
+    std::atomic<int>    count{0};
+    std::atomic<Chunk *> next{nullptr};
+  };
+
+  struct ThreadBuffer {
+    int                        tid = 0;
+    std::string                threadName;
+    Chunk                     *head = nullptr;
+    Chunk                     *tail = nullptr;
+    std::atomic<ThreadBuffer *> next{nullptr};
+  };
+
+  ThreadBuffer *GetThreadBuffer();
+  void          Append(TraceEvent &&event);
+
+  const uint64_t m_Serial;
+
+  // Expires with the recorder, telling thread-local caches to drop it.
+  const std::shared_ptr<const bool> m_Alive;
+
+  std::atomic<bool>           m_Recording{false};
+  std::atomic<ThreadBuffer *> m_Buffers{nullptr};
+  std::atomic<int>            m_NextTid{1};
+
+  std::chrono::steady_clock::time_point m_Origin;
+};
+
+// Complete event covering the lifetime of the span. A null or stopped
+// recorder makes the span a no-op.
+class TraceSpan
+{
+public:
+  TraceSpan(TraceRecorder *recorder, std::string name, const char *category,
+            TraceArgs args = {});
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan &)            = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+  void AddArg(std::string key, std::string value);
+
+  // Records the span now instead of at destruction.
+  void End();
+
+private:
+  TraceRecorder *m_Recorder = nullptr;
+  std::string    m_Name;
+  const char    *m_Category = "";
+  TraceArgs      m_Args;
+  int64_t        m_Start = 0;
+};
+}; // namespace TimetableWeaver
@@ -0,0 +1,279 @@
+#include "WeeklyPatterns.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "Bits.hpp"
+
+namespace TimetableWeaver
+{
+// Spreads with more blocks than this cannot be placed in one week.
+static const int kMaxBlocks = 16;
+
+/**
+ * PatternPricer
+ */
+PatternPricer::PatternPricer(const TimetableConfig &config, int lesson,
+                             const SpreadRule            *spread,
+                             const std::vector<uint32_t> &pinned)
+    : m_Days(config.days), m_Periods(config.periodsPerDay),
+      m_Weekly(config.lessons[lesson]->GetPeriodsPerWeek()),
+      m_Allowed(config.days, 0), m_Pinned(config.days, 0)
+{
+  const Lesson &entry = *config.lessons[lesson];
+  for (int d = 0; d < m_Days; ++d) {
+    m_Allowed[d] = entry.GetClass()->GetAvailability().GetDay(d) &
+                   entry.GetTeacher()->GetAvailability().GetDay(d);
+    m_Pinned[d] = d < static_cast<int>(pinned.size()) ? pinned[d] : 0;
+  }
+
+  if (spread != nullptr) {
+    m_HasSpread = true;
+    m_Hard      = spread->hard;
+    m_Weight    = std::max(spread->weight, 0);
+    m_MinDayGap = std::max(spread->minDayGap, 1);
+    m_Blocks    = spread->blocks;
+  }
+
+  WeeklyPattern pattern;
+  double        value = 0.0;
+  m_HasPatterns =
+      Price(std::vector<double>(m_Days * m_Periods, 0.0), false, pattern,
+            value);
+}
+
+bool PatternPricer::Price(const std::vector<double> &prices, bool withCosts,
+                          WeeklyPattern &pattern, double &value) const
+{
+  bool found = false;
+  if (!m_HasSpread || !m_Hard) {
+    found = PriceFree(prices, pattern, value);
+    if (found && withCosts) {
+      value += pattern.cost;
+    }
+  }
+  if (m_HasSpread) {
+    WeeklyPattern spread;
+    double        spreadValue = 0.0;
+    if (PriceSpread(prices, spread, spreadValue) &&
+        (!found || spreadValue < value)) {
+      pattern = std::move(spread);
+      value   = spreadValue;
+      found   = true;
+    }
+  }
+  return found;
+}
+
+bool PatternPricer::PriceFree(const std::vector<double> &prices,
+                              WeeklyPattern &pattern, double &value) const
+{
+  pattern.slots.clear();
+  std::vector<std::pair<double, int>> free;
+  for (int d = 0; d < m_Days; ++d) {
+    if ((m_Pinned[d] & ~m_Allowed[d]) != 0) {
+      return false;
+    }
+    for (uint32_t mask = m_Allowed[d]; mask != 0; mask &= mask - 1) {
+      const int period = CountTrailingZeros(mask);
+      const int slot   = d * m_Periods + period;
+      if ((m_Pinned[d] >> period) & 1) {
+        pattern.slots.push_back(slot);
+      } else {
+        free.emplace_back(prices[slot], slot);
+      }
+    }
+  }
+
+  const int missing = m_Weekly - static_cast<int>(pattern.slots.size());
+  if (missing < 0 || missing > static_cast<int>(free.size())) {
+    return false;
+  }
+  std::partial_sort(free.begin(), free.begin() + missing, free.end());
+  for (int i = 0; i < missing; ++i) {
+    pattern.slots.push_back(free[i].second);
+  }
+  std::sort(pattern.slots.begin(), pattern.slots.end());
+
+  value = 0.0;
+  for (int slot : pattern.slots) {
+    value += prices[slot];
+  }
+  pattern.cost = m_HasSpread && !MatchesSpread(pattern.slots) ? m_Weight : 0;
+  return true;
+}
+
+bool PatternPricer::PriceSpread(const std::vector<double> &prices,
+                                WeeklyPattern &pattern, double &value) const
+{
+  const int numBlocks = static_cast<int>(m_Blocks.size());
+  if (numBlocks == 0 || numBlocks > std::min(m_Days, kMaxBlocks) ||
+      std::accumulate(m_Blocks.begin(), m_Blocks.end(), 0) != m_Weekly) {
+    return false;
+  }
+
+  const double kNone = std::numeric_limits<double>::infinity();
+
+  // Cheapest start of every block on every day; the block must fit the
+  // allowed periods and cover the day's pinned ones.
+  std::vector<double> blockPrice(m_Days * numBlocks, kNone);
+  std::vector<int>    blockStart(m_Days * numBlocks, -1);
+  for (int d = 0; d < m_Days; ++d) {
+    for (int b = 0; b < numBlocks; ++b) {
+      const int size = m_Blocks[b];
+      if (size < 1 || size > m_Periods) {
+        continue;
+      }
+      const uint32_t run = size >= 32 ? 0xffffffffu : (1u << size) - 1;
+      for (int start = 0; start + size <= m_Periods; ++start) {
+        const uint32_t block = run << start;
+        if ((block & m_Allowed[d]) != block ||
+            (m_Pinned[d] & ~block) != 0) {
+          continue;
+        }
+        double price = 0.0;
+        for (int p = start; p < start + size; ++p) {
+          price += prices[d * m_Periods + p];
+        }
+        if (price < blockPrice[d * numBlocks + b]) {
+          blockPrice[d * numBlocks + b] = price;
+          blockStart[d * numBlocks + b] = start;
+        }
+      }
+    }
+  }
+
+  // best[d][placed]: cheapest way to put the blocks in `placed` on days
+  // before d, where d is the first day that may take the next block.
+  const int           states = 1 << numBlocks;
+  std::vector<double> best((m_Days + 1) * states, kNone);
+  std::vector<int>    from((m_Days + 1) * states, -1); // Previous state
+  std::vector<int>    via((m_Days + 1) * states, -1);  // Block placed, or -1
+  auto relax = [&](int day, int placed, double price, int previous,
+                   int block) {
+    const int state = day * states + placed;
+    if (price < best[state]) {
+      best[state] = price;
+      from[state] = previous;
+      via[state]  = block;
+    }
+  };
+
+  best[0] = 0.0;
+  for (int d = 0; d < m_Days; ++d) {
+    for (int placed = 0; placed < states; ++placed) {
+      const double price = best[d * states + placed];
+      if (price == kNone) {
+        continue;
+      }
+      if (m_Pinned[d] == 0) {
+        relax(d + 1, placed, price, d * states + placed, -1);
+      }
+
+      // Days skipped to keep the gap must not hold pinned periods.
+      const int next    = std::min(d + m_MinDayGap, m_Days);
+      bool      gapFree = true;
+      for (int g = d + 1; g < next; ++g) {
+        gapFree = gapFree && m_Pinned[g] == 0;
+      }
+      if (!gapFree) {
+        continue;
+      }
+      for (int b = 0; b < numBlocks; ++b) {
+        if ((placed >> b) & 1 || blockStart[d * numBlocks + b] < 0) {
+          continue;
+        }
+        // Equal blocks are interchangeable; place them in order.
+        bool first = true;
+        for (int e = 0; e < b; ++e) {
+          first = first &&
+                  (m_Blocks[e] != m_Blocks[b] || ((placed >> e) & 1) != 0);
+        }
+        if (first) {
+          relax(next, placed | 1 << b, price + blockPrice[d * numBlocks + b],
+                d * states + placed, b);
+        }
+      }
+    }
+  }
+
+  int state = m_Days * states + states - 1;
+  if (best[state] == kNone) {
+    return false;
+  }
+  value = best[state];
+  pattern.slots.clear();
+  pattern.cost = 0;
+  while (from[state] >= 0) {
+    const int previous = from[state];
+    const int block    = via[state];
+    if (block >= 0) {
+      const int day   = previous / states;
+      const int start = blockStart[day * numBlocks + block];
+      for (int p = start; p < start + m_Blocks[block]; ++p) {
+        pattern.slots.push_back(day * m_Periods + p);
+      }
+    }
+    state = previous;
+  }
+  std::sort(pattern.slots.begin(), pattern.slots.end());
+  return true;
+}
+
+bool PatternPricer::MatchesSpread(const std::vector<int> &slots) const
+{
+  std::vector<uint32_t> days(m_Days, 0);
+  for (int slot : slots) {
+    days[slot / m_Periods] |= 1u << (slot % m_Periods);
+  }
+
+  std::vector<int> sizes;
+  int              lastDay = -m_MinDayGap;
+  for (int d = 0; d < m_Days; ++d) {
+    if (days[d] == 0) {
+      continue;
+    }
+    const uint32_t run = days[d] >> CountTrailingZeros(days[d]);
+    if ((run & (run + 1)) != 0 || d - lastDay < m_MinDayGap) {
+      return false; // Not one block, or too close to the previous day
+    }
+    sizes.push_back(PopCount(run));
+    lastDay = d;
+  }
+
+  std::vector<int> blocks = m_Blocks;
+  std::sort(sizes.begin(), sizes.end());
+  std::sort(blocks.begin(), blocks.end());
+  return sizes == blocks;
+}
+
+int PatternPricer::GetCost(const std::vector<int> &slots) const
+{
+  if (static_cast<int>(slots.size()) != m_Weekly) {
+    return -1;
+  }
+  std::vector<uint32_t> used(m_Days, 0);
+  for (int slot : slots) {
+    if (slot < 0 || slot >= m_Days * m_Periods) {
+      return -1;
+    }
+    const int      day = slot / m_Periods;
+    const uint32_t bit = 1u << (slot % m_Periods);
+    if ((m_Allowed[day] & bit) == 0 || (used[day] & bit) != 0) {
+      return -1;
+    }
+    used[day] |= bit;
+  }
+  for (int d = 0; d < m_Days; ++d) {
+    if ((m_Pinned[d] & ~used[d]) != 0) {
+      return -1;
+    }
+  }
+
+  if (!m_HasSpread || MatchesSpread(slots)) {
+    return 0;
+  }
+  return m_Hard ? -1 : m_Weight;
+}
+}; // namespace TimetableWeaver
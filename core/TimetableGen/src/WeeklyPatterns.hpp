@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "TimetableConfig.hpp"
+
+namespace TimetableWeaver
+{
+// One way to place a lesson's whole week.
+struct WeeklyPattern {
+  std::vector<int> slots;    // day * periodsPerDay + period, ascending
+  int              cost = 0; // Penalty of an unmet soft spread
+};
+
+// Pricing step of column generation over weekly patterns: finds the
+// cheapest pattern of one lesson under per-slot prices.
+//
+// Patterns only use slots where both class and teacher are available,
+// contain the lesson's pinned slots, and follow its spread when that is
+// hard. Without a spread any set of allowed slots is a pattern and the
+// cheapest is made of the cheapest slots. With one, a dynamic program over
+// days and the blocks not yet placed puts every block at its cheapest start
+// on days at least the minimum gap apart. Both are exact, so a pattern
+// pool priced out to convergence gives a valid LP bound.
+class PatternPricer
+{
+public:
+  // `spread` may be null; `pinned` holds one period mask per day.
+  PatternPricer(const TimetableConfig &config, int lesson,
+                const SpreadRule *spread, const std::vector<uint32_t> &pinned);
+
+  // False when no pattern fits the lesson at all.
+  bool HasPatterns() const { return m_HasPatterns; }
+
+  // Cheapest pattern for prices indexed by slot. Its value is the sum of
+  // its slot prices plus, when `withCosts`, its cost. False when none fits.
+  bool Price(const std::vector<double> &prices, bool withCosts,
+             WeeklyPattern &pattern, double &value) const;
+
+  // Cost of placing the lesson in `slots`, or -1 when they are not one of
+  // its patterns.
+  int GetCost(const std::vector<int> &slots) const;
+
+private:
+  bool PriceFree(const std::vector<double> &prices, WeeklyPattern &pattern,
+                 double &value) const;
+  bool PriceSpread(const std::vector<double> &prices, WeeklyPattern &pattern,
+                   double &value) const;
+  bool MatchesSpread(const std::vector<int> &slots) const;
+
+  int                   m_Days    = 0;
+  int                   m_Periods = 0;
+  int                   m_Weekly  = 0;
+  std::vector<uint32_t> m_Allowed; // Per day
+  std::vector<uint32_t> m_Pinned;
+
+  bool             m_HasSpread = false;
+  bool             m_Hard      = true;
+  int              m_Weight    = 0;
+  int              m_MinDayGap = 1;
+  std::vector<int> m_Blocks;
+
+  bool m_HasPatterns = false;
+};
+}; // namespace TimetableWeaver